@@ -0,0 +1,476 @@
+/**
+ * compiler benchmarks: parsing, optimisation, and code generation
+ * of a large synthetic script
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "lalr1/collection.h"
+
+#include "compiler/grammar.h"
+#include "compiler/lexer.h"
+#include "compiler/ast.h"
+#include "compiler/ast_asm.h"
+#include "compiler/ast_optimise.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <memory_resource>
+
+#include <malloc.h>
+
+#include <boost/program_options.hpp>
+namespace args = boost::program_options;
+
+
+using namespace lalr1;
+
+
+#if __has_include("compiler_parser.h")
+	#include "compiler_parser.h"
+	#include "compiler_parser.cpp"
+
+	#define USE_RECASC 1
+
+#elif __has_include("compiler.tab")
+	#include "core/parser.h"
+	#include "compiler.tab"
+
+	#define USE_RECASC 0
+
+#elif defined(USE_TABLE_FILE)
+	#include "core/parser.h"
+	#include "compiler/parsetab.h"
+
+	using t_parsetables = ParseTables<t_table, t_vecIdx, t_mapIdIdx, t_mapSemanticIdIdx>;
+
+	static const t_parsetables& get_parse_tables()
+	{
+		static const t_parsetables tables{ COMPILER_TABLE_FILE };
+		return tables;
+	}
+
+	static auto get_lalr1_tables() { return get_parse_tables().GetTables(); }
+	static auto get_lalr1_table_indices() { return get_parse_tables().GetTableIndices(); }
+	static auto get_lalr1_constants() { return get_parse_tables().GetConstants(); }
+
+	#define USE_RECASC 0
+
+#else
+	#define __LALR_NO_PARSER_AVAILABLE
+#endif
+
+
+#ifndef __LALR_NO_PARSER_AVAILABLE
+
+
+using t_clk = std::chrono::steady_clock;
+
+
+enum class BenchMode
+{
+	HEAP,   // allocate every node separately
+	ARENA,  // allocate the nodes of the compilation unit in a memory pool
+};
+
+
+struct BenchResult
+{
+	std::string mode{};
+
+	std::size_t num_tokens{};
+	std::size_t code_size{};   // size of the generated code
+
+	// best run times in seconds
+	double lex_time{};
+	double parse_time{};
+	double opt_time{};         // line numbers, data types, and optimisation
+	double codegen_time{};
+	double free_time{};        // syntax tree destruction
+	double total_time{};
+	double median_time{};      // median total run time
+
+	// heap memory in use after parsing and after optimisation, relative to the start
+	std::size_t parse_mem{};
+	std::size_t opt_mem{};
+};
+
+
+/**
+ * heap memory currently in use, including blocks allocated with mmap
+ */
+static std::size_t get_heap_used()
+{
+	struct mallinfo2 info = ::mallinfo2();
+	return info.uordblks + info.hblkhd;
+}
+
+
+/**
+ * generate a synthetic script with the given number of functions
+ */
+static std::string generate_script(std::size_t num_funcs)
+{
+	std::ostringstream ostr;
+
+	for(std::size_t func = 0; func < num_funcs; ++func)
+	{
+		ostr << "func f" << func << " : int (a : int, b : int)\n"
+			<< "{\n"
+			<< "\ts : int = a * (2 + 3) - b;\n"
+			<< "\tj : int = 0;\n"
+			<< "\tloop(j < a % 7)\n"
+			<< "\t{\n"
+			<< "\t\tif(s > 1000)\n"
+			<< "\t\t{\n"
+			<< "\t\t\ts = s / 2;\n"
+			<< "\t\t}\n"
+			<< "\t\telse\n"
+			<< "\t\t{\n"
+			<< "\t\t\ts = s + j * 4 + 8 / 2 - (1 + 1) * 3;\n"
+			<< "\t\t}\n"
+			<< "\t\tj = j + 1;\n"
+			<< "\t}\n";
+
+		if(func > 0)
+			ostr << "\treturn s + f" << func - 1 << "(b, j);\n";
+		else
+			ostr << "\treturn s;\n";
+
+		ostr << "}\n\n";
+	}
+
+	ostr << "r : int = f" << (num_funcs ? num_funcs - 1 : 0) << "(1, 2);\n"
+		<< "r;\n";
+
+	return ostr.str();
+}
+
+
+/**
+ * compile the script once, timing the individual phases
+ */
+static void compile(const std::string& script, const t_semanticrules& rules,
+	std::pmr::memory_resource* node_mem, BenchResult& result, std::vector<double>& times)
+{
+	const std::size_t start_mem = get_heap_used();
+	auto start_time = t_clk::now();
+
+#if USE_RECASC != 0
+	Compiler parser;
+#else
+	auto [shift_tab, reduce_tab, jump_tab, num_rhs, lhs_idx] = get_lalr1_tables();
+	auto [term_idx, nonterm_idx, semantic_idx] = get_lalr1_table_indices();
+	auto [err_idx, acc_idx, eps_id, end_id, start_idx, acc_rule_idx] = get_lalr1_constants();
+
+	Parser parser;
+	parser.SetShiftTable(shift_tab);
+	parser.SetReduceTable(reduce_tab);
+	parser.SetJumpTable(jump_tab);
+	parser.SetSemanticIdxMap(semantic_idx);
+	parser.SetNumRhsSymsPerRule(num_rhs);
+	parser.SetLhsIndices(lhs_idx);
+	parser.SetEndId(end_id);
+	parser.SetStartingState(start_idx);
+	parser.SetAcceptingRule(acc_rule_idx);
+#endif
+	parser.SetSemanticRules(&rules);
+
+	// lex
+	std::istringstream istr{script};
+	Lexer lexer(&istr);
+#if USE_RECASC == 0
+	lexer.SetTermIdxMap(term_idx);
+#endif
+	lexer.SetEndOnNewline(false);
+	lexer.SetNodeMemory(node_mem);
+	auto tokens = lexer.GetAllTokens();
+	const std::size_t num_tokens = tokens.size();
+	auto lex_time = t_clk::now();
+
+	// parse
+	::t_astbaseptr ast = std::static_pointer_cast<::ASTBase>(parser.Parse(tokens));
+	tokens.clear();
+	auto parse_time = t_clk::now();
+	const std::size_t parse_mem = get_heap_used();
+
+	// optimise
+	ast->AssignLineNumbers();
+	ast->DeriveDataType();
+	std::size_t opt_ctr = 0;
+	ast = ast_optimise(ast, &opt_ctr);
+	auto opt_time = t_clk::now();
+	const std::size_t opt_mem = get_heap_used();
+
+	// generate code
+	ASTAsm astasmbin{&get_default_ops()};
+	ast->accept(&astasmbin);
+	astasmbin.PatchFunctionAddresses();
+	astasmbin.FinishCodegen();
+	std::size_t code_size = astasmbin.GetCode().GetPosition();
+	auto codegen_time = t_clk::now();
+
+	// free the syntax tree
+	ast.reset();
+	auto free_time = t_clk::now();
+
+	using t_dur = std::chrono::duration<double>;
+	const double total = t_dur(free_time - start_time).count();
+	times.push_back(total);
+
+	// the memory use does not depend on the run
+	result.parse_mem = parse_mem > start_mem ? parse_mem - start_mem : 0;
+	result.opt_mem = opt_mem > start_mem ? opt_mem - start_mem : 0;
+
+	if(result.total_time == 0. || total < result.total_time)
+	{
+		result.num_tokens = num_tokens;
+		result.code_size = code_size;
+
+		result.lex_time = t_dur(lex_time - start_time).count();
+		result.parse_time = t_dur(parse_time - lex_time).count();
+		result.opt_time = t_dur(opt_time - parse_time).count();
+		result.codegen_time = t_dur(codegen_time - opt_time).count();
+		result.free_time = t_dur(free_time - codegen_time).count();
+		result.total_time = total;
+	}
+}
+
+
+/**
+ * compile the script repeatedly in all modes,
+ * the modes take turns in alternating order, so that they run under the same conditions
+ */
+static std::vector<BenchResult> run_bench(const std::string& script, std::size_t repetitions)
+{
+	const char* mode_names[] = { "heap", "arena" };
+	const BenchMode modes[] = { BenchMode::HEAP, BenchMode::ARENA };
+	constexpr std::size_t num_modes = std::size(modes);
+
+	std::vector<BenchResult> results;
+	std::vector<std::vector<double>> times(num_modes);
+
+	for(BenchMode mode : modes)
+	{
+		results.emplace_back(BenchResult
+		{
+			.mode = mode_names[static_cast<int>(mode)],
+			.num_tokens = 0,
+			.code_size = 0,
+			.lex_time = 0.,
+			.parse_time = 0.,
+			.opt_time = 0.,
+			.codegen_time = 0.,
+			.free_time = 0.,
+			.total_time = 0.,
+			.median_time = 0.,
+			.parse_mem = 0,
+			.opt_mem = 0,
+		});
+
+		times[static_cast<int>(mode)].reserve(repetitions);
+	}
+
+	for(std::size_t rep = 0; rep < repetitions; ++rep)
+	{
+		for(std::size_t i = 0; i < num_modes; ++i)
+		{
+			const BenchMode mode = modes[rep % 2 ? num_modes - 1 - i : i];
+			const int mode_idx = static_cast<int>(mode);
+
+			std::pmr::monotonic_buffer_resource node_mem;
+			std::pmr::memory_resource *mem = mode == BenchMode::ARENA ? &node_mem : nullptr;
+
+			ScriptGrammar grammar;
+			grammar.SetNodeMemory(mem);
+			grammar.CreateGrammar(false, true);
+
+			compile(script, grammar.GetSemanticRules(), mem, results[mode_idx], times[mode_idx]);
+		}
+	}
+
+	for(std::size_t i = 0; i < num_modes; ++i)
+	{
+		std::sort(times[i].begin(), times[i].end());
+		results[i].median_time = times[i][times[i].size() / 2];
+	}
+
+	return results;
+}
+
+
+/**
+ * writes the benchmark results as json
+ */
+static void write_json(std::ostream& ostr, const std::vector<BenchResult>& results,
+	std::size_t script_size, std::size_t repetitions)
+{
+	ostr << "{\n"
+		<< "\t\"repetitions\": " << repetitions << ",\n"
+		<< "\t\"script_bytes\": " << script_size << ",\n"
+		<< "\t\"results\": [\n";
+
+	for(std::size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult& res = results[i];
+
+		ostr << "\t\t{ "
+			<< "\"mode\": \"" << res.mode << "\", "
+			<< "\"tokens\": " << res.num_tokens << ", "
+			<< "\"code_bytes\": " << res.code_size << ", "
+			<< "\"lex_s\": " << res.lex_time << ", "
+			<< "\"parse_s\": " << res.parse_time << ", "
+			<< "\"optimise_s\": " << res.opt_time << ", "
+			<< "\"codegen_s\": " << res.codegen_time << ", "
+			<< "\"free_s\": " << res.free_time << ", "
+			<< "\"time_s\": " << res.total_time << ", "
+			<< "\"median_time_s\": " << res.median_time << ", "
+			<< "\"parse_mem_bytes\": " << res.parse_mem << ", "
+			<< "\"optimise_mem_bytes\": " << res.opt_mem
+			<< " }";
+
+		if(i + 1 < results.size())
+			ostr << ",";
+		ostr << "\n";
+	}
+
+	ostr << "\t]\n}" << std::endl;
+}
+
+
+/**
+ * writes the benchmark results as a table
+ */
+static void write_table(std::ostream& ostr, const std::vector<BenchResult>& results)
+{
+	ostr << std::left
+		<< std::setw(8) << "Mode"
+		<< std::setw(12) << "Tokens"
+		<< std::setw(12) << "Lex [ms]"
+		<< std::setw(12) << "Parse [ms]"
+		<< std::setw(12) << "Opt [ms]"
+		<< std::setw(12) << "Gen [ms]"
+		<< std::setw(12) << "Free [ms]"
+		<< std::setw(12) << "Total [ms]"
+		<< std::setw(12) << "Median [ms]"
+		<< std::setw(14) << "Parse [kB]"
+		<< std::setw(14) << "Opt [kB]"
+		<< "\n";
+
+	for(const BenchResult& res : results)
+	{
+		ostr << std::left
+			<< std::setw(8) << res.mode
+			<< std::setw(12) << res.num_tokens
+			<< std::setw(12) << res.lex_time * 1e3
+			<< std::setw(12) << res.parse_time * 1e3
+			<< std::setw(12) << res.opt_time * 1e3
+			<< std::setw(12) << res.codegen_time * 1e3
+			<< std::setw(12) << res.free_time * 1e3
+			<< std::setw(12) << res.total_time * 1e3
+			<< std::setw(12) << res.median_time * 1e3
+			<< std::setw(14) << res.parse_mem / 1024
+			<< std::setw(14) << res.opt_mem / 1024
+			<< "\n";
+	}
+
+	ostr.flush();
+}
+
+
+#endif  // __LALR_NO_PARSER_AVAILABLE
+
+
+
+int main(int argc, char** argv)
+{
+#ifdef __LALR_NO_PARSER_AVAILABLE
+	(void)argc; (void)argv;
+	std::cerr << "No parsing tables available, please "
+		"run \"./compilergen\" first and rebuild."
+		<< std::endl;
+	return -1;
+
+#else
+	try
+	{
+		std::ios_base::sync_with_stdio(false);
+
+		// --------------------------------------------------------------------
+		// get program arguments
+		// --------------------------------------------------------------------
+		std::string json_file;
+		std::string script_file;
+		std::size_t repetitions = 10;
+		std::size_t num_funcs = 2000;
+
+		args::options_description arg_descr("Compiler benchmark arguments");
+		arg_descr.add_options()
+			("json,j", args::value<decltype(json_file)>(&json_file), "write results to a json file (\"-\" for stdout)")
+			("reps,r", args::value<decltype(repetitions)>(&repetitions), "number of repetitions per benchmark")
+			("funcs,n", args::value<decltype(num_funcs)>(&num_funcs), "number of functions in the synthetic script")
+			("script,s", args::value<decltype(script_file)>(&script_file), "also write the synthetic script to a file");
+
+		auto argparser = args::command_line_parser{argc, argv};
+		argparser.style(args::command_line_style::default_style);
+		argparser.options(arg_descr);
+
+		args::variables_map mapArgs;
+		auto parsedArgs = argparser.run();
+		args::store(parsedArgs, mapArgs);
+		args::notify(mapArgs);
+
+		repetitions = std::max<std::size_t>(repetitions, 1);
+		// --------------------------------------------------------------------
+
+		const std::string script = generate_script(num_funcs);
+
+		if(script_file != "")
+		{
+			std::ofstream ofstr(script_file);
+			ofstr << script;
+		}
+
+		std::vector<BenchResult> results = run_bench(script, repetitions);
+
+		if(results[0].code_size != results[1].code_size)
+		{
+			std::cerr << "Error: Generated code differs between the benchmark modes."
+				<< std::endl;
+			return -1;
+		}
+
+		if(json_file == "-")
+		{
+			write_json(std::cout, results, script.size(), repetitions);
+		}
+		else
+		{
+			std::cout << "Script: " << num_funcs << " functions, "
+				<< script.size() / 1024 << " kB, "
+				<< results[0].code_size / 1024 << " kB code.\n\n";
+			write_table(std::cout, results);
+
+			if(json_file != "")
+			{
+				std::ofstream ofstr(json_file);
+				write_json(ofstr, results, script.size(), repetitions);
+			}
+		}
+	}
+	catch(const std::exception& err)
+	{
+		std::cerr << "Error: " << err.what() << std::endl;
+		return -1;
+	}
+
+	return 0;
+#endif
+}
@@ -0,0 +1,303 @@
+/**
+ * lexer benchmarks
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "compiler/lexer.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iterator>
+#include <algorithm>
+#include <chrono>
+#include <memory_resource>
+
+#if __has_include(<filesystem>)
+	#include <filesystem>
+	namespace fs = std::filesystem;
+#elif __has_include(<boost/filesystem.hpp>)
+	#include <boost/filesystem.hpp>
+	namespace fs = boost::filesystem;
+#endif
+
+#include <boost/program_options.hpp>
+namespace args = boost::program_options;
+
+
+#ifndef BENCH_SCRIPT_DIR
+	#define BENCH_SCRIPT_DIR "bench"
+#endif
+
+
+/**
+ * lexer with access to the single-token interface
+ */
+class BenchLexer : public Lexer
+{
+public:
+	using Lexer::Lexer;
+	using Lexer::GetNextToken;
+};
+
+
+enum class BenchMode
+{
+	SCAN,          // only scan the tokens
+	NODES,         // create the token nodes for the parser
+	POOLED_NODES,  // create the token nodes in a memory pool
+};
+
+
+struct BenchResult
+{
+	std::string mode{};
+
+	std::size_t input_size{};  // input size in bytes
+	std::size_t num_tokens{};
+	double run_time{};         // best run time in seconds
+	double median_time{};      // median run time in seconds
+};
+
+
+/**
+ * lexes the input repeatedly, either only scanning the tokens
+ * or also creating the token nodes for the parser
+ */
+static BenchResult run_bench(const std::string& input, BenchMode mode, std::size_t repetitions)
+{
+	const char* mode_names[] = { "scan", "tokennodes", "pooled" };
+
+	BenchResult result
+	{
+		.mode = mode_names[static_cast<int>(mode)],
+		.input_size = input.size(),
+		.num_tokens = 0,
+		.run_time = 0.,
+		.median_time = 0.,
+	};
+
+	std::vector<double> times;
+	times.reserve(repetitions);
+
+	for(std::size_t rep = 0; rep < repetitions; ++rep)
+	{
+		std::istringstream istr{input};
+		BenchLexer lexer(&istr);
+		lexer.SetEndOnNewline(false);
+
+		std::pmr::monotonic_buffer_resource node_mem;
+		if(mode == BenchMode::POOLED_NODES)
+			lexer.SetNodeMemory(&node_mem);
+
+		std::size_t num_tokens = 0;
+
+		auto start_time = std::chrono::steady_clock::now();
+		if(mode != BenchMode::SCAN)
+		{
+			num_tokens = lexer.GetAllTokens().size();
+		}
+		else
+		{
+			std::size_t line = 1;
+			while(true)
+			{
+				auto tok = lexer.GetNextToken(&line);
+				++num_tokens;
+
+				if(std::get<0>(tok) == static_cast<t_symbol_id>(Token::END))
+					break;
+			}
+		}
+		auto stop_time = std::chrono::steady_clock::now();
+
+		times.push_back(std::chrono::duration<double>(stop_time - start_time).count());
+		result.num_tokens = num_tokens;
+	}
+
+	std::sort(times.begin(), times.end());
+	result.run_time = times.front();
+	result.median_time = times[times.size() / 2];
+
+	return result;
+}
+
+
+/**
+ * writes the benchmark results as json
+ */
+static void write_json(std::ostream& ostr, const std::vector<BenchResult>& results,
+	std::size_t repetitions)
+{
+	ostr << "{\n"
+		<< "\t\"repetitions\": " << repetitions << ",\n"
+		<< "\t\"results\": [\n";
+
+	for(std::size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult& res = results[i];
+
+		ostr << "\t\t{ "
+			<< "\"mode\": \"" << res.mode << "\", "
+			<< "\"input_bytes\": " << res.input_size << ", "
+			<< "\"tokens\": " << res.num_tokens << ", "
+			<< "\"time_s\": " << res.run_time << ", "
+			<< "\"median_time_s\": " << res.median_time << ", "
+			<< "\"mb_per_s\": " << double(res.input_size) / res.run_time * 1e-6 << ", "
+			<< "\"tokens_per_s\": " << double(res.num_tokens) / res.run_time
+			<< " }";
+
+		if(i + 1 < results.size())
+			ostr << ",";
+		ostr << "\n";
+	}
+
+	ostr << "\t]\n}" << std::endl;
+}
+
+
+/**
+ * writes the benchmark results as a table
+ */
+static void write_table(std::ostream& ostr, const std::vector<BenchResult>& results)
+{
+	ostr << std::left
+		<< std::setw(12) << "Mode"
+		<< std::setw(14) << "Input [kB]"
+		<< std::setw(14) << "Tokens"
+		<< std::setw(14) << "Time [ms]"
+		<< std::setw(14) << "MB/s"
+		<< std::setw(14) << "MTokens/s"
+		<< "\n";
+
+	for(const BenchResult& res : results)
+	{
+		ostr << std::left
+			<< std::setw(12) << res.mode
+			<< std::setw(14) << res.input_size / 1024
+			<< std::setw(14) << res.num_tokens
+			<< std::setw(14) << res.run_time * 1e3
+			<< std::setw(14) << double(res.input_size) / res.run_time * 1e-6
+			<< std::setw(14) << double(res.num_tokens) / res.run_time * 1e-6
+			<< "\n";
+	}
+
+	ostr.flush();
+}
+
+
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		std::ios_base::sync_with_stdio(false);
+
+		// --------------------------------------------------------------------
+		// get program arguments
+		// --------------------------------------------------------------------
+		std::vector<std::string> scripts;
+		std::string json_file;
+		std::size_t repetitions = 5;
+		std::size_t input_size = 4;
+
+		args::options_description arg_descr("Lexer benchmark arguments");
+		arg_descr.add_options()
+			("json,j", args::value<decltype(json_file)>(&json_file), "write results to a json file (\"-\" for stdout)")
+			("reps,r", args::value<decltype(repetitions)>(&repetitions), "number of repetitions per benchmark")
+			("size,s", args::value<decltype(input_size)>(&input_size), "input size in MB, the scripts are repeated to reach it")
+			("script", args::value<decltype(scripts)>(&scripts), "scripts to use as lexer input");
+
+		args::positional_options_description posarg_descr;
+		posarg_descr.add("script", -1);
+
+		auto argparser = args::command_line_parser{argc, argv};
+		argparser.style(args::command_line_style::default_style);
+		argparser.options(arg_descr);
+		argparser.positional(posarg_descr);
+
+		args::variables_map mapArgs;
+		auto parsedArgs = argparser.run();
+		args::store(parsedArgs, mapArgs);
+		args::notify(mapArgs);
+
+		repetitions = std::max<std::size_t>(repetitions, 1);
+
+		// default benchmark corpus
+		if(scripts.size() == 0 && fs::is_directory(BENCH_SCRIPT_DIR))
+		{
+			for(const auto& entry : fs::directory_iterator(BENCH_SCRIPT_DIR))
+			{
+				if(entry.path().extension() == ".scr")
+					scripts.push_back(entry.path().string());
+			}
+			std::sort(scripts.begin(), scripts.end());
+		}
+
+		if(scripts.size() == 0)
+		{
+			std::cerr << "No benchmark scripts found.\n" << std::endl;
+			std::cout << arg_descr << std::endl;
+			return -1;
+		}
+		// --------------------------------------------------------------------
+
+		// concatenate the scripts
+		std::string corpus;
+		for(const std::string& script : scripts)
+		{
+			std::ifstream ifstr(script);
+			if(!ifstr)
+			{
+				std::cerr << "Error: Cannot load \"" << script << "\"." << std::endl;
+				return -1;
+			}
+
+			corpus.append(std::istreambuf_iterator<char>(ifstr), std::istreambuf_iterator<char>());
+			corpus += "\n";
+		}
+
+		// repeat the corpus to get the requested input size
+		std::string input;
+		input.reserve(input_size * 1024 * 1024 + corpus.size());
+		do
+		{
+			input += corpus;
+		}
+		while(input.size() < input_size * 1024 * 1024);
+
+		std::vector<BenchResult> results
+		{
+			run_bench(input, BenchMode::SCAN, repetitions),
+			run_bench(input, BenchMode::NODES, repetitions),
+			run_bench(input, BenchMode::POOLED_NODES, repetitions),
+		};
+
+		if(json_file == "-")
+		{
+			write_json(std::cout, results, repetitions);
+		}
+		else
+		{
+			write_table(std::cout, results);
+
+			if(json_file != "")
+			{
+				std::ofstream ofstr(json_file);
+				write_json(ofstr, results, repetitions);
+			}
+		}
+	}
+	catch(const std::exception& err)
+	{
+		std::cerr << "Error: " << err.what() << std::endl;
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,690 @@
+/**
+ * vm benchmarks
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "vm/vm.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <memory>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if __has_include(<filesystem>)
+	#include <filesystem>
+	namespace fs = std::filesystem;
+#elif __has_include(<boost/filesystem.hpp>)
+	#include <boost/filesystem.hpp>
+	namespace fs = boost::filesystem;
+#endif
+
+#include <boost/program_options.hpp>
+namespace args = boost::program_options;
+
+
+#ifndef BENCH_PROG_DIR
+	#define BENCH_PROG_DIR "bench"
+#endif
+
+
+/**
+ * vm with access to the interrupt service routines
+ */
+class BenchVM : public VM
+{
+public:
+	using VM::VM;
+	using VM::SetISR;
+};
+
+
+/**
+ * vm engine configuration to benchmark
+ */
+struct BenchConfig
+{
+	std::string name{};
+
+	bool checks{true};
+	bool zero_mem{false};
+	bool interrupts{false};    // request interrupts while running
+	bool replay{false};        // record the interrupts of a first run and replay them in the timed runs
+	bool shared_code{false};   // use a code image shared by all vm instances
+	bool instances{false};     // measure the memory of several vm instances
+};
+
+
+struct BenchResult
+{
+	std::string prog{};
+	std::string config{};
+
+	std::size_t prog_size{};
+	std::size_t num_ops{};
+	double run_time{};         // best run time in seconds
+	double median_time{};      // median run time in seconds
+	long max_rss{};            // maximum resident set size of the benchmark process in kB
+
+	// memory per vm instance in kB, with several instances running side by side
+	bool inst_measured{false};
+	long inst_pss{};           // proportional set size, shared pages are split between their users
+	long inst_private{};       // pages not shared with other instances
+};
+
+
+struct BenchOptions
+{
+	t_int mem_size{0x10000};
+	t_int frame_size{0x100};
+	std::size_t repetitions{5};
+	std::size_t instances{16}; // vm instances for the memory measurement
+	std::chrono::microseconds irq_interval{10};
+};
+
+
+/**
+ * loads a compiled program
+ */
+static bool load_prog(const fs::path& prog, std::vector<t_byte>& bytes)
+{
+	std::size_t filesize = fs::file_size(prog);
+	std::ifstream ifstr(prog, std::ios_base::binary);
+	if(!ifstr)
+		return false;
+
+	bytes.resize(filesize);
+	ifstr.read(reinterpret_cast<char*>(bytes.data()), filesize);
+	return !ifstr.fail();
+}
+
+
+/**
+ * gets the proportional set size and the private memory of this process in kB
+ */
+static bool get_process_memory(long& pss, long& priv)
+{
+	std::ifstream ifstr("/proc/self/smaps_rollup");
+	if(!ifstr)
+		return false;
+
+	// the first line is the header of the combined mappings, followed by "key: value kB" lines
+	pss = priv = 0;
+	for(std::string line; std::getline(ifstr, line);)
+	{
+		std::istringstream istrline(line);
+		std::string key;
+		long val = 0;
+		if(!(istrline >> key >> val))
+			continue;
+
+		if(key == "Pss:")
+			pss = val;
+		else if(key == "Private_Clean:" || key == "Private_Dirty:")
+			priv += val;
+	}
+
+	return true;
+}
+
+
+/**
+ * loads the program into a vm, either as private copy or from the shared code image
+ */
+static void load_vm(BenchVM& vm, const std::vector<t_byte>& bytes, const BenchConfig& cfg,
+	const std::shared_ptr<const CodeImage>& code_image)
+{
+	vm.SetChecks(cfg.checks);
+	vm.SetZeroPoppedVals(cfg.zero_mem);
+	if(code_image)
+		vm.SetSharedCode(code_image);
+	else
+		vm.SetMem(0, bytes.data(), bytes.size(), true);
+	vm.SetIP(0);
+}
+
+
+/**
+ * runs the program in several vm instances which are kept alive,
+ * and measures the memory added per instance,
+ * the first instance is not counted, as it includes one-time costs like the shared code image
+ */
+static void measure_instances(const fs::path& prog, const std::vector<t_byte>& bytes,
+	const BenchConfig& cfg, const BenchOptions& opts, BenchResult& result)
+{
+	if(!cfg.instances || opts.instances == 0)
+		return;
+
+	std::shared_ptr<const CodeImage> code_image;
+	if(cfg.shared_code)
+		code_image = CodeImage::Create(bytes.data(), bytes.size(), 0);
+
+	std::vector<std::unique_ptr<BenchVM>> vms;
+	vms.reserve(opts.instances + 1);
+
+	long pss_before = 0, priv_before = 0;
+	for(std::size_t inst = 0; inst < opts.instances + 1; ++inst)
+	{
+		if(inst == 1 && !get_process_memory(pss_before, priv_before))
+			return;
+
+		auto vm = std::make_unique<BenchVM>(opts.mem_size, opts.frame_size);
+		load_vm(*vm, bytes, cfg, code_image);
+		if(!vm->Run())
+			throw std::runtime_error("VM reports failure for \"" + prog.string() + "\".");
+
+		vms.emplace_back(std::move(vm));
+	}
+
+	long pss_after = 0, priv_after = 0;
+	if(!get_process_memory(pss_after, priv_after))
+		return;
+
+	const long num_inst = static_cast<long>(opts.instances);
+	result.inst_measured = true;
+	result.inst_pss = (pss_after - pss_before) / num_inst;
+	result.inst_private = (priv_after - priv_before) / num_inst;
+}
+
+
+/**
+ * registers and memory contents after a run
+ */
+static std::vector<t_int> get_vm_state(const VM& vm, t_int mem_size)
+{
+	std::vector<t_int> state
+	{
+		vm.GetIP(), vm.GetSP(), vm.GetBP(), vm.GetGBP(),
+	};
+
+	state.reserve(state.size() + static_cast<std::size_t>(mem_size));
+	for(t_int addr = 0; addr < mem_size; ++addr)
+		state.push_back(vm.GetMem(addr));
+
+	return state;
+}
+
+
+/**
+ * runs a program repeatedly using the given vm configuration,
+ * when replaying, an untimed first run records the interrupts,
+ * and the timed runs have to end with the same instruction count and state
+ */
+static BenchResult run_bench(const fs::path& prog, const std::vector<t_byte>& bytes,
+	const BenchConfig& cfg, const BenchOptions& opts)
+{
+	BenchResult result
+	{
+		.prog = prog.stem().string(),
+		.config = cfg.name,
+		.prog_size = bytes.size(),
+		.num_ops = 0,
+		.run_time = 0.,
+		.median_time = 0.,
+		.max_rss = 0,
+		.inst_measured = false,
+		.inst_pss = 0,
+		.inst_private = 0,
+	};
+
+	std::vector<double> times;
+	times.reserve(opts.repetitions);
+
+	// trivial interrupt service routine: push 0 arguments and return
+	const t_byte isr[] = { static_cast<t_byte>(OpCode::PUSH), 0, 0, 0, 0,
+		static_cast<t_byte>(OpCode::RET) };
+	const t_int isr_addr = static_cast<t_int>(bytes.size());
+	const t_int irq_num = 1;
+
+	std::shared_ptr<const CodeImage> code_image;
+	if(cfg.shared_code)
+		code_image = CodeImage::Create(bytes.data(), bytes.size(), 0);
+
+	// interrupt log and results of the recorded run
+	const fs::path replay_log = fs::temp_directory_path()
+		/ ("vm_bench_" + std::to_string(::getpid()) + ".rec");
+	std::size_t recorded_ops = 0;
+	std::vector<t_int> recorded_state;
+
+	const std::size_t num_runs = opts.repetitions + (cfg.replay ? 1 : 0);
+	for(std::size_t run = 0; run < num_runs; ++run)
+	{
+		const bool recording = cfg.replay && run == 0;
+		const bool replaying = cfg.replay && run > 0;
+
+		BenchVM vm(opts.mem_size, opts.frame_size);
+		load_vm(vm, bytes, cfg, code_image);
+
+		if(cfg.interrupts)
+		{
+			vm.SetMem(isr_addr, isr, sizeof(isr), true);
+			vm.SetISR(irq_num, isr_addr);
+		}
+
+		if(recording)
+			vm.StartRecording(replay_log.string());
+		else if(replaying)
+			vm.StartReplay(replay_log.string());
+
+		// thread issuing interrupt requests, not needed when replaying
+		std::atomic_bool running{true};
+		std::thread irq_thread;
+		if(cfg.interrupts && !replaying)
+		{
+			irq_thread = std::thread([&vm, &running, &opts, irq_num]()
+			{
+				while(running)
+				{
+					vm.RequestInterrupt(irq_num);
+					std::this_thread::sleep_for(opts.irq_interval);
+				}
+			});
+		}
+
+		auto start_time = std::chrono::steady_clock::now();
+		bool ok = vm.Run();
+		auto stop_time = std::chrono::steady_clock::now();
+
+		running = false;
+		if(irq_thread.joinable())
+			irq_thread.join();
+
+		if(!ok)
+			throw std::runtime_error("VM reports failure for \"" + prog.string() + "\".");
+
+		if(recording)
+		{
+			vm.StopRecording();
+			recorded_ops = vm.GetNumOpsRun();
+			recorded_state = get_vm_state(vm, opts.mem_size);
+			continue;
+		}
+
+		if(replaying)
+		{
+			vm.StopReplay();
+			if(vm.GetNumOpsRun() != recorded_ops
+				|| get_vm_state(vm, opts.mem_size) != recorded_state)
+			{
+				fs::remove(replay_log);
+				throw std::runtime_error("Replayed run of \"" + prog.string()
+					+ "\" differs from the recorded run.");
+			}
+		}
+
+		times.push_back(std::chrono::duration<double>(stop_time - start_time).count());
+		result.num_ops = vm.GetNumOpsRun();
+	}
+
+	if(cfg.replay)
+		fs::remove(replay_log);
+
+	std::sort(times.begin(), times.end());
+	result.run_time = times.front();
+	result.median_time = times[times.size() / 2];
+
+	return result;
+}
+
+
+/**
+ * measured values passed from a child process
+ */
+struct BenchMeasurement
+{
+	std::size_t num_ops{};
+	double run_time{};
+	double median_time{};
+	bool inst_measured{};
+	long inst_pss{};
+	long inst_private{};
+};
+
+
+/**
+ * runs a measurement in a child process,
+ * so that its maximum resident set size is not the one of the previous measurements
+ */
+template<class t_func>
+static bool run_in_process(t_func&& func, BenchMeasurement& meas, long& max_rss)
+{
+	int fds[2]{};
+	if(::pipe(fds) != 0)
+		throw std::runtime_error("Cannot create a pipe for the benchmark process.");
+
+	std::cout.flush();
+	std::cerr.flush();
+	pid_t pid = ::fork();
+	if(pid < 0)
+	{
+		::close(fds[0]);
+		::close(fds[1]);
+		throw std::runtime_error("Cannot create the benchmark process.");
+	}
+
+	// child process
+	if(pid == 0)
+	{
+		::close(fds[0]);
+		int exit_code = 0;
+
+		try
+		{
+			BenchMeasurement child_meas = func();
+			if(::write(fds[1], &child_meas, sizeof(child_meas)) != sizeof(child_meas))
+				exit_code = -1;
+		}
+		catch(const std::exception& err)
+		{
+			std::cerr << "Error: " << err.what() << std::endl;
+			exit_code = -1;
+		}
+
+		::close(fds[1]);
+		::_exit(exit_code);
+	}
+
+	// parent process
+	::close(fds[1]);
+	const bool got_meas = (::read(fds[0], &meas, sizeof(meas)) == sizeof(meas));
+	::close(fds[0]);
+
+	int status = 0;
+	rusage usage{};
+	if(::wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status)
+		|| WEXITSTATUS(status) != 0 || !got_meas)
+		return false;
+
+	max_rss = usage.ru_maxrss;
+	return true;
+}
+
+
+/**
+ * runs the benchmark of a configuration in a child process,
+ * and the memory measurement of several vm instances in another one
+ */
+static BenchResult run_bench_process(const fs::path& prog, const std::vector<t_byte>& bytes,
+	const BenchConfig& cfg, const BenchOptions& opts)
+{
+	const std::string err_msg = "Benchmark of \"" + prog.string()
+		+ "\" with configuration \"" + cfg.name + "\" failed.";
+
+	BenchMeasurement meas{};
+	long max_rss = 0;
+	auto bench_func = [&prog, &bytes, &cfg, &opts]() -> BenchMeasurement
+	{
+		BenchResult result = run_bench(prog, bytes, cfg, opts);
+		return BenchMeasurement
+		{
+			.num_ops = result.num_ops,
+			.run_time = result.run_time,
+			.median_time = result.median_time,
+			.inst_measured = false,
+			.inst_pss = 0,
+			.inst_private = 0,
+		};
+	};
+
+	if(!run_in_process(bench_func, meas, max_rss))
+		throw std::runtime_error(err_msg);
+
+	if(cfg.instances)
+	{
+		long inst_max_rss = 0;
+		auto inst_func = [&prog, &bytes, &cfg, &opts]() -> BenchMeasurement
+		{
+			BenchResult result{};
+			measure_instances(prog, bytes, cfg, opts, result);
+			return BenchMeasurement
+			{
+				.num_ops = 0,
+				.run_time = 0.,
+				.median_time = 0.,
+				.inst_measured = result.inst_measured,
+				.inst_pss = result.inst_pss,
+				.inst_private = result.inst_private,
+			};
+		};
+
+		BenchMeasurement inst_meas{};
+		if(!run_in_process(inst_func, inst_meas, inst_max_rss))
+			throw std::runtime_error(err_msg);
+
+		meas.inst_measured = inst_meas.inst_measured;
+		meas.inst_pss = inst_meas.inst_pss;
+		meas.inst_private = inst_meas.inst_private;
+	}
+
+	return BenchResult
+	{
+		.prog = prog.stem().string(),
+		.config = cfg.name,
+		.prog_size = bytes.size(),
+		.num_ops = meas.num_ops,
+		.run_time = meas.run_time,
+		.median_time = meas.median_time,
+		.max_rss = max_rss,
+		.inst_measured = meas.inst_measured,
+		.inst_pss = meas.inst_pss,
+		.inst_private = meas.inst_private,
+	};
+}
+
+
+/**
+ * writes the benchmark results as json
+ */
+static void write_json(std::ostream& ostr, const std::vector<BenchResult>& results,
+	const BenchOptions& opts)
+{
+	ostr << "{\n"
+		<< "\t\"mem_size\": " << opts.mem_size << ",\n"
+		<< "\t\"frame_size\": " << opts.frame_size << ",\n"
+		<< "\t\"repetitions\": " << opts.repetitions << ",\n"
+		<< "\t\"instances\": " << opts.instances << ",\n"
+		<< "\t\"results\": [\n";
+
+	for(std::size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult& res = results[i];
+
+		ostr << "\t\t{ "
+			<< "\"prog\": \"" << res.prog << "\", "
+			<< "\"config\": \"" << res.config << "\", "
+			<< "\"prog_size\": " << res.prog_size << ", "
+			<< "\"instructions\": " << res.num_ops << ", "
+			<< "\"time_s\": " << res.run_time << ", "
+			<< "\"median_time_s\": " << res.median_time << ", "
+			<< "\"instructions_per_s\": " << double(res.num_ops) / res.run_time << ", "
+			<< "\"ns_per_instruction\": " << res.run_time * 1e9 / double(res.num_ops) << ", "
+			<< "\"max_rss_kb\": " << res.max_rss;
+
+		if(res.inst_measured)
+		{
+			ostr << ", "
+				<< "\"instance_pss_kb\": " << res.inst_pss << ", "
+				<< "\"instance_private_kb\": " << res.inst_private;
+		}
+
+		ostr << " }";
+
+		if(i + 1 < results.size())
+			ostr << ",";
+		ostr << "\n";
+	}
+
+	ostr << "\t]\n}" << std::endl;
+}
+
+
+/**
+ * writes the benchmark results as a table
+ */
+static void write_table(std::ostream& ostr, const std::vector<BenchResult>& results)
+{
+	ostr << std::left
+		<< std::setw(16) << "Program"
+		<< std::setw(12) << "Config"
+		<< std::setw(14) << "Instructions"
+		<< std::setw(14) << "Time [ms]"
+		<< std::setw(14) << "MInstr/s"
+		<< std::setw(14) << "ns/Instr"
+		<< std::setw(14) << "MaxRSS [kB]"
+		<< std::setw(14) << "Pss/VM [kB]"
+		<< std::setw(14) << "Priv/VM [kB]"
+		<< "\n";
+
+	for(const BenchResult& res : results)
+	{
+		ostr << std::left
+			<< std::setw(16) << res.prog
+			<< std::setw(12) << res.config
+			<< std::setw(14) << res.num_ops
+			<< std::setw(14) << res.run_time * 1e3
+			<< std::setw(14) << double(res.num_ops) / res.run_time * 1e-6
+			<< std::setw(14) << res.run_time * 1e9 / double(res.num_ops)
+			<< std::setw(14) << res.max_rss;
+
+		if(res.inst_measured)
+		{
+			ostr << std::setw(14) << res.inst_pss
+				<< std::setw(14) << res.inst_private;
+		}
+		else
+		{
+			ostr << std::setw(14) << "-"
+				<< std::setw(14) << "-";
+		}
+
+		ostr << "\n";
+	}
+
+	ostr.flush();
+}
+
+
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		std::ios_base::sync_with_stdio(false);
+
+		// --------------------------------------------------------------------
+		// get program arguments
+		// --------------------------------------------------------------------
+		std::vector<std::string> progs;
+		std::vector<std::string> configs;
+		std::string json_file;
+		BenchOptions opts;
+
+		args::options_description arg_descr("VM benchmark arguments");
+		arg_descr.add_options()
+			("json,j", args::value<decltype(json_file)>(&json_file), "write results to a json file (\"-\" for stdout)")
+			("reps,r", args::value<decltype(opts.repetitions)>(&opts.repetitions), "number of repetitions per benchmark")
+			("mem,m", args::value<decltype(opts.mem_size)>(&opts.mem_size), "set memory size")
+			("frame,f", args::value<decltype(opts.frame_size)>(&opts.frame_size), "set stack frame size")
+			("instances,i", args::value<decltype(opts.instances)>(&opts.instances), "number of vm instances for the memory measurement")
+			("config,c", args::value<decltype(configs)>(&configs), "only run the given engine configurations")
+			("prog", args::value<decltype(progs)>(&progs), "compiled programs to benchmark");
+
+		args::positional_options_description posarg_descr;
+		posarg_descr.add("prog", -1);
+
+		auto argparser = args::command_line_parser{argc, argv};
+		argparser.style(args::command_line_style::default_style);
+		argparser.options(arg_descr);
+		argparser.positional(posarg_descr);
+
+		args::variables_map mapArgs;
+		auto parsedArgs = argparser.run();
+		args::store(parsedArgs, mapArgs);
+		args::notify(mapArgs);
+
+		opts.repetitions = std::max<std::size_t>(opts.repetitions, 1);
+
+		// default benchmark corpus
+		if(progs.size() == 0 && fs::is_directory(BENCH_PROG_DIR))
+		{
+			for(const auto& entry : fs::directory_iterator(BENCH_PROG_DIR))
+			{
+				if(entry.path().extension() == ".bin")
+					progs.push_back(entry.path().string());
+			}
+			std::sort(progs.begin(), progs.end());
+		}
+
+		if(progs.size() == 0)
+		{
+			std::cerr << "No benchmark programs found.\n" << std::endl;
+			std::cout << arg_descr << std::endl;
+			return -1;
+		}
+		// --------------------------------------------------------------------
+
+		std::vector<BenchConfig> all_configs
+		{
+			{ .name = "default", .checks = true, .zero_mem = false, .interrupts = false, .replay = false, .shared_code = false, .instances = true },
+			{ .name = "nochecks", .checks = false, .zero_mem = false, .interrupts = false, .replay = false, .shared_code = false, .instances = false },
+			{ .name = "zeromem", .checks = true, .zero_mem = true, .interrupts = false, .replay = false, .shared_code = false, .instances = false },
+			{ .name = "irq", .checks = true, .zero_mem = false, .interrupts = true, .replay = false, .shared_code = false, .instances = false },
+			{ .name = "irqreplay", .checks = true, .zero_mem = false, .interrupts = true, .replay = true, .shared_code = false, .instances = false },
+			{ .name = "sharedcode", .checks = true, .zero_mem = false, .interrupts = false, .replay = false, .shared_code = true, .instances = true },
+		};
+
+		std::vector<BenchResult> results;
+
+		for(const std::string& prog : progs)
+		{
+			std::vector<t_byte> bytes;
+			if(!load_prog(prog, bytes))
+			{
+				std::cerr << "Error: Cannot load \"" << prog << "\"." << std::endl;
+				return -1;
+			}
+
+			for(const BenchConfig& cfg : all_configs)
+			{
+				if(configs.size() && std::find(configs.begin(), configs.end(), cfg.name) == configs.end())
+					continue;
+
+				results.emplace_back(run_bench_process(prog, bytes, cfg, opts));
+			}
+		}
+
+		if(json_file == "-")
+		{
+			write_json(std::cout, results, opts);
+		}
+		else
+		{
+			write_table(std::cout, results);
+
+			if(json_file != "")
+			{
+				std::ofstream ofstr(json_file);
+				write_json(ofstr, results, opts);
+			}
+		}
+	}
+	catch(const std::exception& err)
+	{
+		std::cerr << "Error: " << err.what() << std::endl;
+		return -1;
+	}
+
+	return 0;
+}
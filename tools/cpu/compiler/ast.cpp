@@ -18,7 +18,7 @@ void ASTBase::AssignLineNumbers()
 	std::size_t children = NumChildren();
 	for(std::size_t childidx=0; childidx<children; ++childidx)
 	{
-		const t_astbaseptr child = GetChild(childidx);
+		const t_astbaseptr& child = GetChild(childidx);
 		if(!child)
 			continue;
 
@@ -42,7 +42,7 @@ void ASTBase::DeriveDataType()
 	std::size_t children = NumChildren();
 	for(std::size_t childidx=0; childidx<children; ++childidx)
 	{
-		const t_astbaseptr child = GetChild(childidx);
+		const t_astbaseptr& child = GetChild(childidx);
 		if(!child)
 			continue;
 
@@ -59,14 +59,14 @@ void ASTBase::DeriveDataType()
 	{
 		if(children == 1)
 		{
-			const t_astbaseptr child = GetChild(0);
+			const t_astbaseptr& child = GetChild(0);
 			if(child)
 				SetDataType(child->GetDataType());
 		}
 		else if(children == 2)
 		{
-			const t_astbaseptr child1 = GetChild(0);
-			const t_astbaseptr child2 = GetChild(1);
+			const t_astbaseptr& child1 = GetChild(0);
+			const t_astbaseptr& child2 = GetChild(1);
 
 			if(child1 && child2)
 			{
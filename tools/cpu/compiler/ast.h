@@ -10,12 +10,14 @@
 
 #include <memory>
 #include <vector>
+#include <deque>
 #include <utility>
 #include <functional>
 #include <limits>
 #include <optional>
 #include <iostream>
 #include <sstream>
+#include <memory_resource>
 
 #include "lval.h"
 #include "lalr1/ast.h"
@@ -45,6 +47,27 @@ class ASTTypedIdent;
 class ASTAddrOf;
 class ASTDeref;
 
+class ASTArrayDecl;
+class ASTArrayAccess;
+
+
+/**
+ * create a syntax tree node, using the memory pool of the compilation unit if given
+ * the pool has to outlive all nodes, its memory is released at once in its destructor
+ */
+template<class t_node, class ...t_args>
+std::shared_ptr<t_node> make_ast_node(std::pmr::memory_resource* mem, t_args&&... args)
+{
+	if(mem)
+	{
+		return std::allocate_shared<t_node>(
+			std::pmr::polymorphic_allocator<t_node>{mem},
+			std::forward<t_args>(args)...);
+	}
+
+	return std::make_shared<t_node>(std::forward<t_args>(args)...);
+}
+
 
 enum class ASTType
 {
@@ -66,6 +89,9 @@ enum class ASTType
 
 	ADDROF,
 	DEREF,
+
+	ARRAY_DECL,
+	ARRAY_ACCESS,
 };
 
 
@@ -93,6 +119,8 @@ public:
 	virtual void visit(const ASTTypedIdent* ast, std::size_t level) = 0;
 	virtual void visit(const ASTAddrOf* ast, std::size_t level) = 0;
 	virtual void visit(const ASTDeref* ast, std::size_t level) = 0;
+	virtual void visit(const ASTArrayDecl* ast, std::size_t level) = 0;
+	virtual void visit(const ASTArrayAccess* ast, std::size_t level) = 0;
 };
 
 
@@ -120,6 +148,8 @@ public:
 	virtual void visit(ASTTypedIdent* ast, std::size_t level, bool gen_code) = 0;
 	virtual void visit(ASTAddrOf* ast, std::size_t level, bool gen_code) = 0;
 	virtual void visit(ASTDeref* ast, std::size_t level, bool gen_code) = 0;
+	virtual void visit(ASTArrayDecl* ast, std::size_t level, bool gen_code) = 0;
+	virtual void visit(ASTArrayAccess* ast, std::size_t level, bool gen_code) = 0;
 };
 
 
@@ -178,13 +208,18 @@ public:
 	virtual void Optimise() {}
 
 	virtual std::size_t NumChildren() const { return 0; }
-	virtual t_astbaseptr GetChild(std::size_t) const { return nullptr; }
+	virtual const t_astbaseptr& GetChild(std::size_t) const { return s_nochild; }
 	virtual void SetChild(std::size_t, const t_astbaseptr&) { }
 
 	virtual void accept(ASTVisitor* visitor, std::size_t level = 0) const = 0;
 	virtual void accept(ASTMutableVisitor* visitor, std::size_t level = 0, bool gen_code = true) = 0;
 
 
+protected:
+	// returned by reference for non-existing children
+	static inline const t_astbaseptr s_nochild{};
+
+
 private:
 	VMType m_datatype{VMType::UNKNOWN};
 };
@@ -284,9 +319,9 @@ public:
 	std::size_t GetOpId() const { return m_opid; }
 
 	virtual std::size_t NumChildren() const override { return 1; }
-	virtual t_astbaseptr GetChild(std::size_t i) const override
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
 	{
-		return i==0 ? m_arg : nullptr;
+		return i==0 ? m_arg : s_nochild;
 	}
 
 	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
@@ -323,7 +358,7 @@ public:
 
 	virtual std::size_t NumChildren() const override { return 2; }
 
-	virtual t_astbaseptr GetChild(std::size_t i) const override
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
 	{
 		switch(i)
 		{
@@ -331,7 +366,7 @@ public:
 			case 1: return m_arg2;
 		}
 
-		return nullptr;
+		return s_nochild;
 	}
 
 	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
@@ -370,10 +405,10 @@ public:
 		return m_children.size();
 	}
 
-	virtual t_astbaseptr GetChild(std::size_t i) const override
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
 	{
 		if(i >= m_children.size())
-			return nullptr;
+			return s_nochild;
 		return m_children[i];
 	}
 
@@ -392,9 +427,23 @@ public:
 			m_children.push_back(ast);
 	}
 
+	void RemoveChild(std::size_t i)
+	{
+		if(i >= m_children.size())
+			return;
+		m_children.erase(m_children.begin() + i);
+	}
+
+	void InsertChild(std::size_t i, const t_astbaseptr& ast)
+	{
+		if(i > m_children.size())
+			return;
+		m_children.insert(m_children.begin() + i, ast);
+	}
+
 
 private:
-	std::vector<t_astbaseptr> m_children{};
+	std::deque<t_astbaseptr> m_children{};  // deque for fast insertion at the front
 };
 
 
@@ -423,7 +472,7 @@ public:
 
 	virtual std::size_t NumChildren() const override { return m_elseblock ? 3 : 2; }
 
-	virtual t_astbaseptr GetChild(std::size_t i) const override
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
 	{
 		switch(i)
 		{
@@ -432,7 +481,7 @@ public:
 			case 2: return m_elseblock;
 		}
 
-		return nullptr;
+		return s_nochild;
 	}
 
 	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
@@ -445,9 +494,9 @@ public:
 		}
 	}
 
-	t_astbaseptr GetCondition() const { return m_cond; }
-	t_astbaseptr GetIfBlock() const { return m_ifblock; }
-	t_astbaseptr GetElseBlock() const { return m_elseblock; }
+	const t_astbaseptr& GetCondition() const { return m_cond; }
+	const t_astbaseptr& GetIfBlock() const { return m_ifblock; }
+	const t_astbaseptr& GetElseBlock() const { return m_elseblock; }
 
 	void SetCondition(const t_astbaseptr& ast) { m_cond = ast; }
 	void SetIfBlock(const t_astbaseptr& ast) { m_ifblock = ast; }
@@ -478,7 +527,7 @@ public:
 
 	virtual std::size_t NumChildren() const override { return 2; }
 
-	virtual t_astbaseptr GetChild(std::size_t i) const override
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
 	{
 		switch(i)
 		{
@@ -486,7 +535,7 @@ public:
 			case 1: return m_block;
 		}
 
-		return nullptr;
+		return s_nochild;
 	}
 
 	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
@@ -498,8 +547,8 @@ public:
 		}
 	}
 
-	t_astbaseptr GetCondition() const { return m_cond; }
-	t_astbaseptr GetBlock() const { return m_block; }
+	const t_astbaseptr& GetCondition() const { return m_cond; }
+	const t_astbaseptr& GetBlock() const { return m_block; }
 
 	void SetCondition(const t_astbaseptr& ast) { m_cond = ast; }
 	void SetBlock(const t_astbaseptr& ast) { m_block = ast; }
@@ -530,7 +579,7 @@ public:
 
 	virtual std::size_t NumChildren() const override { return 2; }
 
-	virtual t_astbaseptr GetChild(std::size_t i) const override
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
 	{
 		switch(i)
 		{
@@ -538,7 +587,7 @@ public:
 			case 1: return m_block;
 		}
 
-		return nullptr;
+		return s_nochild;
 	}
 
 	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
@@ -550,8 +599,8 @@ public:
 		}
 	}
 
-	t_astbaseptr GetArgs() const { return m_args; }
-	t_astbaseptr GetBlock() const { return m_block; }
+	const t_astbaseptr& GetArgs() const { return m_args; }
+	const t_astbaseptr& GetBlock() const { return m_block; }
 	const std::string& GetName() const { return m_name; }
 
 	void SetArgs(const t_astbaseptr& ast) { m_args = ast; }
@@ -604,14 +653,14 @@ public:
 
 	virtual std::size_t NumChildren() const override { return 1; }
 
-	virtual t_astbaseptr GetChild(std::size_t i) const override
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
 	{
 		switch(i)
 		{
 			case 0: return m_args;
 		}
 
-		return nullptr;
+		return s_nochild;
 	}
 
 	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
@@ -622,7 +671,7 @@ public:
 		}
 	}
 
-	t_astbaseptr GetArgs() const { return m_args; }
+	const t_astbaseptr& GetArgs() const { return m_args; }
 	const std::string& GetName() const { return m_name; }
 
 	void SetArgs(const t_astbaseptr& ast) { m_args = ast; }
@@ -686,14 +735,14 @@ public:
 
 	virtual std::size_t NumChildren() const override { return 1; }
 
-	virtual t_astbaseptr GetChild(std::size_t i) const override
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
 	{
 		switch(i)
 		{
 			case 0: return m_expr;
 		}
 
-		return nullptr;
+		return s_nochild;
 	}
 
 	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
@@ -704,7 +753,7 @@ public:
 		}
 	}
 
-	t_astbaseptr GetExpr() const { return m_expr; }
+	const t_astbaseptr& GetExpr() const { return m_expr; }
 	void SetExpr(const t_astbaseptr& ast) { m_expr = ast; }
 
 
@@ -733,14 +782,14 @@ public:
 
 	virtual std::size_t NumChildren() const override { return 1; }
 
-	virtual t_astbaseptr GetChild(std::size_t i) const override
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
 	{
 		switch(i)
 		{
 			case 0: return m_ident;
 		}
 
-		return nullptr;
+		return s_nochild;
 	}
 
 	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
@@ -751,7 +800,7 @@ public:
 		}
 	}
 
-	t_astbaseptr GetIdent() const { return m_ident; }
+	const t_astbaseptr& GetIdent() const { return m_ident; }
 	void SetIdent(const t_astbaseptr& ast) { m_ident = ast; }
 
 
@@ -811,14 +860,14 @@ public:
 		return 1;
 	}
 
-	virtual t_astbaseptr GetChild(std::size_t i) const override
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
 	{
 		switch(i)
 		{
 			case 0: return m_arg;
 			case 1: return m_expr;
 		}
-		return nullptr;
+		return s_nochild;
 	}
 
 	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
@@ -843,4 +892,133 @@ private:
 };
 
 
+
+/**
+ * node for array declarations, the data type is the one of the elements
+ */
+class ASTArrayDecl : public ASTBaseAcceptor<ASTArrayDecl>
+{
+public:
+	ASTArrayDecl(std::size_t id, std::size_t tableidx,
+		const t_astbaseptr& ident, t_int size)
+		: ASTBaseAcceptor<ASTArrayDecl>{id, tableidx},
+			m_ident{ident}, m_size{size}
+	{}
+
+	virtual ~ASTArrayDecl() = default;
+
+	virtual ASTType GetType() const override { return ASTType::ARRAY_DECL; }
+	virtual VMType GetDataType() const override
+	{
+		return m_ident ? m_ident->GetDataType() : VMType::UNKNOWN;
+	}
+
+	virtual std::size_t NumChildren() const override { return 1; }
+
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
+	{
+		switch(i)
+		{
+			case 0: return m_ident;
+		}
+
+		return s_nochild;
+	}
+
+	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
+	{
+		switch(i)
+		{
+			case 0: m_ident = ast; break;
+		}
+	}
+
+	const t_astbaseptr& GetIdent() const { return m_ident; }
+	t_int GetSize() const { return m_size; }
+
+
+private:
+	t_astbaseptr m_ident{};  // array name
+	t_int m_size{};          // number of elements
+};
+
+
+
+/**
+ * node for reading or writing array elements, the data type is the one of the elements
+ */
+class ASTArrayAccess : public ASTBaseAcceptor<ASTArrayAccess>
+{
+public:
+	using t_range = std::pair<t_int, t_int>;
+
+
+public:
+	ASTArrayAccess(std::size_t id, std::size_t tableidx,
+		const t_astbaseptr& ident, const t_astbaseptr& index,
+		const t_astbaseptr& expr = nullptr)
+		: ASTBaseAcceptor<ASTArrayAccess>{id, tableidx},
+			m_ident{ident}, m_index{index}, m_expr{expr}
+	{}
+
+	virtual ~ASTArrayAccess() = default;
+
+	virtual ASTType GetType() const override { return ASTType::ARRAY_ACCESS; }
+	virtual VMType GetDataType() const override
+	{
+		return m_ident ? m_ident->GetDataType() : VMType::UNKNOWN;
+	}
+
+	virtual std::size_t NumChildren() const override
+	{
+		if(m_expr)
+			return 3;
+		return 2;
+	}
+
+	virtual const t_astbaseptr& GetChild(std::size_t i) const override
+	{
+		switch(i)
+		{
+			case 0: return m_ident;
+			case 1: return m_index;
+			case 2: return m_expr;
+		}
+		return s_nochild;
+	}
+
+	virtual void SetChild(std::size_t i, const t_astbaseptr& ast) override
+	{
+		switch(i)
+		{
+			case 0: m_ident = ast; break;
+			case 1: m_index = ast; break;
+			case 2: m_expr = ast; break;
+		}
+	}
+
+	const t_astbaseptr& GetIdent() const { return m_ident; }
+	const t_astbaseptr& GetIndex() const { return m_index; }
+	const t_astbaseptr& GetExpr() const { return m_expr; }
+
+	bool IsLValue() const
+	{
+		// if there's an rhs expression, this is an lvalue
+		return m_expr.operator bool();
+	}
+
+	// values the index can take, if they are known the bounds check can be skipped
+	const std::optional<t_range>& GetIndexRange() const { return m_index_range; }
+	void SetIndexRange(const std::optional<t_range>& range) { m_index_range = range; }
+
+
+private:
+	t_astbaseptr m_ident{};  // array name
+	t_astbaseptr m_index{};  // element index
+	t_astbaseptr m_expr{};   // rhs in case of assignment
+
+	std::optional<t_range> m_index_range{};
+};
+
+
 #endif
@@ -6,7 +6,10 @@
  */
 
 #include "ast_asm.h"
+#include "lexer.h"
+
 #include <cmath>
+#include <limits>
 
 
 /**
@@ -40,10 +43,239 @@ static void throw_err(const ::ASTBase* ast, const std::string& err)
 }
 
 
-ASTAsm::ASTAsm(std::ostream& ostr,
-	std::unordered_map<std::size_t, std::tuple<std::string, OpCode>> *ops)
-	: m_ostr{&ostr}, m_ops{ops}
+/**
+ * mapping of the operator tokens to their opcodes
+ */
+const t_ops& get_default_ops()
+{
+	static const t_ops ops
+	{{
+		std::make_pair('+', std::make_tuple("add", OpCode::ADD)),
+		std::make_pair('-', std::make_tuple("sub", OpCode::SUB)),
+		std::make_pair('*', std::make_tuple("mul", OpCode::MUL)),
+		std::make_pair('/', std::make_tuple("div", OpCode::DIV)),
+		std::make_pair('%', std::make_tuple("mod", OpCode::MOD)),
+		std::make_pair('^', std::make_tuple("pow", OpCode::POW)),
+
+		std::make_pair('=', std::make_tuple("wrmem", OpCode::WRMEM)),
+
+		std::make_pair('&', std::make_tuple("binand", OpCode::BINAND)),
+		std::make_pair('|', std::make_tuple("binand", OpCode::BINOR)),
+		std::make_pair('~', std::make_tuple("binand", OpCode::BINNOT)),
+
+		std::make_pair('>', std::make_tuple("gt", OpCode::GT)),
+		std::make_pair('<', std::make_tuple("lt", OpCode::LT)),
+		std::make_pair(static_cast<std::size_t>(Token::EQU),
+			std::make_tuple("equ", OpCode::EQU)),
+		std::make_pair(static_cast<std::size_t>(Token::NEQU),
+			std::make_tuple("nequ", OpCode::NEQU)),
+		std::make_pair(static_cast<std::size_t>(Token::GEQU),
+			std::make_tuple("gequ", OpCode::GEQU)),
+		std::make_pair(static_cast<std::size_t>(Token::LEQU),
+			std::make_tuple("lequ", OpCode::LEQU)),
+		std::make_pair(static_cast<std::size_t>(Token::AND),
+			std::make_tuple("and", OpCode::AND)),
+		std::make_pair(static_cast<std::size_t>(Token::OR),
+			std::make_tuple("or", OpCode::OR)),
+		std::make_pair('!', std::make_tuple("not", OpCode::NOT)),
+
+		std::make_pair(static_cast<std::size_t>(Token::BIN_XOR),
+			std::make_tuple("binxor", OpCode::BINXOR)),
+		std::make_pair(static_cast<std::size_t>(Token::SHIFT_LEFT),
+			std::make_tuple("shl", OpCode::SHL)),
+		std::make_pair(static_cast<std::size_t>(Token::SHIFT_RIGHT),
+			std::make_tuple("shr", OpCode::SHR)),
+	}};
+
+	return ops;
+}
+
+
+ASTAsm::ASTAsm(const t_ops *ops)
+	: m_ops{ops ? ops : &get_default_ops()}
+{
+	m_code.BindLabel(m_module_label);
+}
+
+
+/**
+ * get the label of a function, which is created at its first use
+ */
+CodeBuffer::t_label ASTAsm::GetFunctionLabel(const std::string& func_name)
+{
+	if(auto iter = m_func_labels.find(func_name); iter != m_func_labels.end())
+		return iter->second;
+
+	CodeBuffer::t_label label = m_code.NewLabel();
+	m_func_labels.emplace(func_name, label);
+	return label;
+}
+
+
+/**
+ * get the symbol of a variable in the current scope
+ */
+const SymInfo* ASTAsm::GetVariable(const t_str& name) const
+{
+	return m_symtab.GetSymbol(name, m_cur_scope);
+}
+
+
+/**
+ * get the name of a variable including its function for messages
+ */
+t_str ASTAsm::GetScopedName(const t_str& name) const
+{
+	if(m_cur_func != "")
+		return m_cur_func + "/" + name;
+	return name;
+}
+
+
+/**
+ * get the opcode which reads or writes a variable at an offset to its base pointer
+ * @return OpCode::INVALID if the variable has to be accessed via its address
+ */
+OpCode ASTAsm::GetRelativeAccess(const SymInfo* sym, VMType ty, bool write) const
+{
+	if(!sym || sym->is_func)
+		return OpCode::INVALID;
+
+	if(sym->addr < std::numeric_limits<t_offs>::min()
+		|| sym->addr > std::numeric_limits<t_offs>::max())
+		return OpCode::INVALID;
+
+	if(ty == VMType::INT)
+	{
+		if(sym->loc == ADDR_FLAG_BP)
+			return write ? OpCode::WRBP : OpCode::RDBP;
+		if(sym->loc == ADDR_FLAG_GBP)
+			return write ? OpCode::WRGBP : OpCode::RDGBP;
+	}
+	else if(ty == VMType::REAL)
+	{
+		if(sym->loc == ADDR_FLAG_BP)
+			return write ? OpCode::WRBP_R : OpCode::RDBP_R;
+		if(sym->loc == ADDR_FLAG_GBP)
+			return write ? OpCode::WRGBP_R : OpCode::RDGBP_R;
+	}
+
+	return OpCode::INVALID;
+}
+
+
+/**
+ * get the opcode which reads or writes an array element at an offset to its base pointer
+ * @return OpCode::INVALID if the array is out of reach of the offset
+ */
+OpCode ASTAsm::GetIndexedAccess(const SymInfo* sym, VMType ty, bool write) const
+{
+	switch(GetRelativeAccess(sym, ty, write))
+	{
+		case OpCode::RDBP: return OpCode::RDBPIDX;
+		case OpCode::WRBP: return OpCode::WRBPIDX;
+		case OpCode::RDGBP: return OpCode::RDGBPIDX;
+		case OpCode::WRGBP: return OpCode::WRGBPIDX;
+		case OpCode::RDBP_R: return OpCode::RDBPIDX_R;
+		case OpCode::WRBP_R: return OpCode::WRBPIDX_R;
+		case OpCode::RDGBP_R: return OpCode::RDGBPIDX_R;
+		case OpCode::WRGBP_R: return OpCode::WRGBPIDX_R;
+		default: return OpCode::INVALID;
+	}
+}
+
+
+/**
+ * cache the results of the given functions in memo tables with the given number of entries
+ */
+void ASTAsm::SetMemoisation(const std::unordered_set<std::string>& funcs, t_int num_entries)
+{
+	m_memo_funcs = funcs;
+	m_memo_entries = num_entries;
+	if(m_memo_entries <= 0)
+		m_memo_funcs.clear();
+}
+
+
+/**
+ * get the heap size needed by the memo tables
+ */
+t_int ASTAsm::GetMemoSize() const
+{
+	return static_cast<t_int>(m_memo_tables.size()) * m_memo_entries * MEMO_ENTRY_SIZE;
+}
+
+
+/**
+ * look up or store the result of a function in its memo table, using its argument as key
+ */
+void ASTAsm::EmitMemoAccess(const ASTFunc* func, OpCode op)
+{
+	const ASTToken<t_str>* arg = dynamic_cast<const ASTToken<t_str>*>(
+		func->GetArgs()->GetChild(0).get());
+	const SymInfo *sym = m_symtab.GetSymbol(arg->GetLexerValue(), m_symtab.GetId(func->GetName()));
+	m_code.EmitRelative(GetRelativeAccess(sym, VMType::INT, false), static_cast<t_offs>(sym->addr));
+
+	auto [table, inserted] = m_memo_tables.try_emplace(func->GetName(), GetMemoSize());
+	m_code.Emit(op);
+	m_code.EmitValue<t_int>(table->second);
+	m_code.EmitValue<t_int>(m_memo_entries);
+}
+
+
+/**
+ * push the encoded address of a variable,
+ * global addresses are tracked for relocation in object mode
+ */
+void ASTAsm::EmitPushAddress(const SymInfo* sym)
 {
+	if(m_object && sym->loc == ADDR_FLAG_GBP)
+		m_code.EmitPushLabel(m_module_label, sym->addr, ADDR_FLAG_GBP);
+	else
+		m_code.EmitPush(encode_addr<t_int>(sym->addr, sym->loc));
+}
+
+
+/**
+ * evaluate a condition and jump to the label if it has the given truth value,
+ * the operands of logical operations are only evaluated until their result is known
+ */
+void ASTAsm::EmitConditionalJump(ASTBase* cond, bool jump_if,
+	CodeBuffer::t_label label, std::size_t level)
+{
+	if(cond->GetType() == ASTType::BINARY)
+	{
+		std::size_t opid = static_cast<const ASTBinary*>(cond)->GetOpId();
+		bool is_and = (opid == static_cast<std::size_t>(Token::AND));
+		bool is_or = (opid == static_cast<std::size_t>(Token::OR));
+
+		// jump if both operands of an "and" are true or both operands of an "or" are false
+		if((is_and && jump_if) || (is_or && !jump_if))
+		{
+			CodeBuffer::t_label label_skip = m_code.NewLabel();
+			EmitConditionalJump(cond->GetChild(0).get(), !jump_if, label_skip, level+1);
+			EmitConditionalJump(cond->GetChild(1).get(), jump_if, label, level+1);
+			m_code.BindLabel(label_skip);
+			return;
+		}
+
+		// jump if either operand of an "and" is false or either operand of an "or" is true
+		else if(is_and || is_or)
+		{
+			EmitConditionalJump(cond->GetChild(0).get(), jump_if, label, level+1);
+			EmitConditionalJump(cond->GetChild(1).get(), jump_if, label, level+1);
+			return;
+		}
+	}
+	else if(cond->GetType() == ASTType::UNARY
+		&& static_cast<const ASTUnary*>(cond)->GetOpId() == '!')
+	{
+		EmitConditionalJump(cond->GetChild(0).get(), !jump_if, label, level+1);
+		return;
+	}
+
+	cond->accept(this, level, true);
+	m_code.EmitJump(jump_if ? OpCode::JMPCND : OpCode::JMPNCND, label);
 }
 
 
@@ -64,9 +296,7 @@ void ASTAsm::visit(ASTToken<t_real>* ast, [[maybe_unused]] std::size_t level, bo
 		return;
 
 	t_real val = static_cast<t_real>(ast->GetLexerValue());
-
-	m_ostr->put(static_cast<t_byte>(OpCode::PUSH_R));
-	m_ostr->write(reinterpret_cast<const char*>(&val), sizeof(t_real));
+	m_code.EmitPush(val);
 }
 
 
@@ -77,9 +307,7 @@ void ASTAsm::visit(ASTToken<t_int>* ast, [[maybe_unused]] std::size_t level, boo
 	if(!gen_code)
 		return;
 	t_int val = static_cast<t_int>(ast->GetLexerValue());
-
-	m_ostr->put(static_cast<t_byte>(OpCode::PUSH));
-	m_ostr->write(reinterpret_cast<const char*>(&val), sizeof(t_int));
+	m_code.EmitPush(val);
 }
 
 
@@ -93,15 +321,8 @@ void ASTAsm::visit(ASTToken<t_str>* ast, [[maybe_unused]] std::size_t level, boo
 	// the token names a variable identifier
 	if(ast->IsIdent())
 	{
-		t_str varname;
-
-		if(m_cur_func != "")
-			varname = m_cur_func + "/" + val;
-		else
-			varname = val;
-
 		// get variable address and push it
-		const SymInfo *sym = m_symtab.GetSymbol(varname);
+		const SymInfo *sym = GetVariable(val);
 		// symbol not yet seen -> register it
 		if(!sym)
 		{
@@ -111,7 +332,7 @@ void ASTAsm::visit(ASTToken<t_str>* ast, [[maybe_unused]] std::size_t level, boo
 			// in global scope
 			if(m_cur_func == "")
 			{
-				sym = m_symtab.AddSymbol(varname, -m_glob_stack,
+				sym = m_symtab.AddSymbol(val, m_cur_scope, -m_glob_stack,
 					ADDR_FLAG_GBP, symty);
 				m_glob_stack += sym_size;
 			}
@@ -119,32 +340,40 @@ void ASTAsm::visit(ASTToken<t_str>* ast, [[maybe_unused]] std::size_t level, boo
 			// in local function scope
 			else
 			{
-				m_local_stack.try_emplace(m_cur_func, 0);
-				m_local_stack[m_cur_func] += sym_size;
-				sym = m_symtab.AddSymbol(varname, -m_local_stack[m_cur_func],
+				t_int& local_stack = m_local_stack[m_cur_scope];
+				local_stack += sym_size;
+				sym = m_symtab.AddSymbol(val, m_cur_scope, -local_stack,
 					ADDR_FLAG_BP, symty);
 			}
 		}
 		else
 		{
+			if(sym->num_elems)
+				throw_err(ast, "Array \"" + val + "\" can only be accessed by index.");
 			if(ast->GetDataType() == VMType::UNKNOWN)
 				ast->SetDataType(sym->ty);
 		}
 
+		// read the variable directly, assignments write it in the ASTBinary visitor
+		OpCode op = GetRelativeAccess(sym, ast->GetDataType(), ast->IsLValue());
+		if(gen_code && op != OpCode::INVALID)
+		{
+			if(!ast->IsLValue())
+				m_code.EmitRelative(op, static_cast<t_offs>(sym->addr));
+		}
+
 		// push relative address
-		if(gen_code)
+		else if(gen_code)
 		{
-			m_ostr->put(static_cast<t_byte>(OpCode::PUSH));
-			t_int addr = encode_addr<t_int>(sym->addr, sym->loc);
-			m_ostr->write(reinterpret_cast<const char*>(&addr), sizeof(t_int));
+			EmitPushAddress(sym);
 
 			// dereference it, if the variable is on the rhs of an assignment
 			if(!ast->IsLValue() && !sym->is_func)
 			{
 				if(ast->GetDataType() == VMType::INT)
-					m_ostr->put(static_cast<t_byte>(OpCode::RDMEM));
+					m_code.Emit(OpCode::RDMEM);
 				else if(ast->GetDataType() == VMType::REAL)
-					m_ostr->put(static_cast<t_byte>(OpCode::RDMEM_R));
+					m_code.Emit(OpCode::RDMEM_R);
 			}
 		}
 	}
@@ -153,21 +382,13 @@ void ASTAsm::visit(ASTToken<t_str>* ast, [[maybe_unused]] std::size_t level, boo
 	/*else
 	{
 		// get string constant address
-		std::streampos str_addr = m_consttab.AddConst(val);
+		t_int str_addr = static_cast<t_int>(m_consttab.AddConst(val));
 
 		// push string constant address
-		m_ostr->put(static_cast<t_byte>(OpCode::PUSH));
-
-		std::streampos addr_pos = m_ostr->tellp();
-		str_addr -= addr_pos;
-		str_addr -= static_cast<std::streampos>(sizeof(t_int));
-		str_addr = encode_addr<t_int>(str_addr, ADDR_FLAG_IP);
-
-		m_const_addrs.push_back(std::make_tuple(addr_pos, str_addr));
-		m_ostr->write(reinterpret_cast<const char*>(&str_addr), sizeof(t_int));
+		m_code.EmitPushLabel(m_consttab_label, str_addr);
 
 		// dereference string constant address
-		m_ostr->put(static_cast<t_byte>(OpCode::RDMEM));
+		m_code.Emit(OpCode::RDMEM);
 	}*/
 }
 
@@ -209,12 +430,12 @@ void ASTAsm::visit(ASTUnary* ast, [[maybe_unused]] std::size_t level, bool gen_c
 			else
 				throw_err(ast, "Invalid data type in unary expression.");
 		}
-		else
+		else if(op != OpCode::NOT)
 		{
 			throw_err(ast, "Invalid unary expression.");
 		}
 
-		m_ostr->put(static_cast<t_byte>(op));
+		m_code.Emit(op);
 	}
 }
 
@@ -222,54 +443,100 @@ void ASTAsm::visit(ASTUnary* ast, [[maybe_unused]] std::size_t level, bool gen_c
 void ASTAsm::visit(ASTBinary* ast, [[maybe_unused]] std::size_t level, bool gen_code)
 {
 	// run the operands to get the data types
-	for(std::size_t childidx=0; childidx<2; ++childidx)
+	if(!m_operand_types_known)
 	{
-		auto child = ast->GetChild(childidx);
-		child->accept(this, level+1, false);
+		for(std::size_t childidx=0; childidx<2; ++childidx)
+		{
+			const t_astbaseptr& child = ast->GetChild(childidx);
+			child->accept(this, level+1, false);
+		}
 	}
 
 	if(ast->GetDataType() == VMType::UNKNOWN)
 		ast->DeriveDataType();
 
-	if(gen_code)
+	if(!gen_code)
+		return;
+
+	const bool operand_types_known = m_operand_types_known;
+	m_operand_types_known = true;
+	EmitBinary(ast, level);
+	m_operand_types_known = operand_types_known;
+}
+
+
+/**
+ * generate the code of a binary operation whose operands have been visited for their data types
+ */
+void ASTAsm::EmitBinary(ASTBinary* ast, std::size_t level)
+{
+	// logical operations only evaluate their rhs if the lhs does not give the result
+	std::size_t opid = ast->GetOpId();
+	if(opid == static_cast<std::size_t>(Token::AND)
+		|| opid == static_cast<std::size_t>(Token::OR))
 	{
-		std::size_t opid = ast->GetOpId();
-		VMType ty = ast->GetDataType();
+		CodeBuffer::t_label label_false = m_code.NewLabel();
+		CodeBuffer::t_label label_end = m_code.NewLabel();
+
+		EmitConditionalJump(ast, false, label_false, level);
+		m_code.EmitPush(static_cast<t_bool>(1));
+		m_code.EmitJump(OpCode::JMP, label_end);
+		m_code.BindLabel(label_false);
+		m_code.EmitPush(static_cast<t_bool>(0));
+		m_code.BindLabel(label_end);
+		return;
+	}
 
-		// run the operands
-		for(std::size_t childidx=0; childidx<2; ++childidx)
-		{
-			auto child = ast->GetChild(childidx);
-			child->accept(this, level+1, gen_code);
+	VMType ty = ast->GetDataType();
 
-			VMType subty = child->GetDataType();
-			if(subty != ty /*&& opid != '='*/ /* no cast on assignments */)
-			{
-				// child type is different from derived type -> cast
-				if(ty == VMType::INT)
-					m_ostr->put(static_cast<t_byte>(OpCode::FTOI));
-				else if(ty == VMType::REAL)
-					m_ostr->put(static_cast<t_byte>(OpCode::ITOF));
-			}
-		}
+	// run the operands
+	for(std::size_t childidx=0; childidx<2; ++childidx)
+	{
+		const t_astbaseptr& child = ast->GetChild(childidx);
+		child->accept(this, level+1, true);
 
-		// generate the binary operation
-		OpCode op = std::get<OpCode>(m_ops->at(opid));
-		if(op != OpCode::INVALID)	// use opcode directly
+		VMType subty = child->GetDataType();
+		if(subty != ty /*&& opid != '='*/ /* no cast on assignments */)
 		{
+			// child type is different from derived type -> cast
 			if(ty == VMType::INT)
-				m_ostr->put(static_cast<t_byte>(op));
+				m_code.Emit(OpCode::FTOI);
 			else if(ty == VMType::REAL)
-				m_ostr->put(static_cast<t_byte>(
-					convert_vm_opcode_int_to_real(op)));
-			else
-				throw_err(ast, "Invalid data type in binary expression.");
+				m_code.Emit(OpCode::ITOF);
 		}
-		else
+	}
+
+	// write variables directly at their offsets to the base pointers
+	if(opid == '=')
+	{
+		const ASTToken<t_str>* ident = dynamic_cast<const ASTToken<t_str>*>(ast->GetChild(1).get());
+		if(ident && ident->IsIdent())
 		{
-			// TODO: decide on special cases
+			const SymInfo* sym = GetVariable(ident->GetLexerValue());
+			OpCode op = GetRelativeAccess(sym, ident->GetDataType(), true);
+			if(op != OpCode::INVALID)
+			{
+				m_code.EmitRelative(op, static_cast<t_offs>(sym->addr));
+				return;
+			}
 		}
 	}
+
+	// generate the binary operation
+	OpCode op = std::get<OpCode>(m_ops->at(opid));
+	if(op != OpCode::INVALID)	// use opcode directly
+	{
+		if(ty == VMType::INT)
+			m_code.Emit(op);
+		else if(ty == VMType::REAL)
+			m_code.Emit(convert_vm_opcode_int_to_real(op));
+		else
+			throw_err(ast, "Invalid data type in binary expression.");
+	}
+	else
+	{
+		// TODO: decide on special cases
+	}
 }
 
 
@@ -282,161 +549,54 @@ void ASTAsm::visit(ASTList* ast, [[maybe_unused]] std::size_t level, bool gen_co
 
 void ASTAsm::visit(ASTCondition* ast, [[maybe_unused]] std::size_t level, bool gen_code)
 {
-	// condition
-	ast->GetCondition()->accept(this, level+1, gen_code);
-
-	t_int skipEndCond = 0;             // how many bytes to skip to jump to end of the if block?
-	t_int skipEndIf = 0;               // how many bytes to skip to jump to end of the entire if statement?
-	std::streampos skip_addr = 0;      // stream position with the condition jump label
-	std::streampos skip_else_addr = 0; // stream position with the if block jump label
+	CodeBuffer::t_label label_end_if = m_code.NewLabel();   // end of the if block
+	CodeBuffer::t_label label_end_cond = m_code.NewLabel(); // end of the entire if statement
 
+	// if the condition is not fulfilled, skip to the end of the if block
 	if(gen_code)
-	{
-		// if the condition is not fulfilled...
-		m_ostr->put(static_cast<t_byte>(OpCode::NOT));
-
-		// ...skip to the end of the if block
-		m_ostr->put(static_cast<t_byte>(OpCode::PUSH)); // push jump address
-		skip_addr = m_ostr->tellp();
-		skipEndCond = encode_addr<t_int>(skipEndCond, ADDR_FLAG_IP);
-		m_ostr->write(reinterpret_cast<const char*>(&skipEndCond), sizeof(t_int));
-		m_ostr->put(static_cast<t_byte>(OpCode::JMPCND));
-	}
+		EmitConditionalJump(ast->GetCondition().get(), false, label_end_if, level+1);
+	else
+		ast->GetCondition()->accept(this, level+1, gen_code);
 
 	// if block
-	std::streampos before_if_block = m_ostr->tellp();
 	ast->GetIfBlock()->accept(this, level+1, gen_code);
-	if(ast->GetElseBlock() && gen_code)
-	{
-		// skip to end of if statement if there's an else block
-		m_ostr->put(static_cast<t_byte>(OpCode::PUSH)); // push jump address
-		skip_else_addr = m_ostr->tellp();
-		skipEndIf = encode_addr<t_int>(skipEndIf, ADDR_FLAG_IP);
-		m_ostr->write(reinterpret_cast<const char*>(&skipEndIf), sizeof(t_int));
-		m_ostr->put(static_cast<t_byte>(OpCode::JMP));
-	}
-	std::streampos after_if_block = m_ostr->tellp();
 
-	if(gen_code)
-	{
-		// go back and fill in missing number of bytes to skip
-		skipEndCond = after_if_block - before_if_block;
-		m_ostr->seekp(skip_addr);
-		skipEndCond = encode_addr<t_int>(skipEndCond, ADDR_FLAG_IP);
-		m_ostr->write(reinterpret_cast<const char*>(&skipEndCond), sizeof(t_int));
-		m_ostr->seekp(after_if_block);
-	}
+	// skip to end of if statement if there's an else block
+	if(ast->GetElseBlock() && gen_code)
+		m_code.EmitJump(OpCode::JMP, label_end_cond);
+	m_code.BindLabel(label_end_if);
 
 	// else block
 	if(ast->GetElseBlock())
 	{
-		std::streampos before_else_block = m_ostr->tellp();
 		ast->GetElseBlock()->accept(this, level+1, gen_code);
-
-		if(gen_code)
-		{
-			std::streampos after_else_block = m_ostr->tellp();
-
-			// go back and fill in missing number of bytes to skip
-			skipEndIf = after_else_block - before_else_block;
-			m_ostr->seekp(skip_else_addr);
-			skipEndIf = encode_addr<t_int>(skipEndIf, ADDR_FLAG_IP);
-			m_ostr->write(reinterpret_cast<const char*>(&skipEndIf), sizeof(t_int));
-			m_ostr->seekp(after_else_block);
-		}
+		m_code.BindLabel(label_end_cond);
 	}
 }
 
 
 void ASTAsm::visit(ASTLoop* ast, [[maybe_unused]] std::size_t level, bool gen_code)
 {
-	std::size_t labelLoop = m_glob_label++;
-
-	std::ostringstream ostrLabel;
-	ostrLabel << "loop_" << labelLoop;
-	m_cur_loop.push_back(ostrLabel.str());
+	CodeBuffer::t_label label_begin = m_code.NewLabel();
+	CodeBuffer::t_label label_end = m_code.NewLabel();
+	m_cur_loop.emplace_back(std::make_pair(label_begin, label_end));
 
 	// run condition
-	std::streampos loop_begin = m_ostr->tellp();
-	ast->GetCondition()->accept(this, level+1, gen_code); // condition
+	m_code.BindLabel(label_begin);
 
-	t_int skip = 0;  // how many bytes to skip to jump to end of the block?
-	std::streampos skip_addr = 0;
-
-	// if the condition is not fulfilled...
+	// if the condition is not fulfilled, jump to the end
 	if(gen_code)
-	{
-		m_ostr->put(static_cast<t_byte>(OpCode::NOT));
-
-		// ... jump to the end
-		m_ostr->put(static_cast<t_byte>(OpCode::PUSH)); // push jump address
-		skip_addr = m_ostr->tellp();
-		skip = encode_addr<t_int>(skip, ADDR_FLAG_IP);
-		m_ostr->write(reinterpret_cast<const char*>(&skip), sizeof(t_int));
-		m_ostr->put(static_cast<t_byte>(OpCode::JMPCND));
-	}
+		EmitConditionalJump(ast->GetCondition().get(), false, label_end, level+1);
+	else
+		ast->GetCondition()->accept(this, level+1, gen_code);
 
 	// run loop block
-	std::streampos before_block = m_ostr->tellp();
 	ast->GetBlock()->accept(this, level+1, gen_code); // block
 
+	// loop back
 	if(gen_code)
-	{
-		// loop back
-		m_ostr->put(static_cast<t_byte>(OpCode::PUSH)); // push jump address
-		std::streampos after_block = m_ostr->tellp();
-		t_int skip_back = loop_begin - after_block;
-		skip_back -= sizeof(t_int) + 1;
-		skip_back = encode_addr<t_int>(skip_back, ADDR_FLAG_IP);
-		m_ostr->write(reinterpret_cast<const char*>(&skip_back), sizeof(t_int));
-		m_ostr->put(static_cast<t_byte>(OpCode::JMP));
-
-		// go back and fill in missing number of bytes to skip
-		after_block = m_ostr->tellp();
-		skip = after_block - before_block;
-		skip = encode_addr<t_int>(skip, ADDR_FLAG_IP);
-		m_ostr->seekp(skip_addr);
-		m_ostr->write(reinterpret_cast<const char*>(&skip), sizeof(t_int));
-
-		// fill in any saved, unset start-of-loop jump addresses (continues)
-		while(true)
-		{
-			auto iter = m_loop_begin_comefroms.find(ostrLabel.str());
-			if(iter == m_loop_begin_comefroms.end())
-				break;
-
-			std::streampos pos = iter->second;
-			m_loop_begin_comefroms.erase(iter);
-
-			t_int to_skip = loop_begin - pos;
-			// already skipped over address and jmp instruction
-			to_skip -= sizeof(t_int);
-			to_skip = encode_addr<t_int>(to_skip, ADDR_FLAG_IP);
-			m_ostr->seekp(pos);
-			m_ostr->write(reinterpret_cast<const char*>(&to_skip), sizeof(t_int));
-		}
-
-		// fill in any saved, unset end-of-loop jump addresses (breaks)
-		while(true)
-		{
-			auto iter = m_loop_end_comefroms.find(ostrLabel.str());
-			if(iter == m_loop_end_comefroms.end())
-				break;
-
-			std::streampos pos = iter->second;
-			m_loop_end_comefroms.erase(iter);
-
-			t_int to_skip = after_block - pos;
-			// already skipped over address and jmp instruction
-			to_skip -= sizeof(t_int);
-			to_skip = encode_addr<t_int>(to_skip, ADDR_FLAG_IP);
-			m_ostr->seekp(pos);
-			m_ostr->write(reinterpret_cast<const char*>(&to_skip), sizeof(t_int));
-		}
-
-		// go to end of stream
-		m_ostr->seekp(after_block);
-	}
+		m_code.EmitJump(OpCode::JMP, label_begin);
+	m_code.BindLabel(label_end);
 
 	m_cur_loop.pop_back();
 }
@@ -450,6 +610,7 @@ void ASTAsm::visit(ASTFunc* ast, [[maybe_unused]] std::size_t level, bool gen_co
 	// function name
 	const std::string& func_name = ast->GetName();
 	m_cur_func = func_name;
+	m_cur_scope = m_symtab.GetId(func_name);
 	m_cur_rettype = ast->GetDataType();
 
 	//std::cout << "entered function " << m_cur_func
@@ -459,18 +620,12 @@ void ASTAsm::visit(ASTFunc* ast, [[maybe_unused]] std::size_t level, bool gen_co
 	// number of function arguments
 	t_int num_args = static_cast<t_int>(ast->NumArgs());
 
-	std::streampos jmp_end_streampos;
-	t_int end_func_addr = 0;
+	CodeBuffer::t_label label_end_func = m_code.NewLabel();
+	m_cur_ret = m_code.NewLabel();
 
+	// jump to the end of the function to prevent accidental execution
 	if(gen_code)
-	{
-		// jump to the end of the function to prevent accidental execution
-		m_ostr->put(static_cast<t_byte>(OpCode::PUSH)); // push jump address
-		jmp_end_streampos = m_ostr->tellp();
-		end_func_addr = encode_addr<t_int>(end_func_addr, ADDR_FLAG_IP);
-		m_ostr->write(reinterpret_cast<const char*>(&end_func_addr), sizeof(t_int));
-		m_ostr->put(static_cast<t_byte>(OpCode::JMP));
-	}
+		m_code.EmitJump(OpCode::JMP, label_end_func);
 
 
 	// function arguments
@@ -480,54 +635,48 @@ void ASTAsm::visit(ASTFunc* ast, [[maybe_unused]] std::size_t level, bool gen_co
 		{
 			auto ident = std::dynamic_pointer_cast<ASTToken<t_str>>(ast->GetArgs()->GetChild(i));
 			const t_str& argname = ident->GetLexerValue();
-			t_str varname = m_cur_func + "/" + argname;
 
 			VMType argty = ident->GetDataType();
-			m_symtab.AddSymbol(varname, (i+2)*get_vm_type_size(argty), ADDR_FLAG_BP, argty);
+			m_symtab.AddSymbol(argname, m_cur_scope,
+				(i+2)*get_vm_type_size(argty), ADDR_FLAG_BP, argty);
 		}
 	}
 
 
-	std::streampos before_block = m_ostr->tellp();
-	//std::cout << "function \"" << func_name << "\" at start address " << before_block << std::endl;
+	m_code.BindLabel(GetFunctionLabel(func_name));
 
-	// add function to symbol table
-	m_symtab.AddSymbol(func_name, before_block, ADDR_FLAG_MEM, VMType::UNKNOWN, true, num_args);
+	// add function to symbol table, its final address is set in FinishCodegen()
+	m_symtab.AddSymbol(func_name, SymTab::GLOBAL_SCOPE, static_cast<t_int>(m_code.GetPosition()),
+		ADDR_FLAG_MEM, VMType::UNKNOWN, true, num_args);
+
+	// return a cached result without running the function
+	const bool memoised = gen_code && m_memo_funcs.contains(func_name);
+	CodeBuffer::t_label label_memo_hit = m_code.NewLabel();
+	if(memoised)
+	{
+		EmitMemoAccess(ast, OpCode::MEMOGET);
+		m_code.EmitJump(OpCode::JMPCND, label_memo_hit);
+	}
 
 	ast->GetBlock()->accept(this, level+1, gen_code); // block
 
 
 	if(gen_code)
 	{
-		std::streampos ret_streampos = m_ostr->tellp();
+		// cache the result
+		m_code.BindLabel(m_cur_ret);
+		if(memoised)
+			EmitMemoAccess(ast, OpCode::MEMOSET);
 
 		// push number of arguments and return
-		m_ostr->put(static_cast<t_byte>(OpCode::PUSH));
-		m_ostr->write(reinterpret_cast<const char*>(&num_args), sizeof(t_int));
-		m_ostr->put(static_cast<t_byte>(OpCode::RET));
-
-		// fill in end-of-function jump address
-		std::streampos end_func_streampos = m_ostr->tellp();
-		end_func_addr = end_func_streampos - before_block;
-		end_func_addr = encode_addr<t_int>(end_func_addr, ADDR_FLAG_IP);
-		m_ostr->seekp(jmp_end_streampos);
-		m_ostr->write(reinterpret_cast<const char*>(&end_func_addr), sizeof(t_int));
-
-		// fill in any saved, unset end-of-function jump addresses
-		for(std::streampos pos : m_endfunc_comefroms)
-		{
-			t_int to_skip = ret_streampos - pos;
-			// already skipped over address and jmp instruction
-			to_skip -= sizeof(t_int) + 1;
-			to_skip = encode_addr<t_int>(to_skip, ADDR_FLAG_IP);
-			m_ostr->seekp(pos);
-			m_ostr->write(reinterpret_cast<const char*>(&to_skip), sizeof(t_int));
-		}
-		m_endfunc_comefroms.clear();
-		m_ostr->seekp(end_func_streampos);
+		m_code.BindLabel(label_memo_hit);
+		m_code.EmitPush(num_args);
+		m_code.Emit(OpCode::RET);
 	}
+	m_code.BindLabel(label_end_func);
 
 	m_cur_func = "";
+	m_cur_scope = SymTab::GLOBAL_SCOPE;
 	m_cur_rettype = VMType::UNKNOWN;
 	m_cur_loop.clear();
 }
@@ -545,13 +694,9 @@ void ASTAsm::visit(ASTFuncCall* ast, [[maybe_unused]] std::size_t level, bool ge
 	// call internal function
 	// get function address and push it
 	const SymInfo *sym = m_symtab.GetSymbol(func_name);
-	t_int func_addr = 0;
 	if(sym)
 	{
-		// function address already known
-		func_addr = sym->addr;
-		//std::cout << "calling function \"" << func_name << "\" at address " << func_addr << std::endl;
-
+		// function already known
 		if(num_args != sym->num_args)
 		{
 			std::ostringstream msg;
@@ -564,22 +709,14 @@ void ASTAsm::visit(ASTFuncCall* ast, [[maybe_unused]] std::size_t level, bool ge
 	if(gen_code)
 	{
 		// push relative function address
-		m_ostr->put(static_cast<t_byte>(OpCode::PUSH));
-
-		// already skipped over address and jmp instruction
-		std::streampos addr_pos = m_ostr->tellp();
-		t_int to_skip = static_cast<t_int>(func_addr - addr_pos);
-		to_skip -= sizeof(t_int) + 1;
-		to_skip = encode_addr<t_int>(to_skip, ADDR_FLAG_IP);
-		m_ostr->write(reinterpret_cast<const char*>(&to_skip), sizeof(t_int));
-
-		m_ostr->put(static_cast<t_byte>(OpCode::CALL));
+		m_code.EmitPushLabel(GetFunctionLabel(func_name));
+		m_code.Emit(OpCode::CALL);
 
 		if(!sym)
 		{
-			// function address not yet known
+			// function not yet known
 			m_func_comefroms.emplace_back(
-				std::make_tuple(func_name, addr_pos, num_args, ast));
+				std::make_tuple(func_name, num_args, ast));
 		}
 	}
 }
@@ -610,18 +747,13 @@ void ASTAsm::visit(ASTJump* ast, [[maybe_unused]] std::size_t level, bool gen_co
 			{
 				// cast if data types are different
 				if(m_cur_rettype == VMType::INT && expr_type == VMType::REAL)
-					m_ostr->put(static_cast<t_byte>(OpCode::FTOI));
+					m_code.Emit(OpCode::FTOI);
 				else if(m_cur_rettype == VMType::REAL && expr_type == VMType::INT)
-					m_ostr->put(static_cast<t_byte>(OpCode::ITOF));
+					m_code.Emit(OpCode::ITOF);
 			}
 
 			// jump to the end of the function
-			m_ostr->put(static_cast<t_byte>(OpCode::PUSH)); // push jump address
-			m_endfunc_comefroms.push_back(m_ostr->tellp());
-			t_int dummy_addr = 0;
-			dummy_addr = encode_addr<t_int>(dummy_addr, ADDR_FLAG_IP);
-			m_ostr->write(reinterpret_cast<const char*>(&dummy_addr), sizeof(t_int));
-			m_ostr->put(static_cast<t_byte>(OpCode::JMP));
+			m_code.EmitJump(OpCode::JMP, m_cur_ret);
 		}
 	}
 	else if(ast->GetJumpType() == ASTJump::JumpType::BREAK
@@ -649,18 +781,13 @@ void ASTAsm::visit(ASTJump* ast, [[maybe_unused]] std::size_t level, bool gen_co
 
 		if(gen_code)
 		{
-			const std::string& cur_loop = *(m_cur_loop.rbegin() + loop_depth);
+			const auto& [label_begin, label_end] = *(m_cur_loop.rbegin() + loop_depth);
 
 			// jump to the beginning (continue) or end (break) of the loop
-			m_ostr->put(static_cast<t_byte>(OpCode::PUSH)); // push jump address
 			if(ast->GetJumpType() == ASTJump::JumpType::BREAK)
-				m_loop_end_comefroms.insert(std::make_pair(cur_loop, m_ostr->tellp()));
+				m_code.EmitJump(OpCode::JMP, label_end);
 			else if(ast->GetJumpType() == ASTJump::JumpType::CONTINUE)
-				m_loop_begin_comefroms.insert(std::make_pair(cur_loop, m_ostr->tellp()));
-			t_int dummy_addr = 0;
-			dummy_addr = encode_addr<t_int>(dummy_addr, ADDR_FLAG_IP);
-			m_ostr->write(reinterpret_cast<const char*>(&dummy_addr), sizeof(t_int));
-			m_ostr->put(static_cast<t_byte>(OpCode::JMP));
+				m_code.EmitJump(OpCode::JMP, label_begin);
 		}
 	}
 }
@@ -681,25 +808,24 @@ void ASTAsm::visit(
  */
 void ASTAsm::visit(ASTAddrOf* ast, [[maybe_unused]] std::size_t level, bool gen_code)
 {
-	t_str varname = ast->GetName();
-	if(m_cur_func != "")
-		varname = m_cur_func + "/" + varname;
+	const t_str& varname = ast->GetName();
 
 	// get variable address and push it
-	const SymInfo *sym = m_symtab.GetSymbol(varname);
+	const SymInfo *sym = GetVariable(varname);
 	if(!sym)
 	{
 		throw_err(ast,
 			"Tried to get address of unknown variable \""
-			+ varname + "\".");
+			+ GetScopedName(varname) + "\".");
 	}
 
-	// push relative address
+	// push relative variable or absolute function address
 	if(gen_code)
 	{
-		m_ostr->put(static_cast<t_byte>(OpCode::PUSH));
-		t_int addr = encode_addr<t_int>(sym->addr, sym->loc);
-		m_ostr->write(reinterpret_cast<const char*>(&addr), sizeof(t_int));
+		if(sym->is_func)
+			m_code.EmitPushLabel(GetFunctionLabel(varname), 0, ADDR_FLAG_MEM);
+		else
+			EmitPushAddress(sym);
 	}
 }
 
@@ -724,35 +850,157 @@ void ASTAsm::visit(ASTDeref* ast, [[maybe_unused]] std::size_t level, bool gen_c
 		if(!ast->IsLValue())
 		{
 			// dereference the address, if it is on the rhs of an assignment
-			m_ostr->put(static_cast<t_byte>(OpCode::RDMEM));
+			m_code.Emit(OpCode::RDMEM);
 
 			// TODO: real type
-			//m_ostr->put(static_cast<t_byte>(OpCode::RDMEM_R));
+			//m_code.Emit(OpCode::RDMEM_R);
 
 			// TODO: functions
 		}
 		else
 		{
 			// write to the address, if it is on the lhs of an assignment
-			m_ostr->put(static_cast<t_byte>(OpCode::WRMEM));
+			m_code.Emit(OpCode::WRMEM);
 
 			// TODO: real type
-			//m_ostr->put(static_cast<t_byte>(OpCode::WRMEM_R));
+			//m_code.Emit(OpCode::WRMEM_R);
+		}
+	}
+}
+
+
+/**
+ * reserve the memory of an array in the global or local variable stack
+ */
+void ASTAsm::visit(ASTArrayDecl* ast, [[maybe_unused]] std::size_t level, [[maybe_unused]] bool gen_code)
+{
+	const ASTToken<t_str>* ident = dynamic_cast<const ASTToken<t_str>*>(ast->GetIdent().get());
+	if(!ident)
+		throw_err(ast, "Expected an array name.");
+
+	const t_str& varname = ident->GetLexerValue();
+
+	VMType ty = ast->GetDataType();
+	t_int num_elems = ast->GetSize();
+	if(num_elems <= 0)
+		throw_err(ast, "Invalid size of array \"" + GetScopedName(varname) + "\".");
+
+	// the declaration can be repeated, e.g. in loops
+	if(const SymInfo *sym = GetVariable(varname); sym)
+	{
+		if(sym->ty != ty || sym->num_elems != num_elems)
+		{
+			throw_err(ast, "Symbol \"" + GetScopedName(varname)
+				+ "\" is already declared with another type or size.");
+		}
+		return;
+	}
+
+	// the elements are stored at ascending addresses
+	t_int elem_size = get_vm_type_size(ty);
+	t_int size = num_elems * elem_size;
+
+	// in global scope
+	if(m_cur_func == "")
+	{
+		m_symtab.AddSymbol(varname, m_cur_scope, -(m_glob_stack + size - elem_size),
+			ADDR_FLAG_GBP, ty, false, 0, num_elems);
+		m_glob_stack += size;
+	}
+
+	// in local function scope
+	else
+	{
+		t_int& local_stack = m_local_stack[m_cur_scope];
+		local_stack += size;
+		m_symtab.AddSymbol(varname, m_cur_scope, -local_stack,
+			ADDR_FLAG_BP, ty, false, 0, num_elems);
+	}
+}
+
+
+/**
+ * read or write an array element
+ */
+void ASTAsm::visit(ASTArrayAccess* ast, [[maybe_unused]] std::size_t level, bool gen_code)
+{
+	ASTToken<t_str>* ident = dynamic_cast<ASTToken<t_str>*>(ast->GetIdent().get());
+	if(!ident || !ident->IsIdent())
+		throw_err(ast, "Expected an array name.");
+
+	const SymInfo *sym = GetVariable(ident->GetLexerValue());
+	if(!sym || !sym->num_elems)
+		throw_err(ast, "\"" + ident->GetLexerValue() + "\" is not a known array.");
+	ident->SetDataType(sym->ty);
+
+	// run the rhs expression if it exists
+	if(ast->IsLValue())
+	{
+		const t_astbaseptr& expr = ast->GetExpr();
+		expr->accept(this, level+1, gen_code);
+
+		if(gen_code && expr->GetDataType() != sym->ty)
+		{
+			if(sym->ty == VMType::INT)
+				m_code.Emit(OpCode::FTOI);
+			else if(sym->ty == VMType::REAL)
+				m_code.Emit(OpCode::ITOF);
 		}
 	}
+
+	// run the index expression
+	const t_astbaseptr& index = ast->GetIndex();
+	index->accept(this, level+1, gen_code);
+	if(index->GetDataType() == VMType::UNKNOWN)
+		index->DeriveDataType();
+
+	if(!gen_code)
+		return;
+
+	if(index->GetDataType() == VMType::REAL)
+		m_code.Emit(OpCode::FTOI);
+
+	// check the index if it is not known to be in range
+	std::optional<ASTArrayAccess::t_range> range = ast->GetIndexRange();
+	if(const ASTToken<t_int>* literal = dynamic_cast<const ASTToken<t_int>*>(index.get()); literal)
+	{
+		t_int idx = literal->GetLexerValue();
+		if(idx < 0 || idx >= sym->num_elems)
+		{
+			throw_err(ast, "Index " + std::to_string(idx) + " is out of the bounds of array \""
+				+ ident->GetLexerValue() + "\".");
+		}
+		range = std::make_pair(idx, idx);
+	}
+
+	if(!range || range->first < 0 || range->second >= sym->num_elems)
+	{
+		m_code.Emit(OpCode::CHKIDX);
+		m_code.EmitValue<t_int>(sym->num_elems);
+	}
+
+	OpCode op = GetIndexedAccess(sym, sym->ty, ast->IsLValue());
+	if(op == OpCode::INVALID)
+		throw_err(ast, "Array \"" + ident->GetLexerValue() + "\" is out of reach of the base pointer.");
+	m_code.EmitRelative(op, static_cast<t_offs>(sym->addr));
 }
 
 
 /**
- * fill in function addresses for calls
+ * check the calls to functions which were not yet known at the time of the call,
+ * their addresses are filled in by FinishCodegen()
  */
 void ASTAsm::PatchFunctionAddresses()
 {
-	for(const auto& [func_name, pos, num_args, call_ast] : m_func_comefroms)
+	for(const auto& [func_name, num_args, call_ast] : m_func_comefroms)
 	{
 		const SymInfo *sym = m_symtab.GetSymbol(func_name);
 		if(!sym)
 		{
+			// function in another module
+			if(m_object)
+				continue;
+
 			throw_err(call_ast,
 				"Tried to call unknown function \"" + func_name + "\".");
 		}
@@ -764,46 +1012,124 @@ void ASTAsm::PatchFunctionAddresses()
 				<< " arguments, but " << num_args << " were given.";
 			throw_err(call_ast, msg.str());
 		}
-
-		m_ostr->seekp(pos);
-
-		// write relative function address
-		t_int to_skip = sym->addr - pos;
-		// already skipped over address and jmp instruction
-		to_skip -= sizeof(t_int) + 1;
-		m_ostr->write(reinterpret_cast<const char*>(&to_skip), sizeof(t_int));
 	}
-
-	// seek to end of stream
-	m_ostr->seekp(0, std::ios_base::end);
 }
 
 
 void ASTAsm::FinishCodegen()
 {
-	// add a final halt instruction
-	m_ostr->put(static_cast<t_byte>(OpCode::HALT));
+	// add a final halt instruction or continue with the next module
+	if(m_object)
+	{
+		m_code.EmitPushLabel(GetFunctionLabel(OBJ_NEXT_MODULE));
+		m_code.Emit(OpCode::JMP);
+	}
+	else
+	{
+		m_code.Emit(OpCode::HALT);
+	}
+	m_code.BindLabel(m_consttab_label);
+
+	if(m_optimise)
+		m_code.Optimise();
+
+	// resolve all jump, function, and constant addresses
+	m_code.Finish(m_object);
+
+	// set the final function addresses in the symbol table
+	for(const auto& [func_name, label] : m_func_labels)
+	{
+		const SymInfo *sym = m_symtab.GetSymbol(func_name);
+		if(!sym || !sym->is_func)
+			continue;
+
+		m_symtab.AddSymbol(func_name, SymTab::GLOBAL_SCOPE, m_code.GetLabelAddress(label),
+			sym->loc, sym->ty, true, sym->num_args);
+	}
 
 	// write constants block
-	std::streampos consttab_pos = m_ostr->tellp();
 	if(auto [constsize, constbytes] = m_consttab.GetBytes(); constsize && constbytes)
 	{
-		m_ostr->write((char*)constbytes.get(), constsize);
+		m_code.Append(constbytes.get(), static_cast<std::size_t>(constsize));
 	}
+}
 
-	// patch in the addresses of the constants
-	for(auto [addr_pos, const_addr] : m_const_addrs)
+
+/**
+ * get the relocatable module, valid after FinishCodegen() in object mode
+ */
+ObjFile ASTAsm::CreateObject() const
+{
+	ObjFile obj
 	{
-		t_int addr = const_addr;
+		.code = m_code.GetCode(),
+		.glob_size = m_glob_stack,
+		.heap_size = GetMemoSize(),
+		.funcs = {},
+		.relocs = {},
+	};
+
+	// exported functions and the names of the called ones
+	std::unordered_map<CodeBuffer::t_label, std::string> label_names;
+	for(const auto& [func_name, label] : m_func_labels)
+	{
+		label_names.emplace(label, func_name);
+
+		const SymInfo *sym = m_symtab.GetSymbol(func_name);
+		if(!sym || !sym->is_func || !m_code.IsLabelBound(label))
+			continue;
 
-		// add address offset to constants table
-		addr += consttab_pos;
+		obj.funcs.emplace_back(ObjSymbol
+		{
+			.name = func_name,
+			.addr = sym->addr,
+			.num_args = sym->num_args,
+		});
+	}
 
-		// write new address
-		m_ostr->seekp(addr_pos);
-		m_ostr->write(reinterpret_cast<const char*>(&addr), sizeof(t_int));
+	// number of arguments of the calls to other modules
+	std::unordered_map<std::string, t_int> num_call_args;
+	for(const auto& [func_name, num_args, call_ast] : m_func_comefroms)
+		num_call_args.emplace(func_name, num_args);
+
+	for(const CodeBuffer::LabelRef& ref : m_code.GetLabelRefs())
+	{
+		ObjReloc reloc
+		{
+			.ty = RelocType::FUNC,
+			.pos = static_cast<t_int>(ref.pos),
+			.name = "",
+			.offs = ref.offs,
+			.flags = ref.flags,
+			.num_args = -1,
+		};
+
+		if(!m_code.IsLabelBound(ref.label))
+		{
+			// function in another module
+			reloc.name = label_names.at(ref.label);
+			if(auto iter = num_call_args.find(reloc.name); iter != num_call_args.end())
+				reloc.num_args = iter->second;
+		}
+		else if(ref.flags == ADDR_FLAG_MEM)
+		{
+			reloc.ty = RelocType::CODE_ADDR;
+		}
+		else if(ref.flags == ADDR_FLAG_GBP)
+		{
+			reloc.ty = RelocType::GLOBAL_ADDR;
+		}
+		else
+		{
+			// relative addresses inside the module stay valid
+			continue;
+		}
+
+		obj.relocs.emplace_back(std::move(reloc));
 	}
 
-	// move stream pointers back to the end
-	m_ostr->seekp(0, std::ios_base::end);
+	// relative accesses to the global variables and the memo tables
+	add_relative_relocs(obj, static_cast<std::size_t>(m_code.GetLabelAddress(m_consttab_label)));
+
+	return obj;
 }
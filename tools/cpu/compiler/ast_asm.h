@@ -17,14 +17,21 @@
 #include "lval.h"
 #include "ast.h"
 #include "symbol.h"
+#include "codebuf.h"
+#include "objfile.h"
 #include "vm/opcodes.h"
 
 
+// mapping of operator token ids to the opcode names and opcodes
+using t_ops = std::unordered_map<std::size_t, std::tuple<std::string, OpCode>>;
+
+const t_ops& get_default_ops();
+
+
 class ASTAsm : public ASTMutableVisitor
 {
 public:
-	ASTAsm(std::ostream& ostr = std::cout,
-		std::unordered_map<std::size_t, std::tuple<std::string, OpCode>> *ops = nullptr);
+	ASTAsm(const t_ops *ops = nullptr);
 
 	ASTAsm(const ASTAsm&) = delete;
 	const ASTAsm& operator=(const ASTAsm&) = delete;
@@ -45,38 +52,79 @@ public:
 	virtual void visit(ASTTypedIdent* ast, std::size_t level, bool gen_code) override;
 	virtual void visit(ASTAddrOf* ast, std::size_t level, bool gen_code) override;
 	virtual void visit(ASTDeref* ast, std::size_t level, bool gen_code) override;
-
-	void SetStream(std::ostream* ostr) { m_ostr = ostr; }
+	virtual void visit(ASTArrayDecl* ast, std::size_t level, bool gen_code) override;
+	virtual void visit(ASTArrayAccess* ast, std::size_t level, bool gen_code) override;
 
 	void PatchFunctionAddresses();
 	void FinishCodegen();
 
 	const SymTab& GetSymbolTable() const { return m_symtab; }
+	const CodeBuffer& GetCode() const { return m_code; }
+
+	void SetOptimise(bool opt) { m_optimise = opt; }
+	void SetMemoisation(const std::unordered_set<std::string>& funcs, t_int num_entries);
+	t_int GetMemoSize() const;
+
+	// compile a module whose calls to unknown functions are resolved by the linker
+	void SetObjectMode(bool obj) { m_object = obj; }
+	ObjFile CreateObject() const;
+
+
+protected:
+	CodeBuffer::t_label GetFunctionLabel(const std::string& func_name);
+
+	const SymInfo* GetVariable(const t_str& name) const;
+	t_str GetScopedName(const t_str& name) const;
+	OpCode GetRelativeAccess(const SymInfo* sym, VMType ty, bool write) const;
+	OpCode GetIndexedAccess(const SymInfo* sym, VMType ty, bool write) const;
+
+	void EmitConditionalJump(ASTBase* cond, bool jump_if,
+		CodeBuffer::t_label label, std::size_t level);
+	void EmitBinary(ASTBinary* ast, std::size_t level);
+	void EmitMemoAccess(const ASTFunc* func, OpCode op);
+	void EmitPushAddress(const SymInfo* sym);
 
 
 private:
-	std::ostream* m_ostr{&std::cout};
-	const std::unordered_map<std::size_t, std::tuple<std::string, OpCode>> *m_ops{nullptr};
+	CodeBuffer m_code{};                   // generated code
+	const t_ops *m_ops{nullptr};
 
 	ConstTab m_consttab{};                 // table of constants
 	SymTab m_symtab{};                     // table of symbols
 
 	t_int m_glob_stack{};                  // current offset into global variable stack
-	std::unordered_map<std::string, t_int> m_local_stack{};
+	std::unordered_map<SymTab::t_id, t_int> m_local_stack{};
 
 	std::string m_cur_func{};              // currently active function
+	SymTab::t_id m_cur_scope{SymTab::GLOBAL_SCOPE};  // symbol scope of the active function
 	VMType m_cur_rettype{VMType::UNKNOWN}; // return type of currently active function
-	std::vector<std::string> m_cur_loop{}; // currently active loops in function
+	CodeBuffer::t_label m_cur_ret{};       // return label of the currently active function
+
+	// the operands of the expression being generated have already been visited for their
+	// data types, so nested expressions can skip this (otherwise deep expressions are
+	// visited once per enclosing binary operator)
+	bool m_operand_types_known{false};
+
+	// begin (continue) and end (break) labels of the currently active loops in function
+	std::vector<std::pair<CodeBuffer::t_label, CodeBuffer::t_label>> m_cur_loop{};
+
+	// function labels and calls whose functions have not yet been seen
+	std::unordered_map<std::string, CodeBuffer::t_label> m_func_labels{};
+	std::vector<std::tuple<std::string, t_int, const ::ASTBase*>> m_func_comefroms{};
+
+	// start of the constants block after the code
+	CodeBuffer::t_label m_consttab_label{m_code.NewLabel()};
+
+	// start of the code, global variable addresses are pushed relative to it in object mode
+	CodeBuffer::t_label m_module_label{m_code.NewLabel()};
 
-	// stream positions where addresses need to be patched in
-	std::vector<std::tuple<std::string, std::streampos, t_int, const ::ASTBase*>>
-		m_func_comefroms{};
-	std::vector<std::streampos> m_endfunc_comefroms{};
-	std::unordered_multimap<std::string, std::streampos> m_loop_begin_comefroms{};
-	std::unordered_multimap<std::string, std::streampos> m_loop_end_comefroms{};
-	std::vector<std::tuple<std::streampos, std::streampos>> m_const_addrs{};
+	bool m_optimise{false};                // peephole optimisation
+	bool m_object{false};                  // create a relocatable module
 
-	std::size_t m_glob_label{0};           // jump label counter
+	// functions whose results are cached in memo tables in the heap
+	std::unordered_set<std::string> m_memo_funcs{};
+	std::unordered_map<std::string, t_int> m_memo_tables{};  // offsets of the tables to the heap pointer
+	t_int m_memo_entries{};                // number of entries per table
 };
 
 
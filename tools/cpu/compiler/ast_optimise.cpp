@@ -6,115 +6,2778 @@
  */
 
 #include "ast_optimise.h"
+#include "ast_asm.h"
+#include "lexer.h"
 #include "vm/helpers.h"
+#include "vm/vm.h"
+
+#include <variant>
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+#include <limits>
+#include <bit>
+#include <cmath>
+#include <sstream>
+#include <chrono>
+
+
+// value of a constant expression
+using t_const = std::variant<t_int, t_real>;
+
+// variables with known constant values
+using t_consts = std::unordered_map<t_str, t_const>;
+
+// set of variable names
+using t_vars = std::unordered_set<t_str>;
+
+// minimum and maximum value of an integer expression
+using t_range = ASTArrayAccess::t_range;
+
+// variables with known value ranges
+using t_ranges = std::unordered_map<t_str, t_range>;
+
+
+// maximum number of propagation and elimination rounds
+static constexpr std::size_t MAX_PASSES = 8;
+
+// maximum number of iterations of a loop to simulate for unrolling
+static constexpr std::size_t MAX_TRIP_COUNT = 1 << 20;
+
+// maximum number of syntax tree nodes of an unrolled loop
+static constexpr std::size_t MAX_UNROLL_SIZE = 256;
+
+// memory and frame size of the vm which runs the functions evaluated at compile time
+static constexpr t_int EVAL_MEM_SIZE = 1 << 18;
+static constexpr t_int EVAL_FRAME_SIZE = 1 << 10;
+
+// separates the parts of the names of the variables created by the optimiser,
+// it cannot occur in identifiers, so the new variables do not clash with the program's ones
+static constexpr char TEMP_SEP = '@';
+
+
+/**
+ * state of the compile-time evaluation of function calls
+ */
+struct EvalState
+{
+	std::unordered_map<t_str, std::shared_ptr<ASTFunc>> funcs{};  // functions which can be evaluated
+	std::unordered_map<t_str, t_vars> calls{};  // functions called by them
+	std::unordered_map<t_str, std::optional<t_const>> results{};  // results of the evaluated calls
+	t_vars evaluated{};         // functions which have been evaluated at least once
+	std::size_t budget{};       // maximum number of instructions to run per call, 0: no evaluation
+};
+
+
+/**
+ * state of the constant propagation within a function or the global scope
+ */
+struct PropagationState
+{
+	t_consts consts{};          // known variable values at the current position
+	t_ranges ranges{};          // known ranges of the loop counters at the current position
+	bool safe{true};            // no addresses are taken or dereferenced in the scope
+	std::size_t unroll{};       // unroll factor for loops, 0 or 1: no unrolling
+	std::unordered_set<t_astbaseptr> *unrolled{};  // loops which have already been unrolled
+	EvalState *eval{};          // functions which can be evaluated at compile time
+	std::size_t *opt_ctr{};
+};
+
+
+/**
+ * state of the dead assignment elimination within a function or the global scope
+ */
+struct LivenessState
+{
+	bool safe{true};            // no addresses are taken or dereferenced in the scope
+	std::vector<t_vars> loops{};  // variables which are live in the enclosing loops
+	std::size_t *opt_ctr{};
+};
+
+
+/**
+ * state of the function inlining
+ */
+struct InlineState
+{
+	std::unordered_map<t_str, std::shared_ptr<ASTFunc>> funcs{};  // functions which can be inlined
+	t_vars inlined{};           // functions which have been inlined at least once
+	std::size_t num_calls{};    // number of inlined calls, used for unique variable names
+	std::size_t *opt_ctr{};
+};
+
+
+/**
+ * state of the loop-invariant code motion
+ */
+struct InvariantState
+{
+	std::size_t num_temps{};    // number of hoisted expressions, used for unique variable names
+	std::size_t *opt_ctr{};
+};
+
+
+
+/**
+ * is the node a literal value of the given type (and not, e.g., a variable identifier)?
+ */
+template<class t_val>
+static bool is_literal(const t_astbaseptr& ast)
+{
+	const ASTToken<t_val>* tok = dynamic_cast<const ASTToken<t_val>*>(ast.get());
+	return tok && tok->HasLexerValue() && !tok->IsIdent();
+}
+
+
+/**
+ * get the variable identifier the node names
+ */
+static ASTToken<t_str>* get_ident(const t_astbaseptr& ast)
+{
+	if(!ast || ast->GetType() != ASTType::TOKEN)
+		return nullptr;
+
+	ASTToken<t_str>* tok = dynamic_cast<ASTToken<t_str>*>(ast.get());
+	if(!tok || !tok->IsIdent() || !tok->HasLexerValue())
+		return nullptr;
+
+	return tok;
+}
+
+
+/**
+ * get the value of a literal node
+ */
+static std::optional<t_const> get_const(const t_astbaseptr& ast)
+{
+	if(!ast || ast->GetType() != ASTType::TOKEN)
+		return std::nullopt;
+
+	if(is_literal<t_int>(ast))
+		return static_cast<const ASTToken<t_int>*>(ast.get())->GetLexerValue();
+	if(is_literal<t_real>(ast))
+		return static_cast<const ASTToken<t_real>*>(ast.get())->GetLexerValue();
+
+	return std::nullopt;
+}
+
+
+/**
+ * compare constants bitwise, e.g. to distinguish 0 and -0
+ */
+static bool is_same_const(const t_const& val1, const t_const& val2)
+{
+	if(val1.index() != val2.index())
+		return false;
+
+	if(std::holds_alternative<t_int>(val1))
+		return std::get<t_int>(val1) == std::get<t_int>(val2);
+
+	return std::bit_cast<t_uint>(std::get<t_real>(val1))
+		== std::bit_cast<t_uint>(std::get<t_real>(val2));
+}
+
+
+static bool is_true(const t_const& val)
+{
+	return std::visit([](auto v) -> bool { return v != 0; }, val);
+}
+
+
+/**
+ * only keep the variable values which are the same on both paths joining at a position
+ */
+static void merge_consts(t_consts& consts, const t_consts& other)
+{
+	std::erase_if(consts, [&other](const auto& var) -> bool
+	{
+		auto iter = other.find(var.first);
+		return iter == other.end() || !is_same_const(iter->second, var.second);
+	});
+}
+
+
+/**
+ * convert a constant to the given type like the casts emitted by the code generator
+ */
+static std::optional<t_const> convert_const(const t_const& val, VMType ty)
+{
+	if(ty == VMType::INT)
+	{
+		if(std::holds_alternative<t_int>(val))
+			return val;
+
+		// the conversion is undefined for values out of range
+		t_real real = std::get<t_real>(val);
+		const t_real min = static_cast<t_real>(std::numeric_limits<t_int>::min());
+		if(!(real >= min && real < -min))
+			return std::nullopt;
+
+		return static_cast<t_int>(real);
+	}
+	else if(ty == VMType::REAL)
+	{
+		if(std::holds_alternative<t_real>(val))
+			return val;
+
+		return static_cast<t_real>(std::get<t_int>(val));
+	}
+
+	return std::nullopt;
+}
+
+
+/**
+ * create a literal node for a constant, which replaces the given node
+ */
+static t_astbaseptr make_const(const t_astbaseptr& ast, const t_const& val)
+{
+	std::size_t line = 0;
+	if(auto line_range = ast->GetLineRange(); line_range)
+		line = std::get<0>(*line_range);
+
+	t_astbaseptr node;
+	if(std::holds_alternative<t_int>(val))
+	{
+		node = make_ast_node<ASTToken<t_int>>(nullptr,
+			ast->GetId(), 0, std::get<t_int>(val), line);
+		node->SetDataType(VMType::INT);
+	}
+	else
+	{
+		node = make_ast_node<ASTToken<t_real>>(nullptr,
+			ast->GetId(), 0, std::get<t_real>(val), line);
+		node->SetDataType(VMType::REAL);
+	}
+
+	node->SetTerminalOverride(false);  // expression, no terminal
+	node->SetLineRange(ast->GetLineRange());
+	return node;
+}
+
+
+/**
+ * evaluate a unary operation on a constant
+ */
+static std::optional<t_const> fold_unary(std::size_t opid, const t_const& val)
+{
+	if(std::holds_alternative<t_int>(val))
+	{
+		t_int ival = std::get<t_int>(val);
+
+		switch(opid)
+		{
+			case '+': return ival;
+			case '-': return static_cast<t_int>(-static_cast<t_uint>(ival));
+			case '!': return static_cast<t_int>(!ival);
+			case '~': return static_cast<t_int>(~ival);
+		}
+	}
+	else
+	{
+		t_real rval = std::get<t_real>(val);
+
+		switch(opid)
+		{
+			case '+': return rval;
+			case '-': return -rval;
+		}
+	}
+
+	return std::nullopt;
+}
+
+
+/**
+ * evaluate a binary operation on constants of the operation's data type,
+ * the results are the same as the ones of the vm
+ */
+template<class t_val>
+static std::optional<t_const> fold_binary(std::size_t opid, t_val val1, t_val val2)
+{
+	constexpr bool is_int = std::is_same_v<t_val, t_int>;
+
+	switch(opid)
+	{
+		case '+':
+		case '-':
+		case '*':
+		{
+			if constexpr(is_int)
+			{
+				// wrap around on overflow
+				t_uint uval1 = static_cast<t_uint>(val1);
+				t_uint uval2 = static_cast<t_uint>(val2);
+
+				if(opid == '+')
+					return static_cast<t_int>(uval1 + uval2);
+				else if(opid == '-')
+					return static_cast<t_int>(uval1 - uval2);
+				return static_cast<t_int>(uval1 * uval2);
+			}
+			else
+			{
+				if(opid == '+')
+					return val1 + val2;
+				else if(opid == '-')
+					return val1 - val2;
+				return val1 * val2;
+			}
+		}
+
+		case '/':
+		case '%':
+		{
+			if constexpr(is_int)
+			{
+				// leave the division errors to run time
+				if(val2 == 0 || (val1 == std::numeric_limits<t_int>::min() && val2 == -1))
+					return std::nullopt;
+
+				if(opid == '/')
+					return val1 / val2;
+				return val1 % val2;
+			}
+			else
+			{
+				if(opid == '/')
+					return val1 / val2;
+				return std::fmod(val1, val2);
+			}
+		}
+
+		case '^':
+			return ::pow<t_val>(val1, val2);
+
+		// comparisons
+		case '>': return static_cast<t_bool>(val1 > val2);
+		case '<': return static_cast<t_bool>(val1 < val2);
+		case static_cast<std::size_t>(Token::GEQU): return static_cast<t_bool>(val1 >= val2);
+		case static_cast<std::size_t>(Token::LEQU): return static_cast<t_bool>(val1 <= val2);
+		case static_cast<std::size_t>(Token::EQU):
+		case static_cast<std::size_t>(Token::NEQU):
+		{
+			bool equ = false;
+			if constexpr(is_int)
+				equ = (val1 == val2);
+			else  // same epsilon as the vm
+				equ = (std::abs(val1 - val2) <= std::numeric_limits<t_real>::epsilon());
+
+			if(opid == static_cast<std::size_t>(Token::NEQU))
+				equ = !equ;
+			return static_cast<t_bool>(equ);
+		}
+
+		// logical operators
+		case static_cast<std::size_t>(Token::AND):
+			return static_cast<t_bool>(val1 != 0 && val2 != 0);
+		case static_cast<std::size_t>(Token::OR):
+			return static_cast<t_bool>(val1 != 0 || val2 != 0);
+	}
+
+	// binary operators
+	if constexpr(is_int)
+	{
+		switch(opid)
+		{
+			case '&': return val1 & val2;
+			case '|': return val1 | val2;
+			case static_cast<std::size_t>(Token::BIN_XOR): return val1 ^ val2;
+			case static_cast<std::size_t>(Token::SHIFT_LEFT):
+			case static_cast<std::size_t>(Token::SHIFT_RIGHT):
+			{
+				// shifts by the register width or more are left to run time
+				if(val2 < 0 || val2 >= std::numeric_limits<t_uint>::digits)
+					return std::nullopt;
+
+				if(opid == static_cast<std::size_t>(Token::SHIFT_LEFT))
+					return static_cast<t_int>(static_cast<t_uint>(val1) << val2);
+				return val1 >> val2;
+			}
+		}
+	}
+
+	return std::nullopt;
+}
+
+
+/**
+ * evaluate a binary operation, casting the operands to its data type
+ */
+static std::optional<t_const> fold_binary(std::size_t opid, VMType ty,
+	const t_const& val1, const t_const& val2)
+{
+	std::optional<t_const> conv1 = convert_const(val1, ty);
+	std::optional<t_const> conv2 = convert_const(val2, ty);
+	if(!conv1 || !conv2)
+		return std::nullopt;
+
+	if(ty == VMType::INT)
+		return fold_binary<t_int>(opid, std::get<t_int>(*conv1), std::get<t_int>(*conv2));
+	return fold_binary<t_real>(opid, std::get<t_real>(*conv1), std::get<t_real>(*conv2));
+}
+
+
+/**
+ * collect the variables which are read or written in the current scope
+ */
+static void get_vars(const t_astbaseptr& ast, t_vars& vars, bool read, bool written)
+{
+	if(!ast || ast->GetType() == ASTType::FUNC)
+		return;
+
+	if(const ASTToken<t_str>* ident = get_ident(ast); ident)
+	{
+		if(ident->IsLValue() ? written : read)
+			vars.insert(ident->GetLexerValue());
+		return;
+	}
+
+	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+		get_vars(ast->GetChild(childidx), vars, read, written);
+}
+
+
+/**
+ * are variable addresses taken or dereferenced in the current scope?
+ * variables can then change without being assigned
+ */
+static bool uses_addresses(const t_astbaseptr& ast)
+{
+	if(!ast || ast->GetType() == ASTType::FUNC)
+		return false;
+
+	if(ast->GetType() == ASTType::ADDROF || ast->GetType() == ASTType::DEREF)
+		return true;
+
+	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+	{
+		if(uses_addresses(ast->GetChild(childidx)))
+			return true;
+	}
+
+	return false;
+}
+
+
+/**
+ * does the block declare arrays?
+ */
+static bool declares_arrays(const t_astbaseptr& ast)
+{
+	if(!ast || ast->GetType() == ASTType::FUNC)
+		return false;
+
+	if(ast->GetType() == ASTType::ARRAY_DECL)
+		return true;
+
+	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+	{
+		if(declares_arrays(ast->GetChild(childidx)))
+			return true;
+	}
+
+	return false;
+}
+
+
+/**
+ * can the integer division or remainder trap at run time,
+ * i.e. is its divisor not known to be a constant other than 0 and -1?
+ */
+static bool may_trap(const ASTBinary* binary)
+{
+	const std::size_t opid = binary->GetOpId();
+	if((opid != '/' && opid != '%') || binary->GetDataType() == VMType::REAL)
+		return false;
+
+	std::optional<t_const> divisor = get_const(binary->GetChild(1));
+	if(divisor)
+		divisor = convert_const(*divisor, VMType::INT);
+	return !divisor || std::get<t_int>(*divisor) == 0 || std::get<t_int>(*divisor) == -1;
+}
+
+
+/**
+ * does the evaluation of the expression do more than produce a value?
+ * operations which can trap at run time also count as side effects
+ */
+static bool has_side_effects(const t_astbaseptr& ast)
+{
+	if(!ast)
+		return false;
+
+	switch(ast->GetType())
+	{
+		case ASTType::FUNCCALL:
+		case ASTType::DEREF:
+		case ASTType::JUMP:
+		case ASTType::ARRAY_DECL:
+			return true;
+		case ASTType::BINARY:
+		{
+			const ASTBinary* binary = static_cast<const ASTBinary*>(ast.get());
+			if(binary->GetOpId() == '=' || may_trap(binary))
+				return true;
+			break;
+		}
+		case ASTType::ARRAY_ACCESS:
+		{
+			// only literal indices are checked at compile time, the others need a bounds check
+			const ASTArrayAccess* access = static_cast<const ASTArrayAccess*>(ast.get());
+			if(access->IsLValue() || !dynamic_cast<const ASTToken<t_int>*>(access->GetIndex().get()))
+				return true;
+			break;
+		}
+		default:
+			break;
+	}
+
+	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+	{
+		if(has_side_effects(ast->GetChild(childidx)))
+			return true;
+	}
+
+	return false;
+}
+
+
+/**
+ * does the block never continue with the following statement?
+ */
+static bool ends_with_jump(const t_astbaseptr& ast)
+{
+	if(!ast)
+		return false;
+
+	if(ast->GetType() == ASTType::JUMP)
+		return true;
+
+	if(ast->GetType() == ASTType::LIST && ast->NumChildren())
+		return ends_with_jump(ast->GetChild(ast->NumChildren() - 1));
+
+	return false;
+}
+
+
+/**
+ * create a node for a unary operation
+ */
+static t_astbaseptr make_unary(const t_astbaseptr& ast, const t_astbaseptr& arg, std::size_t opid)
+{
+	t_astbaseptr node = make_ast_node<ASTUnary>(nullptr, ast->GetId(), 0, arg, opid);
+	node->SetDataType(ast->GetDataType());
+	node->SetLineRange(ast->GetLineRange());
+	return node;
+}
+
+
+/**
+ * create a node for a binary operation
+ */
+static t_astbaseptr make_binary(const t_astbaseptr& ast,
+	const t_astbaseptr& arg1, const t_astbaseptr& arg2, std::size_t opid)
+{
+	t_astbaseptr node = make_ast_node<ASTBinary>(nullptr, ast->GetId(), 0, arg1, arg2, opid);
+	node->SetDataType(ast->GetDataType());
+	node->SetLineRange(ast->GetLineRange());
+	return node;
+}
+
+
+/**
+ * get the exponent of a positive power of two
+ */
+static std::optional<t_int> get_power_of_two(const t_const& val)
+{
+	if(std::holds_alternative<t_int>(val))
+	{
+		t_int ival = std::get<t_int>(val);
+		if(ival <= 0 || !std::has_single_bit(static_cast<t_uint>(ival)))
+			return std::nullopt;
+		return std::countr_zero(static_cast<t_uint>(ival));
+	}
+
+	int exp = 0;
+	t_real mant = std::frexp(std::abs(std::get<t_real>(val)), &exp);
+	if(mant != t_real(0.5))
+		return std::nullopt;
+	return exp - 1;
+}
+
+
+/**
+ * algebraic simplification and strength reduction of binary operations with a constant operand,
+ * only rewrites which give exactly the same results are done
+ * @return the replacement node or nullptr if nothing can be simplified
+ */
+static t_astbaseptr simplify_binary(const t_astbaseptr& ast)
+{
+	const std::size_t opid = static_cast<const ASTBinary*>(ast.get())->GetOpId();
+	const VMType ty = ast->GetDataType();
+	if(ty != VMType::INT && ty != VMType::REAL)
+		return nullptr;
+	const bool is_int = (ty == VMType::INT);
+
+	const t_astbaseptr& lhs = ast->GetChild(0);
+	const t_astbaseptr& rhs = ast->GetChild(1);
+
+	// the constant operands, cast to the type of the operation
+	std::optional<t_const> lhs_val, rhs_val;
+	if(std::optional<t_const> val = get_const(lhs); val)
+		lhs_val = convert_const(*val, ty);
+	if(std::optional<t_const> val = get_const(rhs); val)
+		rhs_val = convert_const(*val, ty);
+
+	auto is_val = [](const std::optional<t_const>& val, t_real cmp) -> bool
+	{
+		return val && std::visit([cmp](auto v) -> bool { return v == cmp; }, *val);
+	};
+
+	// an operand replacing the operation needs to have its type to not change the casts
+	auto keep = [ty](const t_astbaseptr& arg) -> t_astbaseptr
+	{
+		return arg->GetDataType() == ty ? arg : nullptr;
+	};
+
+	switch(opid)
+	{
+		case '+':
+		{
+			// x + 0 = 0 + x = x, not for reals as -0 + 0 = +0
+			if(is_int && is_val(rhs_val, 0))
+				return keep(lhs);
+			if(is_int && is_val(lhs_val, 0))
+				return keep(rhs);
+			break;
+		}
+
+		case '-':
+		{
+			// x - 0 = x
+			if(is_val(rhs_val, 0) && !std::signbit(std::visit(
+				[](auto v) -> t_real { return static_cast<t_real>(v); }, *rhs_val)))
+				return keep(lhs);
+			break;
+		}
+
+		case '*':
+		{
+			for(int arg = 0; arg < 2; ++arg)
+			{
+				const std::optional<t_const>& val = (arg == 0 ? rhs_val : lhs_val);
+				const t_astbaseptr& other = (arg == 0 ? lhs : rhs);
+				if(!val || other->GetDataType() != ty)
+					continue;
+
+				// x * 1 = x
+				if(is_val(val, 1))
+					return other;
+
+				if(is_int)
+				{
+					// x * -1 = -x, not for reals as the sign of nan would change
+					if(is_val(val, -1))
+						return make_unary(ast, other, '-');
+
+					// x * 0 = 0
+					if(is_val(val, 0) && !has_side_effects(other))
+						return make_const(ast, t_int(0));
+
+					// x * 2^n = x << n, the same for negative numbers and overflows
+					if(std::optional<t_int> exp = get_power_of_two(*val); exp)
+					{
+						return make_binary(ast, other, make_const(ast, *exp),
+							static_cast<std::size_t>(Token::SHIFT_LEFT));
+					}
+				}
+			}
+			break;
+		}
+
+		case '/':
+		{
+			if(!rhs_val || lhs->GetDataType() != ty)
+				break;
+
+			// x / 1 = x
+			// (x / -1 is not rewritten to -x, as the division traps for the minimum integer)
+			if(is_val(rhs_val, 1))
+				return lhs;
+
+			// x / 2^n = x * 2^-n for reals, the reciprocal has to be exact
+			// (the integer shift would round towards -inf instead of 0 for negative numbers)
+			if(!is_int && get_power_of_two(*rhs_val))
+			{
+				t_real recip = t_real(1) / std::get<t_real>(*rhs_val);
+				if(std::isfinite(recip) && get_power_of_two(recip))
+					return make_binary(ast, lhs, make_const(rhs, recip), '*');
+			}
+			break;
+		}
+
+		case static_cast<std::size_t>(Token::AND):
+		case static_cast<std::size_t>(Token::OR):
+		{
+			// false && x = false, true || x = true, the rhs is not evaluated
+			if(lhs_val && is_true(*lhs_val) == (opid == static_cast<std::size_t>(Token::OR)))
+				return make_const(ast, static_cast<t_bool>(is_true(*lhs_val)));
+			break;
+		}
+
+		case '^':
+		{
+			if(!rhs_val)
+				break;
+
+			// x ^ 1 = x
+			if(is_val(rhs_val, 1))
+				return keep(lhs);
+
+			// x ^ 0 = 1, also for nan
+			if(is_val(rhs_val, 0) && !has_side_effects(lhs))
+			{
+				if(is_int)
+					return make_const(ast, t_int(1));
+				return make_const(ast, t_real(1));
+			}
+			break;
+		}
+	}
+
+	return nullptr;
+}
+
+
+/**
+ * is the variable a temporary one created by the optimiser,
+ * e.g. for the arguments, locals, or results of an inlined function?
+ */
+static bool is_temp_var(const t_str& var)
+{
+	return var.find(TEMP_SEP) != t_str::npos;
+}
+
+
+/**
+ * get the number of nodes in the syntax tree
+ */
+std::size_t count_nodes(const t_astbaseptr& ast)
+{
+	if(!ast)
+		return 0;
+
+	std::size_t num = 1;
+	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+		num += count_nodes(ast->GetChild(childidx));
+
+	return num;
+}
+
+
+/**
+ * can the statements be moved to another position, e.g. into another function or loop?
+ * they must not return and their breaks and continues have to stay inside their own loops,
+ * as the code generator limits the loop depth to the number of enclosing loops
+ */
+static bool is_self_contained(const t_astbaseptr& ast, std::size_t loop_depth = 0)
+{
+	if(!ast)
+		return true;
+
+	switch(ast->GetType())
+	{
+		case ASTType::FUNC:
+			return false;
+
+		case ASTType::LOOP:
+			++loop_depth;
+			break;
+
+		case ASTType::JUMP:
+		{
+			const ASTJump* jump = static_cast<const ASTJump*>(ast.get());
+			if(jump->GetJumpType() == ASTJump::JumpType::RETURN || loop_depth == 0)
+				return false;
+
+			t_int depth = 0;
+			if(std::optional<t_const> val = get_const(jump->GetExpr()); val)
+			{
+				if(std::holds_alternative<t_int>(*val))
+					depth = std::get<t_int>(*val);
+				else
+					depth = static_cast<t_int>(std::round(std::get<t_real>(*val)));
+			}
+
+			return depth >= 0 && static_cast<std::size_t>(depth) < loop_depth;
+		}
+
+		default:
+			break;
+	}
+
+	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+	{
+		if(!is_self_contained(ast->GetChild(childidx), loop_depth))
+			return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * copy the attributes of a node which are not set by the constructor
+ */
+static t_astbaseptr copy_attributes(const t_astbaseptr& node, const t_astbaseptr& ast)
+{
+	node->SetDataType(ast->GetDataType());
+	node->SetLineRange(ast->GetLineRange());
+	if(std::optional<bool> term = ast->GetTerminalOverride(); term)
+		node->SetTerminalOverride(*term);
+
+	return node;
+}
+
+
+/**
+ * copy a token, optionally with a new lexer value
+ */
+template<class t_val>
+static t_astbaseptr copy_token(const t_astbaseptr& ast, const std::optional<t_val>& newval = std::nullopt)
+{
+	const ASTToken<t_val>* tok = static_cast<const ASTToken<t_val>*>(ast.get());
+
+	std::size_t line = 0;
+	if(auto line_range = ast->GetLineRange(); line_range)
+		line = std::get<0>(*line_range);
+
+	std::shared_ptr<ASTToken<t_val>> node;
+	if(newval)
+		node = make_ast_node<ASTToken<t_val>>(nullptr, ast->GetId(), 0, *newval, line);
+	else if(tok->HasLexerValue())
+		node = make_ast_node<ASTToken<t_val>>(nullptr, ast->GetId(), 0, tok->GetLexerValue(), line);
+	else
+		node = make_ast_node<ASTToken<t_val>>(nullptr, ast->GetId(), 0, line);
+
+	node->SetIdent(tok->IsIdent());
+	node->SetLValue(tok->IsLValue());
+	return copy_attributes(node, ast);
+}
+
+
+/**
+ * copy a syntax tree, its variables are either prefixed or replaced by copies of the given nodes
+ */
+static t_astbaseptr copy_ast(const t_astbaseptr& ast, const t_str& prefix,
+	const std::unordered_map<t_str, t_astbaseptr>* subst = nullptr)
+{
+	if(!ast)
+		return ast;
+
+	t_astbaseptr node;
+	switch(ast->GetType())
+	{
+		case ASTType::TOKEN:
+		{
+			if(const ASTToken<t_str>* ident = get_ident(ast); ident)
+			{
+				if(subst)
+				{
+					if(auto iter = subst->find(ident->GetLexerValue()); iter != subst->end())
+						return copy_ast(iter->second, "");
+				}
+
+				if(prefix != "")
+					return copy_token<t_str>(ast, prefix + TEMP_SEP + ident->GetLexerValue());
+				return copy_token<t_str>(ast);
+			}
+
+			if(dynamic_cast<const ASTToken<t_int>*>(ast.get()))
+				return copy_token<t_int>(ast);
+			if(dynamic_cast<const ASTToken<t_real>*>(ast.get()))
+				return copy_token<t_real>(ast);
+			if(dynamic_cast<const ASTToken<t_str>*>(ast.get()))
+				return copy_token<t_str>(ast);
+			return ast;
+		}
+
+		case ASTType::UNARY:
+		{
+			const ASTUnary* unary = static_cast<const ASTUnary*>(ast.get());
+			node = make_ast_node<ASTUnary>(nullptr, ast->GetId(), 0,
+				nullptr, unary->GetOpId());
+			break;
+		}
+
+		case ASTType::BINARY:
+		{
+			const ASTBinary* binary = static_cast<const ASTBinary*>(ast.get());
+			node = make_ast_node<ASTBinary>(nullptr, ast->GetId(), 0,
+				nullptr, nullptr, binary->GetOpId());
+			break;
+		}
+
+		case ASTType::LIST:
+		{
+			auto list = make_ast_node<ASTList>(nullptr, ast->GetId(), 0);
+			for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+				list->AddChild(nullptr);
+			node = list;
+			break;
+		}
+
+		case ASTType::CONDITION:
+		{
+			if(ast->NumChildren() == 3)
+			{
+				node = make_ast_node<ASTCondition>(nullptr, ast->GetId(), 0,
+					nullptr, nullptr, nullptr);
+			}
+			else
+			{
+				node = make_ast_node<ASTCondition>(nullptr, ast->GetId(), 0,
+					nullptr, nullptr);
+			}
+			break;
+		}
+
+		case ASTType::LOOP:
+		{
+			node = make_ast_node<ASTLoop>(nullptr, ast->GetId(), 0, nullptr, nullptr);
+			break;
+		}
+
+		case ASTType::JUMP:
+		{
+			const ASTJump* jump = static_cast<const ASTJump*>(ast.get());
+			node = make_ast_node<ASTJump>(nullptr, ast->GetId(), 0, jump->GetJumpType());
+			break;
+		}
+
+		case ASTType::FUNCCALL:
+		{
+			const ASTFuncCall* call = static_cast<const ASTFuncCall*>(ast.get());
+			node = make_ast_node<ASTFuncCall>(nullptr, ast->GetId(), 0,
+				call->GetName(), nullptr);
+			break;
+		}
+
+		case ASTType::ADDROF:
+		{
+			const ASTAddrOf* addrof = static_cast<const ASTAddrOf*>(ast.get());
+			node = make_ast_node<ASTAddrOf>(nullptr, ast->GetId(), 0, addrof->GetName());
+			break;
+		}
+
+		case ASTType::DEREF:
+		{
+			node = make_ast_node<ASTDeref>(nullptr, ast->GetId(), 0, nullptr, nullptr);
+			break;
+		}
+
+		case ASTType::ARRAY_DECL:
+		{
+			const ASTArrayDecl* decl = static_cast<const ASTArrayDecl*>(ast.get());
+			node = make_ast_node<ASTArrayDecl>(nullptr, ast->GetId(), 0, nullptr, decl->GetSize());
+			break;
+		}
+
+		case ASTType::ARRAY_ACCESS:
+		{
+			const ASTArrayAccess* access = static_cast<const ASTArrayAccess*>(ast.get());
+			auto node_access = make_ast_node<ASTArrayAccess>(nullptr, ast->GetId(), 0, nullptr, nullptr);
+			node_access->SetIndexRange(access->GetIndexRange());
+			node = node_access;
+			break;
+		}
+
+		default:
+		{
+			// functions are not nested and typed identifiers are not part of the final tree
+			throw std::runtime_error("Cannot copy syntax tree node.");
+		}
+	}
+
+	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+		node->SetChild(childidx, copy_ast(ast->GetChild(childidx), prefix, subst));
+
+	return copy_attributes(node, ast);
+}
+
+
+/**
+ * create a variable node for a temporary value
+ */
+static t_astbaseptr make_var(const t_astbaseptr& ast, const t_str& name, VMType ty, bool lval)
+{
+	std::size_t line = 0;
+	if(auto line_range = ast->GetLineRange(); line_range)
+		line = std::get<0>(*line_range);
+
+	auto node = make_ast_node<ASTToken<t_str>>(nullptr, ast->GetId(), 0, name, line);
+	node->SetIdent(true);
+	node->SetLValue(lval);
+	node->SetDataType(ty);
+	node->SetTerminalOverride(false);  // expression, no terminal
+	node->SetLineRange(ast->GetLineRange());
+	return node;
+}
+
+
+/**
+ * create an assignment to a temporary variable
+ */
+static t_astbaseptr make_assign(const t_astbaseptr& ast, const t_str& name, VMType ty,
+	const t_astbaseptr& rhs)
+{
+	t_astbaseptr node = make_binary(ast, rhs, make_var(ast, name, ty, true), '=');
+	node->SetDataType(ty);
+	return node;
+}
+
+
+/**
+ * assign the variable types from their first occurrence,
+ * this is the same order in which the code generator registers the symbols
+ */
+static void resolve_var_types(const t_astbaseptr& ast, const t_str& scope,
+	std::unordered_map<t_str, VMType>& syms)
+{
+	if(!ast)
+		return;
+
+	switch(ast->GetType())
+	{
+		case ASTType::TOKEN:
+		{
+			if(ASTToken<t_str>* ident = get_ident(ast); ident)
+			{
+				t_str name = ident->GetLexerValue();
+				if(scope != "")
+					name = scope + "/" + name;
+
+				auto [iter, inserted] = syms.try_emplace(name, ident->GetDataType());
+				if(!inserted && ident->GetDataType() == VMType::UNKNOWN)
+					ident->SetDataType(iter->second);
+			}
+			return;
+		}
+
+		case ASTType::FUNC:
+		{
+			const ASTFunc* func = static_cast<const ASTFunc*>(ast.get());
+			const t_str& func_name = func->GetName();
+
+			if(const t_astbaseptr& args = func->GetArgs(); args)
+			{
+				for(std::size_t argidx=0; argidx<args->NumChildren(); ++argidx)
+				{
+					const ASTToken<t_str>* arg = get_ident(args->GetChild(argidx));
+					if(arg)
+						syms.insert_or_assign(func_name + "/" + arg->GetLexerValue(), arg->GetDataType());
+				}
+			}
+
+			syms.insert_or_assign(func_name, VMType::UNKNOWN);
+			resolve_var_types(func->GetBlock(), func_name, syms);
+			return;
+		}
+
+		case ASTType::DEREF:
+		{
+			// the code generator evaluates the rhs first
+			resolve_var_types(ast->GetChild(1), scope, syms);
+			resolve_var_types(ast->GetChild(0), scope, syms);
+			return;
+		}
+
+		case ASTType::ARRAY_ACCESS:
+		{
+			// the code generator evaluates the rhs, then the index
+			resolve_var_types(ast->GetChild(2), scope, syms);
+			resolve_var_types(ast->GetChild(1), scope, syms);
+			resolve_var_types(ast->GetChild(0), scope, syms);
+			return;
+		}
+
+		default:
+		{
+			for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+				resolve_var_types(ast->GetChild(childidx), scope, syms);
+			return;
+		}
+	}
+}
+
+
+/**
+ * evaluate an expression whose variables have known values
+ */
+static std::optional<t_const> eval_const(const t_astbaseptr& ast, const t_consts& consts)
+{
+	if(!ast)
+		return std::nullopt;
+
+	if(std::optional<t_const> val = get_const(ast); val)
+		return val;
+
+	switch(ast->GetType())
+	{
+		case ASTType::TOKEN:
+		{
+			const ASTToken<t_str>* ident = get_ident(ast);
+			if(!ident || ident->IsLValue())
+				return std::nullopt;
+
+			auto iter = consts.find(ident->GetLexerValue());
+			if(iter == consts.end())
+				return std::nullopt;
+			return iter->second;
+		}
+
+		case ASTType::UNARY:
+		{
+			std::optional<t_const> val = eval_const(ast->GetChild(0), consts);
+			if(!val)
+				return std::nullopt;
+			return fold_unary(static_cast<const ASTUnary*>(ast.get())->GetOpId(), *val);
+		}
+
+		case ASTType::BINARY:
+		{
+			const std::size_t opid = static_cast<const ASTBinary*>(ast.get())->GetOpId();
+			if(opid == '=')
+				return std::nullopt;
+
+			if(ast->GetDataType() == VMType::UNKNOWN)
+				ast->DeriveDataType();
+
+			std::optional<t_const> val1 = eval_const(ast->GetChild(0), consts);
+			std::optional<t_const> val2 = eval_const(ast->GetChild(1), consts);
+			if(!val1 || !val2)
+				return std::nullopt;
+			return fold_binary(opid, ast->GetDataType(), *val1, *val2);
+		}
+
+		default:
+		{
+			return std::nullopt;
+		}
+	}
+}
+
+
+/**
+ * get the number of iterations of a loop which counts a variable starting from a known value,
+ * the last statement of the loop's block has to assign the next value of the variable
+ * @return nullopt if the number is not known or larger than the maximum
+ */
+static std::optional<std::size_t> get_trip_count(const ASTLoop* loop,
+	const t_consts& consts, std::size_t max_trips)
+{
+	const t_astbaseptr& block = loop->GetBlock();
+	if(!block || block->GetType() != ASTType::LIST || !block->NumChildren())
+		return std::nullopt;
+
+	const t_astbaseptr& step = block->GetChild(block->NumChildren() - 1);
+	if(step->GetType() != ASTType::BINARY
+		|| static_cast<const ASTBinary*>(step.get())->GetOpId() != '=')
+		return std::nullopt;
+
+	const ASTToken<t_str>* ctr = get_ident(step->GetChild(1));
+	if(!ctr || !consts.contains(ctr->GetLexerValue()))
+		return std::nullopt;
+
+	// the counter is only assigned by the last statement,
+	// the other variables of the condition and the step must not change in the loop
+	t_vars written;
+	get_vars(loop->GetCondition(), written, false, true);
+	for(std::size_t stmtidx=0; stmtidx+1<block->NumChildren(); ++stmtidx)
+		get_vars(block->GetChild(stmtidx), written, false, true);
+	get_vars(step->GetChild(0), written, false, true);
+	if(written.contains(ctr->GetLexerValue()))
+		return std::nullopt;
+
+	t_consts vals = consts;
+	std::erase_if(vals, [&written](const auto& var) -> bool
+	{
+		return written.contains(var.first);
+	});
+
+	for(std::size_t trips = 0; trips <= max_trips; ++trips)
+	{
+		std::optional<t_const> cond = eval_const(loop->GetCondition(), vals);
+		if(!cond)
+			return std::nullopt;
+		if(!is_true(*cond))
+			return trips;
+
+		// the value is converted to the variable type
+		std::optional<t_const> next = eval_const(step->GetChild(0), vals);
+		if(next)
+			next = convert_const(*next, ctr->GetDataType());
+		if(!next)
+			return std::nullopt;
+		vals.insert_or_assign(ctr->GetLexerValue(), *next);
+	}
+
+	return std::nullopt;
+}
+
+
+/**
+ * unroll a loop with a known number of iterations,
+ * it is replaced by copies of its block if it runs at most unroll-factor times,
+ * otherwise its block is repeated unroll-factor times if this divides the number of iterations
+ * @return the statements replacing the loop or nullptr if the loop is kept
+ */
+static t_astbaseptr unroll_loop(const std::shared_ptr<ASTLoop>& loop, PropagationState& state)
+{
+	if(state.unroll < 2 || !state.safe || !state.unrolled || state.unrolled->contains(loop))
+		return nullptr;
+
+	// the condition is only skipped if the block does not leave the loop early
+	const t_astbaseptr& block = loop->GetBlock();
+	if(!is_self_contained(block))
+		return nullptr;
+
+	std::optional<std::size_t> trips = get_trip_count(loop.get(), state.consts, MAX_TRIP_COUNT);
+	if(!trips)
+		return nullptr;
+
+	const std::size_t size = count_nodes(block);
+	if(*trips <= state.unroll && size * *trips <= MAX_UNROLL_SIZE)
+	{
+		auto stmts = make_ast_node<ASTList>(nullptr, loop->GetId(), 0);
+		for(std::size_t trip = 0; trip < *trips; ++trip)
+			stmts->AddChild(copy_ast(block, ""));
+		return stmts;
+	}
+
+	// the loop is only unrolled once
+	state.unrolled->insert(loop);
+	if(*trips % state.unroll == 0 && size * state.unroll <= MAX_UNROLL_SIZE)
+	{
+		auto stmts = make_ast_node<ASTList>(nullptr, block->GetId(), 0);
+		for(std::size_t trip = 0; trip < state.unroll; ++trip)
+			stmts->AddChild(copy_ast(block, ""));
+		loop->SetBlock(stmts);
+
+		if(state.opt_ctr)
+			++*state.opt_ctr;
+	}
+
+	return nullptr;
+}
+
+
+/**
+ * get the values of a loop counter in the loop's block,
+ * the counter starts from a known value and is only increased by the last statement of the block,
+ * the loop runs while it is smaller than a value which does not change in the loop
+ * @return the counter's name and range or nullopt if they are not known
+ */
+static std::optional<std::pair<t_str, t_range>> get_counter_range(const ASTLoop* loop, const t_consts& consts)
+{
+	const t_astbaseptr& block = loop->GetBlock();
+	if(!block || block->GetType() != ASTType::LIST || !block->NumChildren())
+		return std::nullopt;
+
+	const t_astbaseptr& step = block->GetChild(block->NumChildren() - 1);
+	if(step->GetType() != ASTType::BINARY
+		|| static_cast<const ASTBinary*>(step.get())->GetOpId() != '=')
+		return std::nullopt;
+
+	const ASTToken<t_str>* ctr = get_ident(step->GetChild(1));
+	if(!ctr || ctr->GetDataType() != VMType::INT)
+		return std::nullopt;
+	const t_str& name = ctr->GetLexerValue();
+
+	auto start = consts.find(name);
+	if(start == consts.end() || !std::holds_alternative<t_int>(start->second))
+		return std::nullopt;
+
+	// the counter is only assigned by the last statement
+	t_vars written;
+	get_vars(loop->GetCondition(), written, false, true);
+	for(std::size_t stmtidx=0; stmtidx+1<block->NumChildren(); ++stmtidx)
+		get_vars(block->GetChild(stmtidx), written, false, true);
+	get_vars(step->GetChild(0), written, false, true);
+	if(written.contains(name))
+		return std::nullopt;
+
+	// the step adds a positive constant to the counter
+	const t_astbaseptr& next = step->GetChild(0);
+	if(next->GetType() != ASTType::BINARY
+		|| static_cast<const ASTBinary*>(next.get())->GetOpId() != '+')
+		return std::nullopt;
+
+	std::optional<t_const> incr = get_const(next->GetChild(1));
+	const ASTToken<t_str>* next_ctr = get_ident(next->GetChild(0));
+	if(!incr)
+	{
+		incr = get_const(next->GetChild(0));
+		next_ctr = get_ident(next->GetChild(1));
+	}
+	if(!incr || !next_ctr || next_ctr->GetLexerValue() != name
+		|| !std::holds_alternative<t_int>(*incr) || std::get<t_int>(*incr) <= 0)
+		return std::nullopt;
+
+	// the condition compares the counter with a limit: ctr < limit, ctr <= limit
+	const t_astbaseptr& cond = loop->GetCondition();
+	if(!cond || cond->GetType() != ASTType::BINARY)
+		return std::nullopt;
+
+	std::size_t opid = static_cast<const ASTBinary*>(cond.get())->GetOpId();
+	std::size_t ctr_idx = 0;
+	if(opid == '>' || opid == static_cast<std::size_t>(Token::GEQU))
+		ctr_idx = 1;
+	else if(opid != '<' && opid != static_cast<std::size_t>(Token::LEQU))
+		return std::nullopt;
+
+	const ASTToken<t_str>* cond_ctr = get_ident(cond->GetChild(ctr_idx));
+	if(!cond_ctr || cond_ctr->GetLexerValue() != name)
+		return std::nullopt;
+
+	t_consts vals = consts;
+	std::erase_if(vals, [&written](const auto& var) -> bool
+	{
+		return written.contains(var.first);
+	});
+
+	std::optional<t_const> limit = eval_const(cond->GetChild(1 - ctr_idx), vals);
+	if(!limit || !std::holds_alternative<t_int>(*limit))
+		return std::nullopt;
+
+	std::int64_t max_val = std::get<t_int>(*limit);
+	if(opid == '<' || opid == '>')
+		--max_val;
+
+	// the step must not overflow
+	if(max_val < std::get<t_int>(start->second)
+		|| max_val + std::get<t_int>(*incr) > std::numeric_limits<t_int>::max())
+		return std::nullopt;
+
+	return std::make_pair(name, std::make_pair(std::get<t_int>(start->second), static_cast<t_int>(max_val)));
+}
+
+
+/**
+ * get the values an integer expression can take from the ranges of its variables
+ * @return nullopt if the range is not known
+ */
+static std::optional<t_range> get_range(const t_astbaseptr& ast, const t_ranges& ranges)
+{
+	if(!ast)
+		return std::nullopt;
+
+	if(std::optional<t_const> val = get_const(ast); val)
+	{
+		if(!std::holds_alternative<t_int>(*val))
+			return std::nullopt;
+		return std::make_pair(std::get<t_int>(*val), std::get<t_int>(*val));
+	}
+
+	if(const ASTToken<t_str>* ident = get_ident(ast); ident)
+	{
+		auto iter = ranges.find(ident->GetLexerValue());
+		if(ident->IsLValue() || iter == ranges.end())
+			return std::nullopt;
+		return iter->second;
+	}
+
+	if(ast->GetType() != ASTType::BINARY)
+		return std::nullopt;
+	if(ast->GetDataType() == VMType::UNKNOWN)
+		ast->DeriveDataType();
+	if(ast->GetDataType() != VMType::INT)
+		return std::nullopt;
+
+	std::optional<t_range> range1 = get_range(ast->GetChild(0), ranges);
+	std::optional<t_range> range2 = get_range(ast->GetChild(1), ranges);
+	if(!range1 || !range2)
+		return std::nullopt;
+
+	// calculate the new range without overflow
+	const std::int64_t min1 = range1->first, max1 = range1->second;
+	const std::int64_t min2 = range2->first, max2 = range2->second;
+	std::int64_t min_val = 0, max_val = 0;
+
+	switch(static_cast<const ASTBinary*>(ast.get())->GetOpId())
+	{
+		case '+':
+		{
+			min_val = min1 + min2;
+			max_val = max1 + max2;
+			break;
+		}
+
+		case '-':
+		{
+			min_val = min1 - max2;
+			max_val = max1 - min2;
+			break;
+		}
+
+		case '*':
+		{
+			const std::int64_t prods[] = { min1*min2, min1*max2, max1*min2, max1*max2 };
+			min_val = *std::min_element(std::begin(prods), std::end(prods));
+			max_val = *std::max_element(std::begin(prods), std::end(prods));
+			break;
+		}
+
+		case '%':
+		{
+			// the remainder of a non-negative value
+			if(min1 < 0 || min2 != max2 || min2 <= 0)
+				return std::nullopt;
+			min_val = 0;
+			max_val = std::min(max1, min2 - 1);
+			break;
+		}
+
+		default:
+		{
+			return std::nullopt;
+		}
+	}
+
+	if(min_val < std::numeric_limits<t_int>::min() || max_val > std::numeric_limits<t_int>::max())
+		return std::nullopt;
+
+	return std::make_pair(static_cast<t_int>(min_val), static_cast<t_int>(max_val));
+}
+
+
+/**
+ * run a function with constant arguments in the vm
+ * @return nullopt if the function fails or does not return within the instruction budget
+ */
+static std::optional<t_const> run_call(const t_astbaseptr& call, const ASTFunc* func,
+	const EvalState& state)
+{
+	// program consisting of the call and the functions it can reach
+	auto prog = make_ast_node<ASTList>(nullptr, call->GetId(), 0);
+	std::vector<t_str> todo{func->GetName()};
+	t_vars needed{func->GetName()};
+
+	while(todo.size())
+	{
+		const t_str name = todo.back();
+		todo.pop_back();
+		prog->AddChild(state.funcs.at(name));
+
+		for(const t_str& callee : state.calls.at(name))
+		{
+			if(needed.insert(callee).second)
+				todo.push_back(callee);
+		}
+	}
+	prog->AddChild(call);
+
+	try
+	{
+		ASTAsm astasm{&get_default_ops()};
+		prog->accept(&astasm);
+		astasm.PatchFunctionAddresses();
+		astasm.FinishCodegen();
+		const std::vector<t_byte>& code = astasm.GetCode().GetCode();
+
+		VM vm(EVAL_MEM_SIZE, EVAL_FRAME_SIZE);
+		vm.SetMem(0, code.data(), code.size(), true);
+		vm.SetIP(0);
+		const t_int sp = vm.GetSP();
+
+		for(std::size_t num_ops = 0; !vm.IsHalted(); ++num_ops)
+		{
+			if(num_ops >= state.budget || !vm.Step())
+				return std::nullopt;
+		}
+
+		// the result is the only value left on the stack
+		if(func->GetDataType() == VMType::INT && vm.GetSP() == sp - t_int(sizeof(t_int)))
+			return vm.TopRaw<t_int>();
+		if(func->GetDataType() == VMType::REAL && vm.GetSP() == sp - t_int(sizeof(t_real)))
+			return vm.TopRaw<t_real>();
+	}
+	catch(const std::exception&)
+	{
+		// the error is reported when the call is run at runtime
+	}
+
+	return std::nullopt;
+}
+
+
+/**
+ * evaluate a call of a pure function with constant arguments at compile time
+ * @return nullopt if the call cannot be evaluated
+ */
+static std::optional<t_const> eval_call(const t_astbaseptr& ast, EvalState& state)
+{
+	const ASTFuncCall* call = static_cast<const ASTFuncCall*>(ast.get());
+	auto func = state.funcs.find(call->GetName());
+	if(func == state.funcs.end() || func->second->NumArgs() != call->NumArgs())
+		return std::nullopt;
+
+	// the arguments are passed as they are, so the call is identified by their types and bits
+	std::ostringstream key;
+	key << call->GetName();
+	for(std::size_t argidx=0; argidx<call->NumArgs(); ++argidx)
+	{
+		std::optional<t_const> arg = get_const(call->GetArgs()->GetChild(argidx));
+		if(!arg)
+			return std::nullopt;
+
+		if(std::holds_alternative<t_int>(*arg))
+			key << " i" << std::get<t_int>(*arg);
+		else
+			key << " r" << std::bit_cast<t_uint>(std::get<t_real>(*arg));
+	}
+
+	auto result = state.results.find(key.str());
+	if(result == state.results.end())
+	{
+		result = state.results.emplace(key.str(),
+			run_call(ast, func->second.get(), state)).first;
+	}
+
+	if(result->second)
+		state.evaluated.insert(call->GetName());
+	return result->second;
+}
+
+
+/**
+ * replace variables with known values by constants and fold constant expressions,
+ * the state contains the variable values before the node and is updated to the ones after it
+ */
+static t_astbaseptr propagate_consts(const t_astbaseptr& ast, PropagationState& state)
+{
+	if(!ast)
+		return ast;
+
+	auto count = [&state]() { if(state.opt_ctr) ++*state.opt_ctr; };
+
+	switch(ast->GetType())
+	{
+		case ASTType::TOKEN:
+		{
+			const ASTToken<t_str>* ident = get_ident(ast);
+			if(!ident || ident->IsLValue())
+				break;
+
+			auto iter = state.consts.find(ident->GetLexerValue());
+			if(iter == state.consts.end())
+				break;
+
+			count();
+			return make_const(ast, iter->second);
+		}
+
+		case ASTType::UNARY:
+		{
+			ast->SetChild(0, propagate_consts(ast->GetChild(0), state));
+
+			std::size_t opid = static_cast<const ASTUnary*>(ast.get())->GetOpId();
+			if(std::optional<t_const> val = get_const(ast->GetChild(0)); val)
+			{
+				if(std::optional<t_const> result = fold_unary(opid, *val); result)
+				{
+					count();
+					return make_const(ast, *result);
+				}
+			}
+			break;
+		}
+
+		case ASTType::BINARY:
+		{
+			std::size_t opid = static_cast<const ASTBinary*>(ast.get())->GetOpId();
+
+			// assignment
+			if(opid == '=')
+			{
+				ast->SetChild(0, propagate_consts(ast->GetChild(0), state));
+
+				const ASTToken<t_str>* ident = get_ident(ast->GetChild(1));
+				if(!ident)
+					break;
+
+				// the value is converted to the variable type
+				std::optional<t_const> val;
+				if(std::optional<t_const> rhs = get_const(ast->GetChild(0)); rhs && state.safe)
+					val = convert_const(*rhs, ident->GetDataType());
+
+				if(val)
+					state.consts.insert_or_assign(ident->GetLexerValue(), *val);
+				else
+					state.consts.erase(ident->GetLexerValue());
+				break;
+			}
+
+			ast->SetChild(0, propagate_consts(ast->GetChild(0), state));
+
+			// the rhs of logical operations is not evaluated if the lhs gives the result
+			if(opid == static_cast<std::size_t>(Token::AND) || opid == static_cast<std::size_t>(Token::OR))
+			{
+				PropagationState rhs_state = state;
+				ast->SetChild(1, propagate_consts(ast->GetChild(1), rhs_state));
+				merge_consts(state.consts, rhs_state.consts);
+			}
+			else
+			{
+				ast->SetChild(1, propagate_consts(ast->GetChild(1), state));
+			}
+
+			if(ast->GetDataType() == VMType::UNKNOWN)
+				ast->DeriveDataType();
+
+			std::optional<t_const> val1 = get_const(ast->GetChild(0));
+			std::optional<t_const> val2 = get_const(ast->GetChild(1));
+			if(val1 && val2)
+			{
+				if(std::optional<t_const> result = fold_binary(opid,
+					ast->GetDataType(), *val1, *val2); result)
+				{
+					count();
+					return make_const(ast, *result);
+				}
+			}
+			else if(val1 || val2)
+			{
+				if(t_astbaseptr simplified = simplify_binary(ast); simplified)
+				{
+					count();
+					return simplified;
+				}
+			}
+			break;
+		}
+
+		case ASTType::CONDITION:
+		{
+			auto cond = std::static_pointer_cast<ASTCondition>(ast);
+			cond->SetCondition(propagate_consts(cond->GetCondition(), state));
+
+			// only keep the block which is run for a constant condition
+			if(std::optional<t_const> val = get_const(cond->GetCondition()); val)
+			{
+				count();
+
+				t_astbaseptr block = is_true(*val) ? cond->GetIfBlock() : cond->GetElseBlock();
+				if(!block)
+					block = make_ast_node<ASTList>(nullptr, ast->GetId(), 0);
+				return propagate_consts(block, state);
+			}
+
+			PropagationState else_state = state;
+			cond->SetIfBlock(propagate_consts(cond->GetIfBlock(), state));
+			if(cond->GetElseBlock())
+				cond->SetElseBlock(propagate_consts(cond->GetElseBlock(), else_state));
+
+			// merge the values of the blocks which continue after the condition
+			if(ends_with_jump(cond->GetIfBlock()))
+			{
+				state.consts = std::move(else_state.consts);
+			}
+			else if(!ends_with_jump(cond->GetElseBlock()))
+			{
+				merge_consts(state.consts, else_state.consts);
+			}
+			break;
+		}
+
+		case ASTType::LOOP:
+		{
+			auto loop = std::static_pointer_cast<ASTLoop>(ast);
+
+			// the counter takes the same values in the unrolled block
+			std::optional<std::pair<t_str, t_range>> counter = get_counter_range(loop.get(), state.consts);
+
+			// replace loops with few iterations by their unrolled statements
+			if(t_astbaseptr unrolled = unroll_loop(loop, state); unrolled)
+			{
+				count();
+				return propagate_consts(unrolled, state);
+			}
+
+			// variables assigned in the loop can change between iterations
+			t_vars assigned;
+			get_vars(ast, assigned, false, true);
+			for(const t_str& var : assigned)
+			{
+				state.consts.erase(var);
+				state.ranges.erase(var);
+			}
+
+			PropagationState loop_state = state;
+			loop->SetCondition(propagate_consts(loop->GetCondition(), loop_state));
+
+			// remove loops which never run
+			if(std::optional<t_const> val = get_const(loop->GetCondition()); val && !is_true(*val))
+			{
+				count();
+				return make_ast_node<ASTList>(nullptr, ast->GetId(), 0);
+			}
+
+			if(counter)
+				loop_state.ranges.insert_or_assign(counter->first, counter->second);
+			loop->SetBlock(propagate_consts(loop->GetBlock(), loop_state));
+			break;
+		}
+
+		case ASTType::ARRAY_ACCESS:
+		{
+			// the code generator evaluates the rhs before the index
+			auto access = std::static_pointer_cast<ASTArrayAccess>(ast);
+			if(access->IsLValue())
+				access->SetChild(2, propagate_consts(access->GetExpr(), state));
+			access->SetChild(1, propagate_consts(access->GetIndex(), state));
+
+			// the index does not need to be checked if its range is within the array's size
+			if(std::optional<t_range> range = get_range(access->GetIndex(), state.ranges); range)
+			{
+				if(const std::optional<t_range>& old_range = access->GetIndexRange(); old_range)
+				{
+					range->first = std::max(range->first, old_range->first);
+					range->second = std::min(range->second, old_range->second);
+				}
+				access->SetIndexRange(range);
+			}
+			break;
+		}
+
+		case ASTType::FUNC:
+		{
+			// functions have their own scope and do not see the outer variables
+			auto func = std::static_pointer_cast<ASTFunc>(ast);
+
+			PropagationState func_state
+			{
+				.consts = {},
+				.ranges = {},
+				.safe = !uses_addresses(func->GetBlock()),
+				.unroll = state.unroll,
+				.unrolled = state.unrolled,
+				.eval = state.eval,
+				.opt_ctr = state.opt_ctr,
+			};
+
+			func->SetBlock(propagate_consts(func->GetBlock(), func_state));
+			break;
+		}
+
+		case ASTType::FUNCCALL:
+		{
+			auto call = std::static_pointer_cast<ASTFuncCall>(ast);
+			if(call->GetArgs())
+				call->SetArgs(propagate_consts(call->GetArgs(), state));
+
+			// replace calls of pure functions with constant arguments by their results
+			if(!state.eval || !state.eval->budget)
+				break;
+			if(std::optional<t_const> val = eval_call(ast, *state.eval); val)
+			{
+				count();
+				return make_const(ast, *val);
+			}
+			break;
+		}
+
+		case ASTType::JUMP:
+		{
+			// the break and continue arguments are loop depths
+			auto jump = std::static_pointer_cast<ASTJump>(ast);
+			if(jump->GetJumpType() == ASTJump::JumpType::RETURN)
+				jump->SetExpr(propagate_consts(jump->GetExpr(), state));
+			break;
+		}
+
+		default:
+		{
+			for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+				ast->SetChild(childidx, propagate_consts(ast->GetChild(childidx), state));
+			break;
+		}
+	}
+
+	return ast;
+}
+
+
+/**
+ * remove assignments to variables which are not read afterwards,
+ * the live variables after the statement are updated to the ones before it
+ * @return the statement or nullptr if it has been removed
+ */
+static t_astbaseptr remove_dead_assignments(const t_astbaseptr& ast,
+	t_vars& live, LivenessState& state)
+{
+	if(!ast)
+		return ast;
+
+	switch(ast->GetType())
+	{
+		case ASTType::LIST:
+		{
+			auto list = std::static_pointer_cast<ASTList>(ast);
+
+			for(std::size_t childidx=list->NumChildren(); childidx>0; --childidx)
+			{
+				t_astbaseptr stmt = remove_dead_assignments(
+					list->GetChild(childidx-1), live, state);
+
+				if(stmt)
+					list->SetChild(childidx-1, stmt);
+				else
+					list->RemoveChild(childidx-1);
+			}
+			break;
+		}
+
+		case ASTType::BINARY:
+		{
+			const ASTToken<t_str>* ident = get_ident(ast->GetChild(1));
+			if(static_cast<const ASTBinary*>(ast.get())->GetOpId() != '=' || !ident)
+			{
+				get_vars(ast, live, true, false);
+				break;
+			}
+
+			const t_str& var = ident->GetLexerValue();
+			if(state.safe && !live.contains(var) && !has_side_effects(ast->GetChild(0)))
+			{
+				if(state.opt_ctr)
+					++*state.opt_ctr;
+				return nullptr;
+			}
+
+			live.erase(var);
+			get_vars(ast->GetChild(0), live, true, false);
+			break;
+		}
+
+		case ASTType::CONDITION:
+		{
+			auto cond = std::static_pointer_cast<ASTCondition>(ast);
+
+			t_vars else_live = live;
+			if(cond->GetElseBlock())
+				cond->SetElseBlock(remove_dead_assignments(cond->GetElseBlock(), else_live, state));
+			cond->SetIfBlock(remove_dead_assignments(cond->GetIfBlock(), live, state));
+
+			live.merge(else_live);
+			get_vars(cond->GetCondition(), live, true, false);
+			break;
+		}
+
+		case ASTType::LOOP:
+		{
+			// all variables read in the loop stay live across its iterations
+			auto loop = std::static_pointer_cast<ASTLoop>(ast);
+			get_vars(ast, live, true, false);
+
+			state.loops.push_back(live);
+			t_vars block_live = live;
+			loop->SetBlock(remove_dead_assignments(loop->GetBlock(), block_live, state));
+			state.loops.pop_back();
+			break;
+		}
+
+		case ASTType::FUNC:
+		{
+			// the local variables are not live after the function
+			auto func = std::static_pointer_cast<ASTFunc>(ast);
+
+			LivenessState func_state
+			{
+				.safe = !uses_addresses(func->GetBlock()),
+				.loops = {},
+				.opt_ctr = state.opt_ctr,
+			};
+
+			t_vars func_live;
+			func->SetBlock(remove_dead_assignments(func->GetBlock(), func_live, func_state));
+			break;
+		}
+
+		case ASTType::JUMP:
+		{
+			auto jump = std::static_pointer_cast<ASTJump>(ast);
+
+			if(jump->GetJumpType() == ASTJump::JumpType::RETURN)
+			{
+				live.clear();
+				get_vars(jump->GetExpr(), live, true, false);
+			}
+			else
+			{
+				// continue at the head or the end of one of the enclosing loops
+				for(const t_vars& loop_live : state.loops)
+					live.insert(loop_live.begin(), loop_live.end());
+			}
+			break;
+		}
+
+		default:
+		{
+			get_vars(ast, live, true, false);
+			break;
+		}
+	}
+
+	return ast;
+}
+
+
+/**
+ * can the expression be evaluated before the loop?
+ * it must not have side effects or read variables which are written in the loop,
+ * integer divisions are only moved if their divisor is a constant which does not trap
+ */
+static bool is_invariant(const t_astbaseptr& ast, const t_vars& written)
+{
+	if(!ast)
+		return false;
+
+	switch(ast->GetType())
+	{
+		case ASTType::TOKEN:
+		{
+			if(const ASTToken<t_str>* ident = get_ident(ast); ident)
+				return !ident->IsLValue() && !written.contains(ident->GetLexerValue());
+			return get_const(ast).has_value();
+		}
+
+		case ASTType::UNARY:
+		{
+			return is_invariant(ast->GetChild(0), written);
+		}
+
+		case ASTType::BINARY:
+		{
+			const ASTBinary* binary = static_cast<const ASTBinary*>(ast.get());
+			if(binary->GetOpId() == '=' || may_trap(binary))
+				return false;
+
+			return is_invariant(ast->GetChild(0), written)
+				&& is_invariant(ast->GetChild(1), written);
+		}
+
+		default:
+		{
+			return false;
+		}
+	}
+}
+
+
+/**
+ * replace the largest loop-invariant expressions by temporary variables
+ * @param written variables which are assigned in the loop
+ * @param hoisted assignments of the temporary variables to run before the loop
+ */
+static t_astbaseptr hoist_invariants(const t_astbaseptr& ast, const t_vars& written,
+	std::vector<t_astbaseptr>& hoisted, InvariantState& state)
+{
+	if(!ast)
+		return ast;
+
+	switch(ast->GetType())
+	{
+		case ASTType::UNARY:
+		case ASTType::BINARY:
+		{
+			if(ast->GetDataType() == VMType::UNKNOWN)
+				ast->DeriveDataType();
+			const VMType ty = ast->GetDataType();
+
+			// constant expressions which could not be folded are kept
+			t_vars read;
+			get_vars(ast, read, true, false);
+
+			if((ty == VMType::INT || ty == VMType::REAL)
+				&& read.size() && is_invariant(ast, written))
+			{
+				const t_str name = t_str{"loop"} + TEMP_SEP + std::to_string(++state.num_temps);
+				hoisted.push_back(make_assign(ast, name, ty, ast));
+				if(state.opt_ctr)
+					++*state.opt_ctr;
+
+				return make_var(ast, name, ty, false);
+			}
+			break;
+		}
+
+		case ASTType::JUMP:
+		{
+			// the break and continue arguments are loop depths
+			auto jump = std::static_pointer_cast<ASTJump>(ast);
+			if(jump->GetJumpType() == ASTJump::JumpType::RETURN)
+				jump->SetExpr(hoist_invariants(jump->GetExpr(), written, hoisted, state));
+			return ast;
+		}
+
+		default:
+		{
+			break;
+		}
+	}
+
+	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+		ast->SetChild(childidx, hoist_invariants(ast->GetChild(childidx), written, hoisted, state));
+
+	return ast;
+}
+
+
+/**
+ * move the loop-invariant expressions in front of the loops, starting with the outermost ones
+ * @param safe no addresses are taken or dereferenced in the scope
+ */
+static void hoist_loop_invariants(const t_astbaseptr& ast, bool safe, InvariantState& state)
+{
+	if(!ast || ast->GetType() != ASTType::LIST)
+		return;
+
+	auto list = std::static_pointer_cast<ASTList>(ast);
+	for(std::size_t stmtidx=0; stmtidx<list->NumChildren(); ++stmtidx)
+	{
+		const t_astbaseptr stmt = list->GetChild(stmtidx);
+
+		switch(stmt->GetType())
+		{
+			case ASTType::FUNC:
+			{
+				const t_astbaseptr& block = stmt->GetChild(1);
+				hoist_loop_invariants(block, !uses_addresses(block), state);
+				break;
+			}
+
+			case ASTType::LIST:
+			{
+				hoist_loop_invariants(stmt, safe, state);
+				break;
+			}
+
+			case ASTType::CONDITION:
+			{
+				auto cond = std::static_pointer_cast<ASTCondition>(stmt);
+				hoist_loop_invariants(cond->GetIfBlock(), safe, state);
+				hoist_loop_invariants(cond->GetElseBlock(), safe, state);
+				break;
+			}
+
+			case ASTType::LOOP:
+			{
+				// variables can change via their addresses
+				if(!safe)
+					break;
+
+				auto loop = std::static_pointer_cast<ASTLoop>(stmt);
+				t_vars written;
+				get_vars(stmt, written, false, true);
+
+				std::vector<t_astbaseptr> hoisted;
+				loop->SetCondition(hoist_invariants(loop->GetCondition(), written, hoisted, state));
+				loop->SetBlock(hoist_invariants(loop->GetBlock(), written, hoisted, state));
+
+				// the remaining expressions can be invariant in the inner loops
+				hoist_loop_invariants(loop->GetBlock(), safe, state);
+
+				for(const t_astbaseptr& hoisted_stmt : hoisted)
+					list->InsertChild(stmtidx++, hoisted_stmt);
+				break;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+	}
+}
 
 
 
 /**
- * optimise constant expressions in binary ast node
+ * collect the names of the functions which are called or whose addresses are taken
  */
-template<class t_val>
-t_astbaseptr ast_optimise_bin(std::shared_ptr<ASTBinary>& astbin, t_astbaseptr& _child1, t_astbaseptr& _child2)
+static void get_used_funcs(const t_astbaseptr& ast, t_vars& funcs)
+{
+	if(!ast)
+		return;
+
+	if(ast->GetType() == ASTType::FUNCCALL)
+		funcs.insert(static_cast<const ASTFuncCall*>(ast.get())->GetName());
+	else if(ast->GetType() == ASTType::ADDROF)
+		funcs.insert(static_cast<const ASTAddrOf*>(ast.get())->GetName());
+
+	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+		get_used_funcs(ast->GetChild(childidx), funcs);
+}
+
+
+/**
+ * collect the function definitions
+ */
+static void get_funcs(const t_astbaseptr& ast, std::vector<std::shared_ptr<ASTFunc>>& funcs)
 {
-	auto child1 = static_pointer_cast<ASTToken<t_val>>(_child1);
-	auto child2 = static_pointer_cast<ASTToken<t_val>>(_child2);
+	if(!ast)
+		return;
 
-	switch(astbin->GetOpId())
+	if(ast->GetType() == ASTType::FUNC)
 	{
-		case '+':
-		{
-			child1->SetLexerValue(child1->GetLexerValue() + child2->GetLexerValue());
-			return child1;
-		}
-		case '-':
+		funcs.push_back(std::static_pointer_cast<ASTFunc>(ast));
+		return;
+	}
+
+	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+		get_funcs(ast->GetChild(childidx), funcs);
+}
+
+
+/**
+ * can the function call itself, directly or via other functions?
+ */
+static bool is_recursive(const t_str& func, const std::unordered_map<t_str, t_vars>& calls)
+{
+	std::vector<t_str> todo{func};
+	t_vars seen;
+
+	while(todo.size())
+	{
+		auto iter = calls.find(todo.back());
+		todo.pop_back();
+		if(iter == calls.end())
+			continue;
+
+		for(const t_str& callee : iter->second)
 		{
-			child1->SetLexerValue(child1->GetLexerValue() - child2->GetLexerValue());
-			return child1;
+			if(callee == func)
+				return true;
+			if(seen.insert(callee).second)
+				todo.push_back(callee);
 		}
-		case '*':
+	}
+
+	return false;
+}
+
+
+/**
+ * can the function be inlined?
+ * it must not be recursive, declare no arrays, and only return at the end of its block
+ */
+static bool is_inlinable_func(const ASTFunc* func, std::size_t max_size,
+	const std::unordered_map<t_str, t_vars>& calls)
+{
+	if(func->GetDataType() != VMType::INT && func->GetDataType() != VMType::REAL)
+		return false;
+
+	const t_astbaseptr& block = func->GetBlock();
+	if(!block || block->GetType() != ASTType::LIST || !block->NumChildren())
+		return false;
+	if(count_nodes(block) > max_size || uses_addresses(block))
+		return false;
+
+	// the arrays would have to fit into the caller's frame
+	if(declares_arrays(block))
+		return false;
+
+	for(std::size_t argidx=0; argidx<func->NumArgs(); ++argidx)
+	{
+		const ASTToken<t_str>* arg = get_ident(func->GetArgs()->GetChild(argidx));
+		if(!arg || (arg->GetDataType() != VMType::INT && arg->GetDataType() != VMType::REAL))
+			return false;
+	}
+
+	// the last statement returns the result
+	const t_astbaseptr& ret = block->GetChild(block->NumChildren() - 1);
+	if(ret->GetType() != ASTType::JUMP || !ret->GetChild(0)
+		|| static_cast<const ASTJump*>(ret.get())->GetJumpType() != ASTJump::JumpType::RETURN
+		|| !is_self_contained(ret->GetChild(0)))
+		return false;
+
+	for(std::size_t stmtidx=0; stmtidx+1<block->NumChildren(); ++stmtidx)
+	{
+		if(!is_self_contained(block->GetChild(stmtidx)))
+			return false;
+	}
+
+	return !is_recursive(func->GetName(), calls);
+}
+
+
+/**
+ * find the functions which can be inlined
+ */
+static void get_inlinable_funcs(const t_astbaseptr& ast, std::size_t max_size, InlineState& state)
+{
+	std::vector<std::shared_ptr<ASTFunc>> funcs;
+	get_funcs(ast, funcs);
+
+	// call graph
+	std::unordered_map<t_str, t_vars> calls;
+	std::unordered_map<t_str, std::size_t> num_defs;
+	for(const auto& func : funcs)
+	{
+		get_used_funcs(func->GetBlock(), calls[func->GetName()]);
+		++num_defs[func->GetName()];
+	}
+
+	state.funcs.clear();
+	for(const auto& func : funcs)
+	{
+		if(num_defs[func->GetName()] == 1 && is_inlinable_func(func.get(), max_size, calls))
+			state.funcs.emplace(func->GetName(), func);
+	}
+}
+
+
+/**
+ * find the functions which can be evaluated at compile time,
+ * as functions do not see the global variables, their results only depend on their arguments
+ * if they neither use addresses nor call functions which do
+ */
+static void get_pure_funcs(const t_astbaseptr& ast, EvalState& state)
+{
+	std::vector<std::shared_ptr<ASTFunc>> funcs;
+	get_funcs(ast, funcs);
+
+	std::unordered_map<t_str, std::size_t> num_defs;
+	for(const auto& func : funcs)
+		++num_defs[func->GetName()];
+
+	state.funcs.clear();
+	state.calls.clear();
+	for(const auto& func : funcs)
+	{
+		if(func->GetDataType() != VMType::INT && func->GetDataType() != VMType::REAL)
+			continue;
+		if(num_defs[func->GetName()] != 1 || uses_addresses(func->GetBlock()))
+			continue;
+
+		state.funcs.emplace(func->GetName(), func);
+		get_used_funcs(func->GetBlock(), state.calls[func->GetName()]);
+	}
+
+	// remove the functions which call unknown or impure ones
+	for(bool removed = true; removed;)
+	{
+		removed = false;
+
+		for(auto iter = state.funcs.begin(); iter != state.funcs.end();)
 		{
-			child1->SetLexerValue(child1->GetLexerValue() * child2->GetLexerValue());
-			return child1;
+			const t_vars& callees = state.calls[iter->first];
+			if(std::all_of(callees.begin(), callees.end(), [&state](const t_str& callee) -> bool
+			{
+				return state.funcs.contains(callee);
+			}))
+			{
+				++iter;
+				continue;
+			}
+
+			state.calls.erase(iter->first);
+			iter = state.funcs.erase(iter);
+			removed = true;
 		}
-		case '/':
+	}
+}
+
+
+/**
+ * replace a call by the returned expression if the function consists only of it,
+ * this is done if the arguments are variables or constants, which can be read at any time
+ * @return the expression or nullptr if the function cannot be inlined this way
+ */
+static t_astbaseptr inline_expr_func(const ASTFuncCall* call, const ASTFunc* func)
+{
+	const t_astbaseptr& block = func->GetBlock();
+	if(block->NumChildren() != 1)
+		return nullptr;
+
+	// the expression has to have the return type, otherwise it would be cast differently
+	const t_astbaseptr& expr = block->GetChild(0)->GetChild(0);
+	if(expr->GetDataType() == VMType::UNKNOWN)
+		expr->DeriveDataType();
+	if(expr->GetDataType() != func->GetDataType())
+		return nullptr;
+
+	// the call pushes the arguments in reverse order
+	const std::size_t num_args = func->NumArgs();
+	std::unordered_map<t_str, t_astbaseptr> args;
+	for(std::size_t argidx=0; argidx<num_args; ++argidx)
+	{
+		const t_astbaseptr& arg = call->GetArgs()->GetChild(num_args - argidx - 1);
+		const ASTToken<t_str>* ident = get_ident(arg);
+		if((!ident || ident->IsLValue()) && !get_const(arg))
+			return nullptr;
+
+		args.emplace(get_ident(func->GetArgs()->GetChild(argidx))->GetLexerValue(), arg);
+	}
+
+	// the expression must only read the arguments
+	t_vars read, written;
+	get_vars(expr, read, true, false);
+	get_vars(expr, written, false, true);
+	if(written.size())
+		return nullptr;
+	for(const t_str& var : read)
+	{
+		if(!args.contains(var))
+			return nullptr;
+	}
+
+	return copy_ast(expr, "", &args);
+}
+
+
+/**
+ * inline a call by running the function's statements before the statement containing the call,
+ * the arguments and local variables of the function get new names in the caller's scope
+ * @return the variable holding the result, which replaces the call
+ */
+static t_astbaseptr inline_stmt_func(const t_astbaseptr& call, const ASTFunc* func,
+	std::vector<t_astbaseptr>& hoisted, InlineState& state)
+{
+	const t_str prefix = func->GetName() + TEMP_SEP + std::to_string(++state.num_calls);
+	const t_astbaseptr& args = call->GetChild(0);
+	const t_astbaseptr& block = func->GetBlock();
+
+	t_vars written;
+	get_vars(block, written, false, true);
+
+	// assign the arguments in the order in which the call evaluates them,
+	// variables and constants are used directly if the function does not change the argument
+	const std::size_t num_args = func->NumArgs();
+	std::unordered_map<t_str, t_astbaseptr> subst;
+	for(std::size_t argidx=0; argidx<num_args; ++argidx)
+	{
+		const t_astbaseptr& arg = args->GetChild(argidx);
+		const ASTToken<t_str>* param = get_ident(func->GetArgs()->GetChild(num_args - argidx - 1));
+		const ASTToken<t_str>* ident = get_ident(arg);
+
+		if(!written.contains(param->GetLexerValue()) && ((ident && !ident->IsLValue()) || get_const(arg)))
 		{
-			child1->SetLexerValue(child1->GetLexerValue() / child2->GetLexerValue());
-			return child1;
+			subst.emplace(param->GetLexerValue(), arg);
+			continue;
 		}
-		case '%':
+
+		hoisted.push_back(make_assign(call, prefix + TEMP_SEP + param->GetLexerValue(),
+			param->GetDataType(), arg));
+	}
+
+	// run the statements and assign the returned value
+	const std::size_t num_stmts = block->NumChildren();
+	for(std::size_t stmtidx=0; stmtidx+1<num_stmts; ++stmtidx)
+		hoisted.push_back(copy_ast(block->GetChild(stmtidx), prefix, &subst));
+
+	const t_astbaseptr& expr = block->GetChild(num_stmts - 1)->GetChild(0);
+	hoisted.push_back(make_assign(call, prefix, func->GetDataType(), copy_ast(expr, prefix, &subst)));
+
+	return make_var(call, prefix, func->GetDataType(), false);
+}
+
+
+/**
+ * inline the function calls in an expression, which is traversed in the order of its evaluation
+ * @param hoisted statements to run before the expression, nullptr if nothing can be moved before it
+ * @param impure has an expression with side effects been evaluated before?
+ */
+static t_astbaseptr inline_expr(const t_astbaseptr& ast, std::vector<t_astbaseptr>* hoisted,
+	bool& impure, InlineState& state)
+{
+	if(!ast)
+		return ast;
+
+	switch(ast->GetType())
+	{
+		case ASTType::FUNCCALL:
 		{
-			if constexpr(std::is_same_v<t_val, t_int>)
+			const bool impure_before = impure;
+			const ASTFuncCall* call = static_cast<const ASTFuncCall*>(ast.get());
+			if(call->GetArgs())
+				ast->SetChild(0, inline_expr(call->GetArgs(), hoisted, impure, state));
+
+			if(ast->GetDataType() == VMType::UNKNOWN)
+				ast->DeriveDataType();
+
+			// the call and return types have to match, otherwise the call needs a cast
+			auto iter = state.funcs.find(call->GetName());
+			const ASTFunc* func = iter == state.funcs.end() ? nullptr : iter->second.get();
+			bool inlinable = func && func->NumArgs() == call->NumArgs()
+				&& call->GetDataType() == func->GetDataType();
+
+			// the arguments are passed without a cast
+			for(std::size_t argidx=0; inlinable && argidx<call->NumArgs(); ++argidx)
 			{
-				child1->SetLexerValue(child1->GetLexerValue() % child2->GetLexerValue());
-				return child1;
+				inlinable = call->GetArgs()->GetChild(argidx)->GetDataType()
+					== func->GetArgs()->GetChild(call->NumArgs() - argidx - 1)->GetDataType();
 			}
-			else if constexpr(std::is_same_v<t_val, t_real>)
+
+			if(inlinable)
 			{
-				child1->SetLexerValue(std::fmod(child1->GetLexerValue(), child2->GetLexerValue()));
-				return child1;
+				t_astbaseptr inlined = inline_expr_func(call, func);
+
+				// the function's statements can only be moved before the statement
+				// if nothing evaluated before the call has side effects
+				if(!inlined && hoisted && !impure_before)
+					inlined = inline_stmt_func(ast, func, *hoisted, state);
+
+				if(inlined)
+				{
+					state.inlined.insert(func->GetName());
+					if(state.opt_ctr)
+						++*state.opt_ctr;
+
+					impure = impure || has_side_effects(inlined);
+					return inlined;
+				}
 			}
+
+			impure = true;
+			return ast;
+		}
+
+		case ASTType::BINARY:
+		{
+			const std::size_t opid = static_cast<const ASTBinary*>(ast.get())->GetOpId();
+			ast->SetChild(0, inline_expr(ast->GetChild(0), hoisted, impure, state));
+
+			// the rhs of logical operations is not necessarily evaluated
+			if(opid == static_cast<std::size_t>(Token::AND) || opid == static_cast<std::size_t>(Token::OR))
+				ast->SetChild(1, inline_expr(ast->GetChild(1), nullptr, impure, state));
+			else
+				ast->SetChild(1, inline_expr(ast->GetChild(1), hoisted, impure, state));
+
+			if(opid == '=')
+				impure = true;
 			break;
 		}
-		case '^':
+
+		case ASTType::DEREF:
+		{
+			// the rhs is evaluated before the address
+			ast->SetChild(1, inline_expr(ast->GetChild(1), hoisted, impure, state));
+			ast->SetChild(0, inline_expr(ast->GetChild(0), hoisted, impure, state));
+			impure = true;
+			break;
+		}
+
+		case ASTType::ARRAY_ACCESS:
 		{
-			child1->SetLexerValue(::pow<t_val>(child1->GetLexerValue(), child2->GetLexerValue()));
-			return child1;
+			// the rhs is evaluated before the index
+			const bool lval = static_cast<const ASTArrayAccess*>(ast.get())->IsLValue();
+			if(lval)
+				ast->SetChild(2, inline_expr(ast->GetChild(2), hoisted, impure, state));
+			ast->SetChild(1, inline_expr(ast->GetChild(1), hoisted, impure, state));
+			if(lval)
+				impure = true;
+			break;
 		}
+
 		default:
+		{
+			for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
+				ast->SetChild(childidx, inline_expr(ast->GetChild(childidx), hoisted, impure, state));
 			break;
+		}
 	}
 
-	// no optimisation
-	return nullptr;
+	return ast;
 }
 
 
-
 /**
- * optimise the ast
+ * inline the function calls in the statements of a block
+ * @param safe no addresses are taken or dereferenced in the scope
  */
-t_astbaseptr ast_optimise(t_astbaseptr& ast, std::size_t *opt_ctr)
+static void inline_calls(const t_astbaseptr& ast, bool safe, InlineState& state)
 {
-	for(std::size_t childidx=0; childidx<ast->NumChildren(); ++childidx)
-	{
-		auto child = ast->GetChild(childidx);
-		auto new_child = ast_optimise(child, opt_ctr);
-		ast->SetChild(childidx, new_child);
-	}
+	if(!ast || ast->GetType() != ASTType::LIST)
+		return;
 
-	// simplify constant expressions
-	if(ast->GetType() == ASTType::BINARY)
+	auto list = std::static_pointer_cast<ASTList>(ast);
+	for(std::size_t stmtidx=0; stmtidx<list->NumChildren(); ++stmtidx)
 	{
-		auto astbin = static_pointer_cast<ASTBinary>(ast);
+		const t_astbaseptr& stmt = list->GetChild(stmtidx);
+
+		if(stmt->GetType() == ASTType::FUNC)
+		{
+			const t_astbaseptr& block = stmt->GetChild(1);
+			inline_calls(block, !uses_addresses(block), state);
+			continue;
+		}
+
+		// variables can change via their addresses while the inlined statements run
+		if(!safe)
+			continue;
 
-		auto child1 = astbin->GetChild(0);
-		auto child2 = astbin->GetChild(1);
+		std::vector<t_astbaseptr> hoisted;
+		bool impure = false;
 
-		if(child1->GetType() == ASTType::TOKEN && child2->GetType() == ASTType::TOKEN
-			&& child1->GetDataType() == child2->GetDataType())
+		switch(stmt->GetType())
 		{
-			t_astbaseptr newast = nullptr;
+			case ASTType::LIST:
+			{
+				inline_calls(stmt, safe, state);
+				break;
+			}
 
-			switch(child1->GetDataType())
+			case ASTType::CONDITION:
 			{
-				case VMType::INT:
-					newast = ast_optimise_bin<t_int>(astbin, child1, child2);
-					break;
-				case VMType::REAL:
-					newast = ast_optimise_bin<t_real>(astbin, child1, child2);
-					break;
-				default:
-					break;
+				auto cond = std::static_pointer_cast<ASTCondition>(stmt);
+				cond->SetCondition(inline_expr(cond->GetCondition(), &hoisted, impure, state));
+				inline_calls(cond->GetIfBlock(), safe, state);
+				inline_calls(cond->GetElseBlock(), safe, state);
+				break;
+			}
+
+			case ASTType::LOOP:
+			{
+				// the condition is evaluated in every iteration
+				auto loop = std::static_pointer_cast<ASTLoop>(stmt);
+				loop->SetCondition(inline_expr(loop->GetCondition(), nullptr, impure, state));
+				inline_calls(loop->GetBlock(), safe, state);
+				break;
 			}
 
-			if(newast)
+			default:
 			{
-				if(opt_ctr) ++*opt_ctr;
-				return newast;
+				list->SetChild(stmtidx, inline_expr(stmt, &hoisted, impure, state));
+				break;
 			}
 		}
+
+		for(const t_astbaseptr& hoisted_stmt : hoisted)
+			list->InsertChild(stmtidx++, hoisted_stmt);
+	}
+}
+
+
+/**
+ * remove the inlined or evaluated functions which are not called anymore
+ */
+static void remove_unused_funcs(const t_astbaseptr& ast, const t_vars& removable, std::size_t *opt_ctr)
+{
+	if(!ast || ast->GetType() != ASTType::LIST)
+		return;
+	auto list = std::static_pointer_cast<ASTList>(ast);
+
+	// functions called by the global statements and the functions which are kept
+	t_vars used;
+	std::unordered_map<t_str, t_vars> calls;
+	for(std::size_t stmtidx=0; stmtidx<list->NumChildren(); ++stmtidx)
+	{
+		const t_astbaseptr& stmt = list->GetChild(stmtidx);
+		if(stmt->GetType() != ASTType::FUNC)
+		{
+			get_used_funcs(stmt, used);
+			continue;
+		}
+
+		const ASTFunc* func = static_cast<const ASTFunc*>(stmt.get());
+		if(removable.contains(func->GetName()))
+			get_used_funcs(func->GetBlock(), calls[func->GetName()]);
+		else
+			get_used_funcs(func->GetBlock(), used);
+	}
+
+	// the functions called by used ones are also used, recursive calls alone do not count
+	std::vector<t_str> todo(used.begin(), used.end());
+	while(todo.size())
+	{
+		auto iter = calls.find(todo.back());
+		todo.pop_back();
+		if(iter == calls.end())
+			continue;
+
+		for(const t_str& callee : iter->second)
+		{
+			if(used.insert(callee).second)
+				todo.push_back(callee);
+		}
+	}
+
+	for(std::size_t stmtidx=list->NumChildren(); stmtidx>0; --stmtidx)
+	{
+		const t_astbaseptr& stmt = list->GetChild(stmtidx-1);
+		if(stmt->GetType() != ASTType::FUNC)
+			continue;
+
+		const t_str& name = static_cast<const ASTFunc*>(stmt.get())->GetName();
+		if(!removable.contains(name) || used.contains(name))
+			continue;
+
+		list->RemoveChild(stmtidx-1);
+		if(opt_ctr)
+			++*opt_ctr;
+	}
+}
+
+
+
+/**
+ * optimise the ast,
+ * the functions of modules are kept for calls from other modules
+ */
+t_astbaseptr ast_optimise(t_astbaseptr& ast, std::size_t *opt_ctr,
+	std::size_t inline_size, std::size_t unroll_factor, std::size_t eval_budget,
+	bool keep_funcs, t_optimise_times *times)
+{
+	// measure the time since the previous step
+	auto last_time = std::chrono::steady_clock::now();
+	auto step_done = [times, &last_time](const std::string& step)
+	{
+		if(!times)
+			return;
+
+		auto now = std::chrono::steady_clock::now();
+		times->emplace_back(step, std::chrono::duration<t_real>(now - last_time).count());
+		last_time = now;
+	};
+
+	// the variable types are needed to evaluate the expressions
+	std::unordered_map<t_str, VMType> syms;
+	resolve_var_types(ast, "", syms);
+
+	const bool safe = !uses_addresses(ast);
+	step_done("variable types");
+
+	InlineState inline_state
+	{
+		.funcs = {},
+		.inlined = {},
+		.num_calls = 0,
+		.opt_ctr = opt_ctr,
+	};
+
+	InvariantState invariant_state
+	{
+		.num_temps = 0,
+		.opt_ctr = opt_ctr,
+	};
+
+	EvalState eval_state
+	{
+		.funcs = {},
+		.calls = {},
+		.results = {},
+		.evaluated = {},
+		.budget = eval_budget,
+	};
+
+	std::unordered_set<t_astbaseptr> unrolled;
+
+	for(std::size_t pass = 0; pass < MAX_PASSES; ++pass)
+	{
+		std::size_t ctr = 0;
+
+		const std::string pass_name = "pass " + std::to_string(pass + 1) + ": ";
+
+		// the inlined calls can contain further calls, which are inlined in the next pass
+		if(inline_size)
+		{
+			inline_state.opt_ctr = &ctr;
+			get_inlinable_funcs(ast, inline_size, inline_state);
+			inline_calls(ast, safe, inline_state);
+			step_done(pass_name + "inlining");
+		}
+
+		if(eval_budget)
+			get_pure_funcs(ast, eval_state);
+
+		PropagationState prop_state
+		{
+			.consts = {},
+			.ranges = {},
+			.safe = safe,
+			.unroll = unroll_factor,
+			.unrolled = &unrolled,
+			.eval = &eval_state,
+			.opt_ctr = &ctr,
+		};
+		ast = propagate_consts(ast, prop_state);
+		step_done(pass_name + "constant propagation");
+
+		invariant_state.opt_ctr = &ctr;
+		hoist_loop_invariants(ast, safe, invariant_state);
+		step_done(pass_name + "loop invariants");
+
+		// keep the final values of the global variables
+		LivenessState live_state
+		{
+			.safe = safe,
+			.loops = {},
+			.opt_ctr = &ctr,
+		};
+		// the temporary variables are not visible after the program
+		t_vars live;
+		get_vars(ast, live, true, true);
+		std::erase_if(live, is_temp_var);
+		ast = remove_dead_assignments(ast, live, live_state);
+		step_done(pass_name + "dead assignments");
+
+		if(opt_ctr)
+			*opt_ctr += ctr;
+		if(!ctr)
+			break;
+	}
+
+	if(!keep_funcs)
+	{
+		t_vars removable = inline_state.inlined;
+		removable.insert(eval_state.evaluated.begin(), eval_state.evaluated.end());
+		remove_unused_funcs(ast, removable, opt_ctr);
+		step_done("unused functions");
 	}
 
-	// nothing optimised, return original ast node
 	return ast;
 }
+
+
+/**
+ * find the recursive pure functions with a single int argument, whose results can be cached
+ */
+std::unordered_set<t_str> get_memoisable_funcs(const t_astbaseptr& ast)
+{
+	EvalState state
+	{
+		.funcs = {},
+		.calls = {},
+		.results = {},
+		.evaluated = {},
+		.budget = 0,
+	};
+	get_pure_funcs(ast, state);
+
+	t_vars funcs;
+	for(const auto& [name, func] : state.funcs)
+	{
+		if(func->NumArgs() != 1)
+			continue;
+
+		const ASTToken<t_str>* arg = get_ident(func->GetArgs()->GetChild(0));
+		if(!arg || arg->GetDataType() != VMType::INT)
+			continue;
+
+		// the result is stored under the argument's value at the return,
+		// so it must still be the one the function was called with
+		t_vars written;
+		get_vars(func->GetBlock(), written, false, true);
+		if(written.contains(arg->GetLexerValue()))
+			continue;
+
+		if(is_recursive(name, state.calls))
+			funcs.insert(name);
+	}
+
+	return funcs;
+}
@@ -10,8 +10,34 @@
 
 #include "ast.h"
 
+#include <unordered_set>
+#include <vector>
+#include <string>
 
-extern t_astbaseptr ast_optimise(t_astbaseptr& ast, std::size_t *opt_ctr = nullptr);
+
+// default maximum size of the functions to inline, in syntax tree nodes
+constexpr std::size_t DEFAULT_INLINE_SIZE = 32;
+
+// default unroll factor for loops with a constant number of iterations
+constexpr std::size_t DEFAULT_UNROLL_FACTOR = 4;
+
+// default maximum number of instructions to run when evaluating a function call at compile time
+constexpr std::size_t DEFAULT_EVAL_BUDGET = 100000;
+
+
+// names and durations (in seconds) of the optimisation steps
+using t_optimise_times = std::vector<std::pair<std::string, t_real>>;
+
+
+extern t_astbaseptr ast_optimise(t_astbaseptr& ast, std::size_t *opt_ctr = nullptr,
+	std::size_t inline_size = DEFAULT_INLINE_SIZE,
+	std::size_t unroll_factor = DEFAULT_UNROLL_FACTOR,
+	std::size_t eval_budget = DEFAULT_EVAL_BUDGET,
+	bool keep_funcs = false, t_optimise_times *times = nullptr);
+
+extern std::size_t count_nodes(const t_astbaseptr& ast);
+
+extern std::unordered_set<t_str> get_memoisable_funcs(const t_astbaseptr& ast);
 
 
 #endif
@@ -34,6 +34,8 @@ std::string ASTPrinter::get_ast_typename(const ::ASTBase* ast)
 		case ASTType::TYPED_IDENT: return "typed_ident";
 		case ASTType::ADDROF: return "address_of";
 		case ASTType::DEREF: return "dereference";
+		case ASTType::ARRAY_DECL: return "array_declaration";
+		case ASTType::ARRAY_ACCESS: return "array_access";
 	}
 
 	return "<unknown>";
@@ -222,3 +224,20 @@ void ASTPrinter::visit(const ASTDeref* ast, std::size_t level)
 {
 	print_base(ast, level);
 }
+
+
+void ASTPrinter::visit(const ASTArrayDecl* ast, std::size_t level)
+{
+	std::ostringstream _ostr;
+	_ostr << ", size = " << ast->GetSize();
+	print_base(ast, level, _ostr.str().c_str());
+}
+
+
+void ASTPrinter::visit(const ASTArrayAccess* ast, std::size_t level)
+{
+	std::ostringstream _ostr;
+	if(const auto& range = ast->GetIndexRange(); range)
+		_ostr << ", index range = [" << range->first << ", " << range->second << "]";
+	print_base(ast, level, _ostr.str().c_str());
+}
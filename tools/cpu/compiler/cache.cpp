@@ -0,0 +1,140 @@
+/**
+ * cache of compiled programs
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "cache.h"
+
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <string_view>
+#include <stdexcept>
+
+#if __has_include(<filesystem>)
+	#include <filesystem>
+	namespace fs = std::filesystem;
+	using t_errcode = std::error_code;
+#elif __has_include(<boost/filesystem.hpp>)
+	#include <boost/filesystem.hpp>
+	namespace fs = boost::filesystem;
+	using t_errcode = boost::system::error_code;
+#else
+	#error No filesystem support found.
+#endif
+
+
+/**
+ * 64-bit fnv-1a hash
+ */
+static std::uint64_t hash_str(std::string_view str, std::uint64_t hash)
+{
+	for(char c : str)
+	{
+		hash ^= static_cast<std::uint8_t>(c);
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+
+static std::string hash_to_str(std::uint64_t hash)
+{
+	std::ostringstream ostr;
+	ostr << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return ostr.str();
+}
+
+
+CompileCache::CompileCache(const std::string& dir) : m_dir{dir}
+{
+	t_errcode err;
+	fs::create_directories(m_dir, err);
+	if(err)
+		throw std::runtime_error("Cannot create cache directory \"" + m_dir + "\".");
+}
+
+
+/**
+ * hash the parts of the key separately, so that they cannot be shifted into each other
+ */
+std::string CompileCache::GetKey(const std::string& source,
+	const std::string& options, const std::string& version)
+{
+	std::uint64_t hash = 0xcbf29ce484222325ull;
+	for(const std::string* part : { &version, &options, &source })
+	{
+		hash = hash_str(std::to_string(part->size()) + ":", hash);
+		hash = hash_str(*part, hash);
+	}
+
+	return hash_to_str(hash);
+}
+
+
+std::string CompileCache::GetFileHash(const std::string& file)
+{
+	std::ifstream ifstr(file, std::ios_base::binary);
+	if(!ifstr)
+		throw std::runtime_error("Cannot read \"" + file + "\" to get its hash.");
+
+	std::uint64_t hash = 0xcbf29ce484222325ull;
+	std::string buf(1 << 16, 0);
+	while(ifstr)
+	{
+		ifstr.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+		hash = hash_str(std::string_view{buf.data(), static_cast<std::size_t>(ifstr.gcount())}, hash);
+	}
+
+	return hash_to_str(hash);
+}
+
+
+bool CompileCache::Load(const std::string& key, const std::string& outfile)
+{
+	fs::path entry = fs::path(m_dir) / key;
+
+	t_errcode err;
+	if(!fs::exists(entry, err) || err)
+	{
+		++m_misses;
+		return false;
+	}
+
+	fs::copy_file(entry, outfile, fs::copy_options::overwrite_existing, err);
+	if(err)
+	{
+		++m_misses;
+		return false;
+	}
+
+	++m_hits;
+	return true;
+}
+
+
+/**
+ * the file is first copied to a temporary name and then renamed,
+ * so that concurrent compilers never see a partially written entry
+ */
+void CompileCache::Store(const std::string& key, const std::string& infile)
+{
+	std::random_device rnd;
+	fs::path entry = fs::path(m_dir) / key;
+	fs::path tmp_entry = fs::path(m_dir) / (key + ".tmp" + std::to_string(rnd()));
+
+	t_errcode err;
+	fs::copy_file(infile, tmp_entry, fs::copy_options::overwrite_existing, err);
+	if(!err)
+		fs::rename(tmp_entry, entry, err);
+
+	if(err)
+	{
+		fs::remove(tmp_entry, err);
+		throw std::runtime_error("Cannot add \"" + infile + "\" to the compilation cache.");
+	}
+}
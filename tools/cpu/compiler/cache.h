@@ -0,0 +1,56 @@
+/**
+ * cache of compiled programs
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#ifndef __LR1_COMPILE_CACHE_H__
+#define __LR1_COMPILE_CACHE_H__
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+
+/**
+ * compiled programs and modules are stored in a directory under a hash
+ * of their source text, the compiler options, and the compiler version,
+ * so unchanged scripts are not compiled again
+ */
+class CompileCache
+{
+public:
+	CompileCache(const std::string& dir);
+	~CompileCache() = default;
+
+	CompileCache(const CompileCache&) = delete;
+	const CompileCache& operator=(const CompileCache&) = delete;
+
+	// get the key of a compiled script
+	static std::string GetKey(const std::string& source,
+		const std::string& options, const std::string& version);
+
+	// get the hash of a file's contents, e.g. of the compiler executable as its version
+	static std::string GetFileHash(const std::string& file);
+
+	// copy a cached file to the output file, if it exists
+	bool Load(const std::string& key, const std::string& outfile);
+
+	// add a compiled file to the cache
+	void Store(const std::string& key, const std::string& infile);
+
+	std::size_t GetHits() const { return m_hits; }
+	std::size_t GetMisses() const { return m_misses; }
+
+
+private:
+	std::string m_dir{};
+
+	// counters, shared by concurrent compilations
+	std::atomic<std::size_t> m_hits{}, m_misses{};
+};
+
+
+#endif
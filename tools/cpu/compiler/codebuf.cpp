@@ -0,0 +1,226 @@
+/**
+ * in-memory code buffer with labels and jump fixups
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "codebuf.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+/**
+ * get the short variant of a jump instruction
+ */
+static OpCode get_short_jump(OpCode op)
+{
+	switch(op)
+	{
+		case OpCode::JMP: return OpCode::JMP_S;
+		case OpCode::JMPCND: return OpCode::JMPCND_S;
+		case OpCode::JMPNCND: return OpCode::JMPNCND_S;
+		default: throw std::runtime_error("Invalid jump instruction.");
+	}
+}
+
+
+CodeBuffer::t_label CodeBuffer::NewLabel()
+{
+	m_labels.push_back(UNBOUND);
+	return m_labels.size() - 1;
+}
+
+
+/**
+ * set the label to the current position
+ */
+void CodeBuffer::BindLabel(t_label label)
+{
+	m_labels.at(label) = m_code.size();
+}
+
+
+bool CodeBuffer::IsLabelBound(t_label label) const
+{
+	return label < m_labels.size() && m_labels[label] != UNBOUND;
+}
+
+
+std::size_t CodeBuffer::GetLabelPosition(t_label label) const
+{
+	if(!IsLabelBound(label))
+		throw std::runtime_error("Jump to an undefined label.");
+	return m_labels[label];
+}
+
+
+/**
+ * emit a jump placeholder in the long encoding, which is replaced in Finish()
+ */
+void CodeBuffer::EmitJump(OpCode op, t_label label)
+{
+	get_short_jump(op);  // check the opcode
+
+	m_jumps.emplace_back(Jump
+	{
+		.pos = m_code.size(),
+		.label = label,
+		.op = op,
+		.is_short = false,
+	});
+
+	m_code.resize(m_code.size() + LONG_JUMP_SIZE);
+}
+
+
+void CodeBuffer::EmitPushLabel(t_label label, t_int offs, t_int flags)
+{
+	Emit(OpCode::PUSH);
+
+	m_label_refs.emplace_back(LabelRef
+	{
+		.pos = m_code.size(),
+		.label = label,
+		.offs = offs,
+		.flags = flags,
+	});
+
+	EmitValue<t_int>(0);
+}
+
+
+/**
+ * final address of a position in the emitted code
+ */
+std::size_t CodeBuffer::MapPosition(std::size_t pos) const
+{
+	if(!m_finished)
+		return pos;
+
+	// number of jumps before the position
+	auto iter = std::lower_bound(m_jumps.begin(), m_jumps.end(), pos,
+		[](const Jump& jump, std::size_t jump_pos) -> bool
+	{
+		return jump.pos < jump_pos;
+	});
+
+	return pos - m_shrink[iter - m_jumps.begin()];
+}
+
+
+t_int CodeBuffer::GetLabelAddress(t_label label) const
+{
+	return static_cast<t_int>(MapPosition(GetLabelPosition(label)));
+}
+
+
+std::vector<CodeBuffer::LabelRef> CodeBuffer::GetLabelRefs() const
+{
+	std::vector<LabelRef> refs = m_label_refs;
+	for(LabelRef& ref : refs)
+		ref.pos = MapPosition(ref.pos);
+
+	return refs;
+}
+
+
+std::size_t CodeBuffer::NumShortJumps() const
+{
+	return std::count_if(m_jumps.begin(), m_jumps.end(),
+		[](const Jump& jump) -> bool { return jump.is_short; });
+}
+
+
+/**
+ * resolve the labels and write the final code
+ */
+void CodeBuffer::Finish(bool allow_unbound_refs)
+{
+	if(m_finished)
+		throw std::runtime_error("Code has already been finished.");
+
+	const std::size_t shrink_per_jump = LONG_JUMP_SIZE - SHORT_JUMP_SIZE;
+	m_shrink.resize(m_jumps.size() + 1);
+	m_shrink[0] = 0;
+
+	// iteratively select the jumps which can use the short encoding,
+	// shortening jumps only moves code closer together, so
+	// a jump which fits once keeps fitting and this terminates
+	m_finished = true;
+	for(bool changed = true; changed;)
+	{
+		changed = false;
+		for(std::size_t idx = 0; idx < m_jumps.size(); ++idx)
+		{
+			m_shrink[idx + 1] = m_shrink[idx]
+				+ (m_jumps[idx].is_short ? shrink_per_jump : 0);
+		}
+
+		for(std::size_t idx = 0; idx < m_jumps.size(); ++idx)
+		{
+			Jump& jump = m_jumps[idx];
+			if(jump.is_short)
+				continue;
+
+			std::ptrdiff_t from = jump.pos - m_shrink[idx] + SHORT_JUMP_SIZE;
+			std::ptrdiff_t to = MapPosition(GetLabelPosition(jump.label));
+			std::ptrdiff_t offs = to - from;
+
+			if(offs >= std::numeric_limits<std::int8_t>::min()
+				&& offs <= std::numeric_limits<std::int8_t>::max())
+			{
+				jump.is_short = true;
+				changed = true;
+			}
+		}
+	}
+
+	// write the final code
+	std::vector<t_byte> code;
+	code.reserve(m_code.size());
+
+	std::size_t last_pos = 0;
+	for(std::size_t idx = 0; idx < m_jumps.size(); ++idx)
+	{
+		const Jump& jump = m_jumps[idx];
+		code.insert(code.end(), m_code.begin() + last_pos, m_code.begin() + jump.pos);
+		last_pos = jump.pos + LONG_JUMP_SIZE;
+
+		t_int to = static_cast<t_int>(MapPosition(GetLabelPosition(jump.label)));
+
+		if(jump.is_short)
+		{
+			t_int from = static_cast<t_int>(code.size() + SHORT_JUMP_SIZE);
+			code.push_back(static_cast<t_byte>(get_short_jump(jump.op)));
+			code.push_back(static_cast<t_byte>(static_cast<std::int8_t>(to - from)));
+		}
+		else
+		{
+			t_int from = static_cast<t_int>(code.size() + LONG_JUMP_SIZE);
+			t_int addr = encode_addr<t_int>(to - from, ADDR_FLAG_IP);
+
+			code.push_back(static_cast<t_byte>(OpCode::PUSH));
+			code.resize(code.size() + sizeof(t_int));
+			std::memcpy(code.data() + code.size() - sizeof(t_int), &addr, sizeof(t_int));
+			code.push_back(static_cast<t_byte>(jump.op));
+		}
+	}
+	code.insert(code.end(), m_code.begin() + last_pos, m_code.end());
+	m_code = std::move(code);
+
+	// fill in the pushed label addresses
+	for(const LabelRef& ref : m_label_refs)
+	{
+		if(allow_unbound_refs && !IsLabelBound(ref.label))
+			continue;
+
+		std::size_t pos = MapPosition(ref.pos);
+		t_int addr = GetLabelAddress(ref.label) + ref.offs;
+		if(ref.flags == ADDR_FLAG_IP)
+			addr -= static_cast<t_int>(pos + sizeof(t_int) + 1);
+
+		Patch<t_int>(pos, encode_addr<t_int>(addr, ref.flags));
+	}
+}
@@ -0,0 +1,172 @@
+/**
+ * in-memory code buffer with labels and jump fixups
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#ifndef __LR1_CODEBUF_H__
+#define __LR1_CODEBUF_H__
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+#include "lval.h"
+#include "vm/opcodes.h"
+
+
+/**
+ * bytecode is emitted into the buffer with position-dependent
+ * addresses referring to labels, these are resolved in a single
+ * fixup pass in Finish(), which also selects the short encodings
+ * of all jumps whose offsets fit into a byte
+ */
+class CodeBuffer
+{
+public:
+	using t_label = std::size_t;
+
+	// sizes of the jump encodings
+	static constexpr std::size_t LONG_JUMP_SIZE = 1 + sizeof(t_int) + 1;   // push addr, jmp
+	static constexpr std::size_t SHORT_JUMP_SIZE = 1 + sizeof(std::int8_t); // jmp_s offs
+
+	// instruction decoded from the emitted code
+	struct Instr
+	{
+		std::size_t pos{};       // position in the emitted code
+		std::size_t len{};       // size including immediate data
+		OpCode op{OpCode::NOP};
+
+		bool is_jump{false};     // jump placeholder
+		bool is_ref{false};      // pushes a label address
+	};
+
+	// positions with label addresses pushed by EmitPushLabel
+	struct LabelRef
+	{
+		std::size_t pos{};       // position of the address in the emitted code
+		t_label label{};
+		t_int offs{};            // offset to add to the label address
+		t_int flags{ADDR_FLAG_IP};
+	};
+
+	// statistics of the peephole optimisation
+	struct PeepholeStats
+	{
+		std::size_t instrs_before{}, instrs_after{};
+		std::size_t bytes_before{}, bytes_after{};
+
+		// number of applications per rule
+		std::vector<std::pair<std::string, std::size_t>> rules{};
+	};
+
+
+public:
+	CodeBuffer() = default;
+	~CodeBuffer() = default;
+
+	CodeBuffer(const CodeBuffer&) = delete;
+	const CodeBuffer& operator=(const CodeBuffer&) = delete;
+
+	// emit instructions and data
+	void Emit(OpCode op) { m_code.push_back(static_cast<t_byte>(op)); }
+
+	template<class t_val>
+	void EmitValue(const t_val& val)
+	{
+		std::size_t pos = m_code.size();
+		m_code.resize(pos + sizeof(t_val));
+		std::memcpy(m_code.data() + pos, &val, sizeof(t_val));
+	}
+
+	void EmitPush(t_int val) { Emit(OpCode::PUSH); EmitValue<t_int>(val); }
+	void EmitPush(t_real val) { Emit(OpCode::PUSH_R); EmitValue<t_real>(val); }
+
+	// access a variable at an offset to a base pointer
+	void EmitRelative(OpCode op, t_offs offs) { Emit(op); EmitValue<t_offs>(offs); }
+
+	// labels
+	t_label NewLabel();
+	void BindLabel(t_label label);
+	bool IsLabelBound(t_label label) const;
+
+	// jump to a label using JMP, JMPCND, or JMPNCND
+	void EmitJump(OpCode op, t_label label);
+
+	// push the address of a label (plus an offset), relative to the
+	// end of the following one-byte instruction or absolute
+	void EmitPushLabel(t_label label, t_int offs = 0, t_int flags = ADDR_FLAG_IP);
+
+	// peephole optimisation of the emitted code, has to be run before Finish()
+	const PeepholeStats& Optimise(std::size_t max_passes = 8);
+	const PeepholeStats& GetPeepholeStats() const { return m_stats; }
+
+	// resolve the labels and write the final code,
+	// addresses of unbound labels can be left for a linker to fill in
+	void Finish(bool allow_unbound_refs = false);
+	bool IsFinished() const { return m_finished; }
+
+	// position in the emitted (or, after Finish(), the final) code
+	std::size_t GetPosition() const { return m_code.size(); }
+
+	// final address of a label, valid after Finish()
+	t_int GetLabelAddress(t_label label) const;
+
+	// pushed label addresses with their positions in the final code, valid after Finish()
+	std::vector<LabelRef> GetLabelRefs() const;
+
+	// overwrite or append data to the final code
+	template<class t_val>
+	void Patch(std::size_t pos, const t_val& val)
+	{
+		std::memcpy(m_code.data() + pos, &val, sizeof(t_val));
+	}
+
+	void Append(const t_byte* data, std::size_t size)
+	{
+		m_code.insert(m_code.end(), data, data + size);
+	}
+
+	const std::vector<t_byte>& GetCode() const { return m_code; }
+
+	std::size_t NumJumps() const { return m_jumps.size(); }
+	std::size_t NumShortJumps() const;
+
+
+protected:
+	std::size_t GetLabelPosition(t_label label) const;
+	std::size_t MapPosition(std::size_t pos) const;
+
+	std::vector<Instr> Decode() const;
+	bool OptimisePass();
+
+
+private:
+	struct Jump
+	{
+		std::size_t pos{};       // position of the jump in the emitted code
+		t_label label{};         // jump target
+		OpCode op{OpCode::JMP};  // JMP, JMPCND, or JMPNCND
+		bool is_short{false};    // use the short encoding?
+	};
+
+	static constexpr std::size_t UNBOUND = std::numeric_limits<std::size_t>::max();
+
+	std::vector<t_byte> m_code{};
+	std::vector<std::size_t> m_labels{};     // label positions in the emitted code
+	std::vector<Jump> m_jumps{};             // sorted by position
+	std::vector<LabelRef> m_label_refs{};
+
+	// number of bytes saved by short jumps before a jump, valid after Finish()
+	std::vector<std::size_t> m_shrink{};
+	bool m_finished{false};
+
+	PeepholeStats m_stats{};
+};
+
+
+#endif
@@ -0,0 +1,457 @@
+/**
+ * peephole optimisation of the emitted code
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "codebuf.h"
+
+#include <stdexcept>
+
+
+using t_instr = CodeBuffer::Instr;
+
+
+/**
+ * read the immediate data of an instruction
+ */
+template<class t_val>
+static t_val get_data(const std::vector<t_byte>& code, const t_instr& instr)
+{
+	t_val val{};
+	std::memcpy(&val, code.data() + instr.pos + 1, sizeof(t_val));
+	return val;
+}
+
+
+template<class t_val>
+static void emit(std::vector<t_byte>& out, OpCode op, const t_val* data = nullptr)
+{
+	out.push_back(static_cast<t_byte>(op));
+
+	if(data)
+	{
+		std::size_t pos = out.size();
+		out.resize(pos + sizeof(t_val));
+		std::memcpy(out.data() + pos, data, sizeof(t_val));
+	}
+}
+
+
+static void emit_copy(std::vector<t_byte>& out, const std::vector<t_byte>& code, const t_instr& instr)
+{
+	out.insert(out.end(), code.begin() + instr.pos, code.begin() + instr.pos + instr.len);
+}
+
+
+/**
+ * get the inverted integer comparison
+ */
+static OpCode invert_comparison(OpCode op)
+{
+	switch(op)
+	{
+		case OpCode::GT: return OpCode::LEQU;
+		case OpCode::LT: return OpCode::GEQU;
+		case OpCode::GEQU: return OpCode::LT;
+		case OpCode::LEQU: return OpCode::GT;
+		case OpCode::EQU: return OpCode::NEQU;
+		case OpCode::NEQU: return OpCode::EQU;
+
+		// the real comparisons are not inverted as they differ for nan
+		default: return OpCode::INVALID;
+	}
+}
+
+
+/**
+ * is the address a fixed memory location, which does not depend on the instruction position?
+ */
+static bool is_fixed_address(t_int addr)
+{
+	auto [raw_addr, flags] = decode_addr<t_int>(addr);
+	return flags == ADDR_FLAG_MEM || flags == ADDR_FLAG_BP || flags == ADDR_FLAG_GBP;
+}
+
+
+/**
+ * get the read instruction matching a write relative to a base pointer,
+ * and the instruction duplicating a value of its type
+ */
+static std::pair<OpCode, OpCode> get_relative_read(OpCode op)
+{
+	switch(op)
+	{
+		case OpCode::WRBP: return std::make_pair(OpCode::RDBP, OpCode::DUP);
+		case OpCode::WRGBP: return std::make_pair(OpCode::RDGBP, OpCode::DUP);
+		case OpCode::WRBP_R: return std::make_pair(OpCode::RDBP_R, OpCode::DUP_R);
+		case OpCode::WRGBP_R: return std::make_pair(OpCode::RDGBP_R, OpCode::DUP_R);
+		default: return std::make_pair(OpCode::INVALID, OpCode::INVALID);
+	}
+}
+
+
+/**
+ * rewrite rules of the peephole optimiser,
+ * they get the instruction window and return true if they have written a replacement
+ */
+struct PeepholeRule
+{
+	const char* name{};
+	std::size_t len{};  // length of the instruction window
+	bool (*apply)(const std::vector<t_byte>& code, const t_instr* instrs, std::vector<t_byte>& out){};
+};
+
+
+static const PeepholeRule g_rules[] =
+{
+	// nop ->
+	{
+		.name = "remove nop",
+		.len = 1,
+		.apply = [](const std::vector<t_byte>&, const t_instr* instrs, std::vector<t_byte>&) -> bool
+		{
+			return instrs[0].op == OpCode::NOP;
+		},
+	},
+
+	// cmp, not -> inverted cmp
+	{
+		.name = "invert comparison",
+		.len = 2,
+		.apply = [](const std::vector<t_byte>&, const t_instr* instrs, std::vector<t_byte>& out) -> bool
+		{
+			if(instrs[1].op != OpCode::NOT)
+				return false;
+
+			OpCode op = invert_comparison(instrs[0].op);
+			if(op == OpCode::INVALID)
+				return false;
+
+			emit<t_int>(out, op);
+			return true;
+		},
+	},
+
+	// push int, itof -> push real
+	// push real, ftoi -> push int
+	{
+		.name = "fold constant cast",
+		.len = 2,
+		.apply = [](const std::vector<t_byte>& code, const t_instr* instrs, std::vector<t_byte>& out) -> bool
+		{
+			if(instrs[0].op == OpCode::PUSH && instrs[1].op == OpCode::ITOF)
+			{
+				t_real val = t_real(get_data<t_int>(code, instrs[0]));
+				emit<t_real>(out, OpCode::PUSH_R, &val);
+				return true;
+			}
+			else if(instrs[0].op == OpCode::PUSH_R && instrs[1].op == OpCode::FTOI)
+			{
+				t_int val = t_int(get_data<t_real>(code, instrs[0]));
+				emit<t_int>(out, OpCode::PUSH, &val);
+				return true;
+			}
+
+			return false;
+		},
+	},
+
+	// push 2, pow -> dup, mul
+	// not for reals, as pow and mul are rounded differently in some cases
+	{
+		.name = "square",
+		.len = 2,
+		.apply = [](const std::vector<t_byte>& code, const t_instr* instrs, std::vector<t_byte>& out) -> bool
+		{
+			if(instrs[0].op != OpCode::PUSH || instrs[1].op != OpCode::POW
+				|| get_data<t_int>(code, instrs[0]) != 2)
+				return false;
+
+			emit<t_int>(out, OpCode::DUP);
+			emit<t_int>(out, OpCode::MUL);
+			return true;
+		},
+	},
+
+	// push addr, wrmem, push addr, rdmem -> dup, push addr, wrmem
+	{
+		.name = "reuse stored value",
+		.len = 4,
+		.apply = [](const std::vector<t_byte>& code, const t_instr* instrs, std::vector<t_byte>& out) -> bool
+		{
+			OpCode dup = OpCode::INVALID;
+			if(instrs[1].op == OpCode::WRMEM && instrs[3].op == OpCode::RDMEM)
+				dup = OpCode::DUP;
+			else if(instrs[1].op == OpCode::WRMEM_R && instrs[3].op == OpCode::RDMEM_R)
+				dup = OpCode::DUP_R;
+			else
+				return false;
+
+			if(instrs[0].op != OpCode::PUSH || instrs[2].op != OpCode::PUSH)
+				return false;
+
+			t_int addr = get_data<t_int>(code, instrs[0]);
+			if(addr != get_data<t_int>(code, instrs[2]) || !is_fixed_address(addr))
+				return false;
+
+			emit<t_int>(out, dup);
+			emit_copy(out, code, instrs[0]);
+			emit_copy(out, code, instrs[1]);
+			return true;
+		},
+	},
+
+	// wrbp offs, rdbp offs -> dup, wrbp offs
+	{
+		.name = "reuse stored variable",
+		.len = 2,
+		.apply = [](const std::vector<t_byte>& code, const t_instr* instrs, std::vector<t_byte>& out) -> bool
+		{
+			auto [rd, dup] = get_relative_read(instrs[0].op);
+			if(rd == OpCode::INVALID || instrs[1].op != rd
+				|| get_data<t_offs>(code, instrs[0]) != get_data<t_offs>(code, instrs[1]))
+				return false;
+
+			emit<t_int>(out, dup);
+			emit_copy(out, code, instrs[0]);
+			return true;
+		},
+	},
+};
+
+
+/**
+ * split the emitted code into instructions
+ */
+std::vector<CodeBuffer::Instr> CodeBuffer::Decode() const
+{
+	std::vector<Instr> instrs;
+	instrs.reserve(m_code.size() / 2);
+
+	auto jump_iter = m_jumps.begin();
+	auto ref_iter = m_label_refs.begin();
+
+	for(std::size_t pos = 0; pos < m_code.size();)
+	{
+		Instr instr
+		{
+			.pos = pos,
+			.len = 1,
+			.op = static_cast<OpCode>(m_code[pos]),
+			.is_jump = false,
+			.is_ref = false,
+		};
+
+		if(jump_iter != m_jumps.end() && jump_iter->pos == pos)
+		{
+			instr.len = LONG_JUMP_SIZE;
+			instr.op = jump_iter->op;
+			instr.is_jump = true;
+			++jump_iter;
+		}
+		else
+		{
+			instr.len += get_vm_opcode_data_size(instr.op);
+			if(ref_iter != m_label_refs.end() && ref_iter->pos == pos + 1)
+			{
+				instr.is_ref = true;
+				++ref_iter;
+			}
+		}
+
+		pos += instr.len;
+		instrs.push_back(instr);
+	}
+
+	return instrs;
+}
+
+
+/**
+ * run the peephole rules once over the emitted code
+ * @return was the code changed?
+ */
+bool CodeBuffer::OptimisePass()
+{
+	constexpr std::size_t NO_POS = std::numeric_limits<std::size_t>::max();
+	const std::size_t num_rules = sizeof(g_rules) / sizeof(g_rules[0]);
+	bool changed = false;
+
+	// thread jumps which lead to unconditional jumps
+	std::vector<std::size_t> jump_at(m_code.size() + 1, NO_POS);
+	for(std::size_t idx = 0; idx < m_jumps.size(); ++idx)
+		jump_at[m_jumps[idx].pos] = idx;
+
+	for(Jump& jump : m_jumps)
+	{
+		for(std::size_t hops = 0; hops < 16; ++hops)
+		{
+			std::size_t target = jump_at[GetLabelPosition(jump.label)];
+			if(target == NO_POS || m_jumps[target].op != OpCode::JMP
+				|| m_jumps[target].label == jump.label)
+				break;
+
+			jump.label = m_jumps[target].label;
+			++m_stats.rules[num_rules].second;
+			changed = true;
+		}
+	}
+
+	// positions that are jumped to
+	std::vector<bool> is_label(m_code.size() + 1, false);
+	for(std::size_t pos : m_labels)
+	{
+		if(pos != UNBOUND)
+			is_label[pos] = true;
+	}
+
+	const std::vector<Instr> instrs = Decode();
+
+	std::vector<t_byte> code;
+	std::vector<Jump> jumps;
+	std::vector<LabelRef> refs;
+	std::vector<std::size_t> new_pos(m_code.size() + 1, NO_POS);
+	code.reserve(m_code.size());
+	jumps.reserve(m_jumps.size());
+	refs.reserve(m_label_refs.size());
+
+	auto jump_iter = m_jumps.begin();
+	auto ref_iter = m_label_refs.begin();
+	bool unreachable = false;
+
+	for(std::size_t idx = 0; idx < instrs.size();)
+	{
+		const Instr& instr = instrs[idx];
+		new_pos[instr.pos] = code.size();
+
+		const Jump* jump = nullptr;
+		const LabelRef* ref = nullptr;
+		if(instr.is_jump)
+			jump = &*jump_iter++;
+		if(instr.is_ref)
+			ref = &*ref_iter++;
+
+		// remove unreachable code following unconditional jumps
+		if(is_label[instr.pos])
+			unreachable = false;
+		if(unreachable)
+		{
+			++m_stats.rules[num_rules + 1].second;
+			changed = true;
+			++idx;
+			continue;
+		}
+
+		if(jump)
+		{
+			// remove jumps to the next instruction
+			if(jump->op == OpCode::JMP && GetLabelPosition(jump->label) == instr.pos + instr.len)
+			{
+				++m_stats.rules[num_rules + 2].second;
+				changed = true;
+				++idx;
+				continue;
+			}
+
+			jumps.emplace_back(*jump);
+			jumps.back().pos = code.size();
+			emit_copy(code, m_code, instr);
+
+			if(instr.op == OpCode::JMP)
+				unreachable = true;
+			++idx;
+			continue;
+		}
+
+		// try the rewrite rules on the window starting at this instruction
+		bool applied = false;
+		for(std::size_t rule_idx = 0; rule_idx < num_rules && !applied; ++rule_idx)
+		{
+			const PeepholeRule& rule = g_rules[rule_idx];
+			if(idx + rule.len > instrs.size())
+				continue;
+
+			// the window must not contain jump targets or position-dependent instructions
+			bool fits = true;
+			for(std::size_t win = 0; win < rule.len && fits; ++win)
+			{
+				const Instr& cur = instrs[idx + win];
+				if(cur.is_jump || cur.is_ref || (win > 0 && is_label[cur.pos]))
+					fits = false;
+			}
+
+			if(fits && rule.apply(m_code, &instrs[idx], code))
+			{
+				++m_stats.rules[rule_idx].second;
+				idx += rule.len;
+				applied = true;
+				changed = true;
+			}
+		}
+
+		if(applied)
+			continue;
+
+		if(ref)
+		{
+			refs.emplace_back(*ref);
+			refs.back().pos = code.size() + 1;
+		}
+
+		emit_copy(code, m_code, instr);
+		if(instr.op == OpCode::RET || instr.op == OpCode::HALT)
+			unreachable = true;
+		++idx;
+	}
+	new_pos[m_code.size()] = code.size();
+
+	// move the labels
+	for(std::size_t& pos : m_labels)
+	{
+		if(pos == UNBOUND)
+			continue;
+
+		pos = new_pos[pos];
+		if(pos == NO_POS)
+			throw std::runtime_error("Label does not point to an instruction.");
+	}
+
+	m_code = std::move(code);
+	m_jumps = std::move(jumps);
+	m_label_refs = std::move(refs);
+
+	return changed;
+}
+
+
+/**
+ * apply the peephole rules until the code does not change anymore
+ */
+const CodeBuffer::PeepholeStats& CodeBuffer::Optimise(std::size_t max_passes)
+{
+	if(m_finished)
+		throw std::runtime_error("Code has already been finished.");
+
+	m_stats.rules.clear();
+	for(const PeepholeRule& rule : g_rules)
+		m_stats.rules.emplace_back(std::make_pair(rule.name, 0));
+	m_stats.rules.emplace_back(std::make_pair("thread jump", 0));
+	m_stats.rules.emplace_back(std::make_pair("remove unreachable code", 0));
+	m_stats.rules.emplace_back(std::make_pair("remove jump to next", 0));
+
+	m_stats.instrs_before = Decode().size();
+	m_stats.bytes_before = m_code.size();
+
+	for(std::size_t pass = 0; pass < max_passes; ++pass)
+	{
+		if(!OptimisePass())
+			break;
+	}
+
+	m_stats.instrs_after = Decode().size();
+	m_stats.bytes_after = m_code.size();
+
+	return m_stats;
+}
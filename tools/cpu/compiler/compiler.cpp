@@ -14,12 +14,19 @@
 #include "ast_printer.h"
 #include "ast_asm.h"
 #include "ast_optimise.h"
+#include "objfile.h"
+#include "cache.h"
 
 #include <unordered_map>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <iomanip>
+#include <memory_resource>
+#include <thread>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
 #include <cstdint>
 
 #include <boost/program_options.hpp>
@@ -52,47 +59,145 @@ using namespace lalr1;
 
 	#define USE_RECASC 0
 
+#elif defined(USE_TABLE_FILE)
+	#include "core/parser.h"
+	#include "parsetab.h"
+
+	// binary table file created by "./compilergen -b", which is mapped on the first use of the tables
+	static std::string g_table_file{ COMPILER_TABLE_FILE };
+
+	using t_parsetables = ParseTables<t_table, t_vecIdx, t_mapIdIdx, t_mapSemanticIdIdx>;
+
+	static const t_parsetables& get_parse_tables()
+	{
+		static const t_parsetables tables{ g_table_file };
+		return tables;
+	}
+
+	// same interface as the tables compiled into the parser
+	static auto get_lalr1_tables() { return get_parse_tables().GetTables(); }
+	static auto get_lalr1_table_indices() { return get_parse_tables().GetTableIndices(); }
+	static auto get_lalr1_constants() { return get_parse_tables().GetConstants(); }
+
+	#define USE_RECASC 0
+
 #else
+	#define __LALR_NO_PARSER_AVAILABLE
+#endif
+
+
+
+/**
+ * options of the code generation
+ */
+struct CompilerOptions
+{
+	bool debug_codegen { false };
+	bool debug_parser { false };
+	bool optimise_code { false };
+
+	std::size_t inline_size { DEFAULT_INLINE_SIZE };
+	std::size_t unroll_factor { DEFAULT_UNROLL_FACTOR };
+	std::size_t eval_budget { DEFAULT_EVAL_BUDGET };
+	t_int memo_entries { 0 };
+
+	bool create_object { false };
+};
+
+
+/**
+ * durations of the compilation phases and sizes of their results
+ */
+struct CompileStats
+{
+	// names and durations (in seconds) of the phases
+	std::vector<std::pair<std::string, t_real>> phases{};
+	t_timepoint phase_start{ t_clock::now() };
+
+	std::size_t num_tokens { 0 };
+	std::size_t num_nodes { 0 };            // syntax tree nodes after parsing
+	std::size_t num_nodes_optimised { 0 };  // syntax tree nodes after optimisation
+	std::size_t num_symbols { 0 };
+	std::size_t code_size { 0 };            // code and constants
+	std::size_t output_size { 0 };          // program or module file
+
+	// finish the current phase and start the next one
+	void PhaseDone(const std::string& phase)
+	{
+		t_timepoint now = t_clock::now();
+		phases.emplace_back(phase, std::chrono::duration<t_real>(now - phase_start).count());
+		phase_start = now;
+	}
+};
+
+
+/**
+ * grammar and parsing tables, which are created once
+ * and shared read-only by all concurrent compilations
+ */
+struct ParserData
+{
+	ScriptGrammar grammar{};
+
+#if !defined(__LALR_NO_PARSER_AVAILABLE) && USE_RECASC == 0
+	decltype(get_lalr1_tables()) tables{ get_lalr1_tables() };
+	decltype(get_lalr1_table_indices()) table_indices{ get_lalr1_table_indices() };
+	decltype(get_lalr1_constants()) consts{ get_lalr1_constants() };
+#endif
+
+	ParserData()
+	{
+		grammar.CreateGrammar(false, true);
+	}
+};
+
+
+
+#ifdef __LALR_NO_PARSER_AVAILABLE
 	static std::tuple<bool, std::string>
-	lalr1_run_parser([[maybe_unused]] const fs::path& script_file,
+	lalr1_run_parser([[maybe_unused]] const ParserData& parser_data,
+		[[maybe_unused]] const fs::path& script_file,
 		[[maybe_unused]] const fs::path& bin_file,
-		[[maybe_unused]] bool debug_codegen = false,
-		[[maybe_unused]] bool debug_parser = false,
-		[[maybe_unused]] bool optimise_code = false)
+		[[maybe_unused]] const CompilerOptions& opts,
+		[[maybe_unused]] CompileStats *stats = nullptr,
+		[[maybe_unused]] std::ostream& out = std::cout,
+		std::ostream& err = std::cerr)
 	{
-		std::cerr << "No parsing tables available, please "
+		err << "No parsing tables available, please "
 			"run \"./compilergen\" first and rebuild."
 			<< std::endl;
 
 		return std::make_tuple(false, "");
 	}
 
-	#define __LALR_NO_PARSER_AVAILABLE
-#endif
-
-
-
-#ifndef __LALR_NO_PARSER_AVAILABLE
+#else
 
 
 static std::tuple<bool, std::string>
-lalr1_run_parser(const fs::path& script_file, const fs::path& bin_file,
-	bool debug_codegen = false, bool debug_parser = false,
-	bool optimise_code = false)
+lalr1_run_parser(const ParserData& parser_data,
+	const fs::path& script_file, const fs::path& bin_file,
+	const CompilerOptions& opts, CompileStats *stats = nullptr,
+	std::ostream& out = std::cout, std::ostream& err = std::cerr)
 {
+	CompileStats local_stats;
+	CompileStats& st = stats ? *stats : local_stats;
+	st.phase_start = t_clock::now();
+
 	try
 	{
-		ScriptGrammar grammar;
-		grammar.CreateGrammar(false, true);
-		const auto& rules = grammar.GetSemanticRules();
+		// memory pool for the token and syntax tree nodes,
+		// which has to outlive the syntax tree
+		std::pmr::monotonic_buffer_resource node_mem;
+
+		const auto& rules = parser_data.grammar.GetSemanticRules();
 
 #if USE_RECASC != 0
 		Compiler parser;
 #else
 		// get created parsing tables
-		auto [shift_tab, reduce_tab, jump_tab, num_rhs, lhs_idx] = get_lalr1_tables();
-		auto [term_idx, nonterm_idx, semantic_idx] = get_lalr1_table_indices();
-		auto [err_idx, acc_idx, eps_id, end_id, start_idx, acc_rule_idx] = get_lalr1_constants();
+		const auto& [shift_tab, reduce_tab, jump_tab, num_rhs, lhs_idx] = parser_data.tables;
+		const auto& [term_idx, nonterm_idx, semantic_idx] = parser_data.table_indices;
+		const auto& [err_idx, acc_idx, eps_id, end_id, start_idx, acc_rule_idx] = parser_data.consts;
 
 		Parser parser;
 		parser.SetShiftTable(shift_tab);
@@ -106,17 +211,18 @@ lalr1_run_parser(const fs::path& script_file, const fs::path& bin_file,
 		parser.SetAcceptingRule(acc_rule_idx);
 #endif
 		parser.SetSemanticRules(&rules);
-		parser.SetDebug(debug_parser);
+		parser.SetDebug(opts.debug_parser);
+		st.PhaseDone("parser setup");
 
 		std::unique_ptr<std::istream> istr;
 
 		if(script_file.empty())
 		{
-			//std::cerr << "Error: No input script file given." << std::endl;
+			//err << "Error: No input script file given." << std::endl;
 			//return std::make_tuple(false, "");
 
 			// read statements from command line
-			std::cout << "\nStatement: ";
+			out << "\nStatement: " << std::flush;
 			std::string script;
 			std::getline(std::cin, script);
 			istr = std::make_unique<std::istringstream>(script);
@@ -128,12 +234,12 @@ lalr1_run_parser(const fs::path& script_file, const fs::path& bin_file,
 
 			if(!*istr)
 			{
-				std::cerr << "Error: Cannot open input file "
+				err << "Error: Cannot open input file "
 					<< script_file << "." << std::endl;
 				return std::make_tuple(false, "");
 			}
 
-			std::cout << "Compiling " << script_file << "..." << std::endl;
+			out << "Compiling " << script_file << "..." << std::endl;
 		}
 
 		// tokenise script
@@ -142,110 +248,140 @@ lalr1_run_parser(const fs::path& script_file, const fs::path& bin_file,
 		lexer.SetTermIdxMap(term_idx);
 #endif
 		lexer.SetEndOnNewline(script_file.empty());
+		lexer.SetNodeMemory(&node_mem);
 		auto tokens = lexer.GetAllTokens();
+		st.num_tokens = tokens.size();
+		st.PhaseDone("lexing");
 
-		if(debug_codegen)
+		if(opts.debug_codegen)
 		{
-			std::cout << "\nTokens: ";
+			out << "\nTokens: ";
 			for(const t_toknode& tok : tokens)
 			{
 				std::size_t tokid = tok->GetId();
 				if(tokid == (std::size_t)Token::END)
-					std::cout << "END";
+					out << "END";
 				else
-					std::cout << tokid;
-				std::cout << " ";
+					out << tokid;
+				out << " ";
 			}
-			std::cout << std::endl;
+			out << std::endl;
 		}
 
+		// the grammar's node memory is per thread
+		ScriptGrammar::SetNodeMemory(&node_mem);
 		::t_astbaseptr ast = std::dynamic_pointer_cast<::ASTBase>(parser.Parse(tokens));
+		ScriptGrammar::SetNodeMemory(nullptr);
+		st.PhaseDone("parsing");
+		st.num_nodes = st.num_nodes_optimised = count_nodes(ast);
+
 		ast->AssignLineNumbers();
 		ast->DeriveDataType();
-		if(optimise_code)
+		st.PhaseDone("line numbers and data types");
+
+		if(opts.optimise_code)
 		{
 			std::size_t opt_ctr = 0;
-			ast = ast_optimise(ast, &opt_ctr);
+			t_optimise_times opt_times;
+			ast = ast_optimise(ast, &opt_ctr, opts.inline_size, opts.unroll_factor,
+				opts.eval_budget, opts.create_object, &opt_times);
 
-			std::cout << opt_ctr << " nodes optimised." << std::endl;
+			for(const auto& [step, time] : opt_times)
+				st.phases.emplace_back("optimisation, " + step, time);
+			st.phase_start = t_clock::now();
+			st.num_nodes_optimised = count_nodes(ast);
+
+			out << opt_ctr << " nodes optimised." << std::endl;
 		}
 
-		std::unordered_map<std::size_t, std::tuple<std::string, OpCode>> ops
-		{{
-			std::make_pair('+', std::make_tuple("add", OpCode::ADD)),
-			std::make_pair('-', std::make_tuple("sub", OpCode::SUB)),
-			std::make_pair('*', std::make_tuple("mul", OpCode::MUL)),
-			std::make_pair('/', std::make_tuple("div", OpCode::DIV)),
-			std::make_pair('%', std::make_tuple("mod", OpCode::MOD)),
-			std::make_pair('^', std::make_tuple("pow", OpCode::POW)),
-
-			std::make_pair('=', std::make_tuple("wrmem", OpCode::WRMEM)),
-
-			std::make_pair('&', std::make_tuple("binand", OpCode::BINAND)),
-			std::make_pair('|', std::make_tuple("binand", OpCode::BINOR)),
-			std::make_pair('~', std::make_tuple("binand", OpCode::BINNOT)),
-
-			std::make_pair('>', std::make_tuple("gt", OpCode::GT)),
-			std::make_pair('<', std::make_tuple("lt", OpCode::LT)),
-			std::make_pair(static_cast<std::size_t>(Token::EQU),
-				std::make_tuple("equ", OpCode::EQU)),
-			std::make_pair(static_cast<std::size_t>(Token::NEQU),
-				std::make_tuple("nequ", OpCode::NEQU)),
-			std::make_pair(static_cast<std::size_t>(Token::GEQU),
-				std::make_tuple("gequ", OpCode::GEQU)),
-			std::make_pair(static_cast<std::size_t>(Token::LEQU),
-				std::make_tuple("lequ", OpCode::LEQU)),
-			std::make_pair(static_cast<std::size_t>(Token::AND),
-				std::make_tuple("and", OpCode::AND)),
-			std::make_pair(static_cast<std::size_t>(Token::OR),
-				std::make_tuple("or", OpCode::OR)),
-
-			std::make_pair(static_cast<std::size_t>(Token::BIN_XOR),
-				std::make_tuple("binxor", OpCode::BINXOR)),
-			std::make_pair(static_cast<std::size_t>(Token::SHIFT_LEFT),
-				std::make_tuple("shl", OpCode::SHL)),
-			std::make_pair(static_cast<std::size_t>(Token::SHIFT_RIGHT),
-				std::make_tuple("shr", OpCode::SHR)),
-		}};
-
-		std::ostringstream ostrAsmBin(std::ios_base::out | std::ios_base::binary);
-		ASTAsm astasmbin{ostrAsmBin, &ops};
+		ASTAsm astasmbin{&get_default_ops()};
+		astasmbin.SetOptimise(opts.optimise_code);
+		astasmbin.SetObjectMode(opts.create_object);
+		if(opts.memo_entries > 0)
+			astasmbin.SetMemoisation(get_memoisable_funcs(ast), opts.memo_entries);
 		ast->accept(&astasmbin);
+		st.PhaseDone("code generation");
+
 		astasmbin.PatchFunctionAddresses();
+		st.PhaseDone("function address checks");
+
 		astasmbin.FinishCodegen();
-		std::string strAsmBin = ostrAsmBin.str();
+		st.PhaseDone("peephole optimisation and label resolution");
 
-		if(debug_codegen)
+		st.num_symbols = astasmbin.GetSymbolTable().NumSymbols();
+		st.code_size = astasmbin.GetCode().GetCode().size();
+
+		if(t_int memo_size = astasmbin.GetMemoSize(); memo_size)
+		{
+			out << "Memo tables use " << memo_size
+				<< " bytes of the heap." << std::endl;
+		}
+
+		if(opts.optimise_code)
+		{
+			const CodeBuffer::PeepholeStats& stats = astasmbin.GetCode().GetPeepholeStats();
+
+			out << "Peephole optimisation: "
+				<< stats.instrs_before << " -> " << stats.instrs_after << " instructions, "
+				<< stats.bytes_before << " -> " << stats.bytes_after << " bytes."
+				<< std::endl;
+
+			if(opts.debug_codegen)
+			{
+				for(const auto& [rule, count] : stats.rules)
+					out << "\t" << rule << ": " << count << std::endl;
+			}
+		}
+
+		std::string strAsmBin;
+		if(opts.create_object)
+		{
+			std::ostringstream ostrObj;
+			write_obj(astasmbin.CreateObject(), ostrObj);
+			strAsmBin = ostrObj.str();
+		}
+		else
 		{
-			std::cout << "\nAST:\n";
-			ASTPrinter printer{std::cout};
+			const std::vector<t_byte>& code = astasmbin.GetCode().GetCode();
+			strAsmBin.assign(reinterpret_cast<const char*>(code.data()), code.size());
+		}
+
+		if(opts.debug_codegen)
+		{
+			out << "\nAST:\n";
+			ASTPrinter printer{out};
 			ast->accept(&printer);
 
-			std::cout << "\nSymbol table:\n";
-			std::cout << astasmbin.GetSymbolTable();
+			out << "\nSymbol table:\n";
+			out << astasmbin.GetSymbolTable();
 		}
 
 		std::ofstream ofstrAsmBin(bin_file, std::ios_base::out
 			| std::ios_base::trunc | std::ios_base::binary);
 		if(!ofstrAsmBin)
 		{
-			std::cerr << "Cannot open output file " << bin_file << "." << std::endl;
+			err << "Cannot open output file " << bin_file << "." << std::endl;
 			return std::make_tuple(false, "");
 		}
 		ofstrAsmBin.write(strAsmBin.data(), strAsmBin.size());
 		if(ofstrAsmBin.fail())
 		{
-			std::cerr << "Cannot write " << bin_file << "." << std::endl;
+			err << "Cannot write " << bin_file << "." << std::endl;
 			return std::make_tuple(false, "");
 		}
 		ofstrAsmBin.flush();
+		st.output_size = strAsmBin.size();
+		st.PhaseDone("writing");
 
-		std::cout << "Created compiled program " << bin_file << "." << std::endl;
+		out << "Created compiled " << (opts.create_object ? "module " : "program ")
+			<< bin_file << "." << std::endl;
 		return std::make_tuple(true, strAsmBin);
 	}
-	catch(const std::exception& err)
+	catch(const std::exception& ex)
 	{
-		std::cerr << "Error: " << err.what() << std::endl;
+		ScriptGrammar::SetNodeMemory(nullptr);
+
+		err << "Error: " << ex.what() << std::endl;
 		return std::make_tuple(false, "");
 	}
 
@@ -256,6 +392,212 @@ lalr1_run_parser(const fs::path& script_file, const fs::path& bin_file,
 
 
 
+/**
+ * result of compiling a script
+ */
+struct CompileResult
+{
+	bool ok { false };
+	bool cached { false };
+	t_real time { 0. };         // in seconds
+
+	CompileStats stats{};
+};
+
+
+/**
+ * compile a script or copy it from the compilation cache
+ */
+static CompileResult compile_file(const ParserData& parser_data,
+	const fs::path& script_file, const fs::path& bin_file,
+	const CompilerOptions& opts, CompileCache *cache, const std::string& compiler_version,
+	std::ostream& out, std::ostream& err)
+{
+	CompileResult result{};
+	t_timepoint start_codegen = t_clock::now();
+
+	if(!fs::exists(script_file))
+	{
+		err << "Error: Cannot open input file " << script_file << "." << std::endl;
+		return result;
+	}
+
+	fs::file_status script_status = fs::status(script_file);
+	if(script_status.type() != fs::file_type::regular && script_status.type() != fs::file_type::symlink)
+	{
+		err << "Error: Input " << script_file << " is not a file." << std::endl;
+		return result;
+	}
+
+	// look up the script in the compilation cache,
+	// the debug output needs a full compilation
+	std::string cache_key;
+	if(cache && (opts.debug_codegen || opts.debug_parser))
+		cache = nullptr;
+
+	if(cache)
+	{
+		std::ifstream ifstrScript(script_file);
+		std::ostringstream ostrScript;
+		ostrScript << ifstrScript.rdbuf();
+
+		// options affecting the generated code
+		std::ostringstream ostrOpts;
+		ostrOpts << "O=" << opts.optimise_code << " i=" << opts.inline_size
+			<< " u=" << opts.unroll_factor << " e=" << opts.eval_budget
+			<< " m=" << opts.memo_entries << " c=" << opts.create_object;
+
+		result.stats.phase_start = t_clock::now();
+		cache_key = CompileCache::GetKey(ostrScript.str(), ostrOpts.str(), compiler_version);
+		result.cached = cache->Load(cache_key, bin_file.string());
+		result.stats.PhaseDone("cache lookup");
+
+		if(result.cached)
+		{
+			out << "Copied compiled " << (opts.create_object ? "module " : "program ")
+				<< bin_file << " from the compilation cache." << std::endl;
+		}
+	}
+
+	result.ok = result.cached;
+	if(!result.cached)
+	{
+		std::tie(result.ok, std::ignore) = lalr1_run_parser(
+			parser_data, script_file, bin_file, opts, &result.stats, out, err);
+
+		if(result.ok && cache)
+		{
+			try
+			{
+				cache->Store(cache_key, bin_file.string());
+				result.stats.PhaseDone("cache store");
+			}
+			catch(const std::exception& ex)
+			{
+				err << "Warning: " << ex.what() << std::endl;
+			}
+		}
+	}
+
+	result.time = std::chrono::duration<t_real>(t_clock::now() - start_codegen).count();
+	return result;
+}
+
+
+/**
+ * quote a string for json
+ */
+static std::string json_str(const std::string& str)
+{
+	std::ostringstream ostr;
+	ostr << "\"";
+
+	for(char c : str)
+	{
+		if(c == '"' || c == '\\')
+			ostr << '\\' << c;
+		else if(static_cast<unsigned char>(c) < 0x20)
+			ostr << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+				<< static_cast<int>(c) << std::dec << std::setfill(' ');
+		else
+			ostr << c;
+	}
+
+	ostr << "\"";
+	return ostr.str();
+}
+
+
+/**
+ * write the per-phase timings and statistics as text or json
+ */
+static void write_stats(std::ostream& ostr, bool json,
+	const std::vector<std::string>& progs, const std::vector<CompileResult>& results,
+	const std::string& compiler_version, t_real grammar_time, t_real total_time)
+{
+	auto status = [](const CompileResult& result) -> const char*
+	{
+		return !result.ok ? "failed" : result.cached ? "cached" : "compiled";
+	};
+
+	const std::ios_base::fmtflags flags = ostr.flags();
+	const std::streamsize precision = ostr.precision();
+
+	if(json)
+	{
+		ostr << "{\n"
+			<< "\t\"compiler\": " << json_str(compiler_version) << ",\n"
+			<< "\t\"grammar_setup_s\": " << grammar_time << ",\n"
+			<< "\t\"total_s\": " << total_time << ",\n"
+			<< "\t\"scripts\": [";
+
+		for(std::size_t idx = 0; idx < progs.size(); ++idx)
+		{
+			const CompileResult& result = results[idx];
+			const CompileStats& stats = result.stats;
+
+			ostr << (idx ? "," : "") << "\n\t\t{\n"
+				<< "\t\t\t\"script\": " << json_str(progs[idx]) << ",\n"
+				<< "\t\t\t\"status\": \"" << status(result) << "\",\n"
+				<< "\t\t\t\"time_s\": " << result.time << ",\n"
+				<< "\t\t\t\"tokens\": " << stats.num_tokens << ",\n"
+				<< "\t\t\t\"nodes\": " << stats.num_nodes << ",\n"
+				<< "\t\t\t\"nodes_optimised\": " << stats.num_nodes_optimised << ",\n"
+				<< "\t\t\t\"symbols\": " << stats.num_symbols << ",\n"
+				<< "\t\t\t\"code_bytes\": " << stats.code_size << ",\n"
+				<< "\t\t\t\"output_bytes\": " << stats.output_size << ",\n"
+				<< "\t\t\t\"phases\": [";
+
+			for(std::size_t phaseidx = 0; phaseidx < stats.phases.size(); ++phaseidx)
+			{
+				const auto& [phase, time] = stats.phases[phaseidx];
+				ostr << (phaseidx ? "," : "") << "\n\t\t\t\t{ \"name\": " << json_str(phase)
+					<< ", \"time_s\": " << time << " }";
+			}
+
+			ostr << "\n\t\t\t]\n\t\t}";
+		}
+
+		ostr << "\n\t]\n}" << std::endl;
+		return;
+	}
+
+	ostr << std::fixed << std::setprecision(3);
+	ostr << "\nCompilation statistics:\n"
+		<< "\tgrammar setup: " << grammar_time * 1000. << " ms\n";
+
+	for(std::size_t idx = 0; idx < progs.size(); ++idx)
+	{
+		const CompileResult& result = results[idx];
+		const CompileStats& stats = result.stats;
+
+		ostr << "\n" << progs[idx] << " (" << status(result) << ", "
+			<< result.time * 1000. << " ms):\n";
+		for(const auto& [phase, time] : stats.phases)
+		{
+			ostr << "\t" << std::left << std::setw(48) << (phase + ":")
+				<< std::right << std::setw(12) << time * 1000. << " ms\n";
+		}
+
+		if(!result.cached)
+		{
+			ostr << "\t" << stats.num_tokens << " tokens, "
+				<< stats.num_nodes << " syntax tree nodes ("
+				<< stats.num_nodes_optimised << " after optimisation), "
+				<< stats.num_symbols << " symbols, "
+				<< stats.code_size << " bytes of code and constants, "
+				<< stats.output_size << " bytes of output.\n";
+		}
+	}
+
+	ostr << "\ntotal: " << total_time * 1000. << " ms" << std::endl;
+
+	ostr.flags(flags);
+	ostr.precision(precision);
+}
+
+
+
 int main(int argc, char** argv)
 {
 	std::ios_base::sync_with_stdio(false);
@@ -265,18 +607,46 @@ int main(int argc, char** argv)
 	// --------------------------------------------------------------------
 	std::vector<std::string> progs;
 
-	bool debug_codegen = false;
-	bool debug_parser = false;
-	bool optimise_code = false;
+	CompilerOptions opts;
+	std::string cache_dir = "";
 	std::string outfile = "";
+	unsigned int num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::string stats_format = "";
+	std::string stats_file = "";
 
 	args::options_description arg_descr("Script compiler arguments");
 	arg_descr.add_options()
-	("debug,d", args::bool_switch(&debug_codegen), "enable debug output for code generation")
-	("debugparser,p", args::bool_switch(&debug_parser), "enable debug output for parser")
-	("optimise,O", args::bool_switch(&optimise_code), "enable code optimisation")
+	("debug,d", args::bool_switch(&opts.debug_codegen), "enable debug output for code generation")
+	("debugparser,p", args::bool_switch(&opts.debug_parser), "enable debug output for parser")
+	("optimise,O", args::bool_switch(&opts.optimise_code), "enable code optimisation")
+	("inline,i", args::value<decltype(opts.inline_size)>(&opts.inline_size),
+		"maximum size of the functions to inline (in syntax tree nodes, 0: no inlining)")
+	("unroll,u", args::value<decltype(opts.unroll_factor)>(&opts.unroll_factor),
+		"unroll factor for loops with a constant number of iterations (0 or 1: no unrolling)")
+	("eval,e", args::value<decltype(opts.eval_budget)>(&opts.eval_budget),
+		"maximum number of instructions to run when evaluating calls of pure functions "
+		"with constant arguments at compile time (0: no evaluation)")
+	("memo,m", args::value<decltype(opts.memo_entries)>(&opts.memo_entries),
+		"number of entries of the tables caching the results of recursive pure functions "
+		"with one int argument (0: no memoisation)")
+	("object,c", args::bool_switch(&opts.create_object),
+		"create a relocatable module to be combined with others by the linker")
+	("cache", args::value<decltype(cache_dir)>(&cache_dir),
+		"directory of the compilation cache, which skips the compilation of unchanged scripts")
+	("jobs,j", args::value<decltype(num_threads)>(&num_threads),
+		"number of threads compiling multiple input scripts concurrently")
+	("stats", args::value<decltype(stats_format)>(&stats_format),
+		"print the durations of the compilation phases and statistics, as \"text\" or \"json\"")
+	("statsfile", args::value<decltype(stats_file)>(&stats_file),
+		"write the statistics to a file instead of the standard output")
 	("output,o", args::value<decltype(outfile)>(&outfile), "output binary file")
-	("prog", args::value<decltype(progs)>(&progs), "input program to run");
+	("prog", args::value<decltype(progs)>(&progs), "input programs to compile");
+
+#ifdef USE_TABLE_FILE
+	arg_descr.add_options()
+	("tables", args::value<decltype(g_table_file)>(&g_table_file),
+		"binary LALR(1) table file");
+#endif
 
 	args::positional_options_description posarg_descr;
 	posarg_descr.add("prog", -1);
@@ -305,50 +675,206 @@ int main(int argc, char** argv)
 		std::cout << arg_descr << std::endl;
 		return 0;
 	}
+
+	if(outfile != "" && progs.size() > 1)
+	{
+		std::cerr << "Error: An output file can only be given for a single input script."
+			<< std::endl;
+		return -1;
+	}
+
+	if(stats_format == "" && stats_file != "")
+		stats_format = "text";
+	if(stats_format != "" && stats_format != "text" && stats_format != "json")
+	{
+		std::cerr << "Error: Unknown statistics format \"" << stats_format << "\"." << std::endl;
+		return -1;
+	}
 	// --------------------------------------------------------------------
 
 	t_timepoint start_codegen = t_clock::now();
-	fs::path script_file = progs[0];
-	fs::path bin_file;
 
-	if(!fs::exists(script_file))
+	// output file names
+	std::vector<fs::path> bin_files;
+	bin_files.reserve(progs.size());
+	for(const std::string& prog : progs)
 	{
-		std::cerr << "Error: Cannot open input file " << script_file << "." << std::endl;
-		return -1;
+		fs::path bin_file;
+
+		if(outfile != "")
+		{
+			bin_file = outfile;
+		}
+		else
+		{
+			bin_file = fs::path(prog).filename();
+			bin_file.replace_extension(opts.create_object ? ".o" : ".bin");
+		}
+
+		// default output file name
+		if(bin_file.empty())
+			bin_file = "script.bin";
+
+		if(auto iter = std::find(bin_files.begin(), bin_files.end(), bin_file);
+			iter != bin_files.end())
+		{
+			std::cerr << "Error: Input scripts \"" << progs[iter - bin_files.begin()]
+				<< "\" and \"" << prog << "\" would both be compiled to "
+				<< bin_file << "." << std::endl;
+			return -1;
+		}
+
+		bin_files.emplace_back(std::move(bin_file));
 	}
 
-	fs::file_status script_status = fs::status(script_file);
-	if(script_status.type() != fs::file_type::regular && script_status.type() != fs::file_type::symlink)
+	std::unique_ptr<CompileCache> cache;
+	std::string compiler_version;
+	std::unique_ptr<ParserData> parser_data;
+	t_real grammar_time = 0.;
+	try
+	{
+		if(cache_dir != "")
+			cache = std::make_unique<CompileCache>(cache_dir);
+
+		// the hash of the compiler executable stands in for its version, so that entries
+		// of the compilation cache are not used by a compiler with changed code generation
+		if(cache || stats_format == "json")
+		{
+			fs::path exe = "/proc/self/exe";
+			if(!fs::exists(exe))
+				exe = argv[0];
+			compiler_version = CompileCache::GetFileHash(exe.string());
+		}
+
+		// the grammar is shared by all compilations
+		t_timepoint start_grammar = t_clock::now();
+		parser_data = std::make_unique<ParserData>();
+		grammar_time = std::chrono::duration<t_real>(t_clock::now() - start_grammar).count();
+	}
+	catch(const std::exception& err)
 	{
-		std::cerr << "Error: Input " << script_file << " is not a file." << std::endl;
+		std::cerr << "Error: " << err.what() << std::endl;
 		return -1;
 	}
 
-	if(outfile != "")
+	std::vector<CompileResult> results(progs.size());
+
+	// write the statistics to the standard output or a file
+	auto print_stats = [&]() -> bool
 	{
-		bin_file = outfile;
-	}
-	else
+		if(stats_format == "")
+			return true;
+
+		t_real total_time = std::chrono::duration<t_real>(t_clock::now() - start_codegen).count();
+		if(stats_file == "")
+		{
+			write_stats(std::cout, stats_format == "json", progs, results,
+				compiler_version, grammar_time, total_time);
+			return true;
+		}
+
+		std::ofstream ofstrStats(stats_file);
+		write_stats(ofstrStats, stats_format == "json", progs, results,
+			compiler_version, grammar_time, total_time);
+		if(!ofstrStats)
+		{
+			std::cerr << "Error: Cannot write statistics file \"" << stats_file << "\"." << std::endl;
+			return false;
+		}
+		return true;
+	};
+
+	// single input script
+	if(progs.size() == 1)
 	{
-		bin_file = script_file.filename();
-		bin_file.replace_extension(".bin");
+		results[0] = compile_file(*parser_data, progs[0], bin_files[0],
+			opts, cache.get(), compiler_version, std::cout, std::cerr);
+
+		if(results[0].ok)
+		{
+			auto [run_time, time_unit] = get_elapsed_time<
+				t_real, t_timepoint>(start_codegen);
+			std::cout << "Code generation time: "
+				<< run_time << " " << time_unit << "."
+				<< std::endl;
+
+			if(cache)
+			{
+				std::cout << "Compilation cache: " << cache->GetHits() << " hit(s), "
+					<< cache->GetMisses() << " miss(es)." << std::endl;
+			}
+		}
+
+		if(!print_stats())
+			return -1;
+		return results[0].ok ? 0 : -1;
 	}
 
-	// default output file name
-	if(bin_file.empty())
-		bin_file = "script.bin";
+	// compile multiple input scripts concurrently, each thread takes the next
+	// script and writes its messages in one piece after it is compiled
+	std::atomic<std::size_t> next_prog{0};
+	std::mutex out_mutex;
 
-	if(auto [code_ok, prog] = lalr1_run_parser(
-		script_file, bin_file,
-		debug_codegen, debug_parser, optimise_code);
-		code_ok)
+	auto compile_task = [&]()
 	{
-		auto [run_time, time_unit] = get_elapsed_time<
-			t_real, t_timepoint>(start_codegen);
-		std::cout << "Code generation time: "
-			<< run_time << " " << time_unit << "."
-			<< std::endl;
+		for(std::size_t idx = next_prog++; idx < progs.size(); idx = next_prog++)
+		{
+			std::ostringstream out, err;
+			results[idx] = compile_file(*parser_data, progs[idx], bin_files[idx],
+				opts, cache.get(), compiler_version, out, err);
+
+			std::lock_guard<std::mutex> _lock{out_mutex};
+			std::cout << out.str() << std::flush;
+			std::cerr << err.str() << std::flush;
+		}
+	};
+
+	num_threads = std::clamp<unsigned int>(num_threads, 1, static_cast<unsigned int>(progs.size()));
+	std::vector<std::thread> threads;
+	threads.reserve(num_threads);
+	for(unsigned int thread_idx = 0; thread_idx < num_threads; ++thread_idx)
+		threads.emplace_back(compile_task);
+	for(std::thread& thread : threads)
+		thread.join();
+
+	// summary
+	std::size_t num_ok = 0;
+	std::size_t name_len = std::max_element(progs.begin(), progs.end(),
+		[](const std::string& prog1, const std::string& prog2) -> bool
+	{
+		return prog1.length() < prog2.length();
+	})->length();
+
+	std::cout << "\nCompiled scripts:\n";
+	for(std::size_t idx = 0; idx < progs.size(); ++idx)
+	{
+		const CompileResult& result = results[idx];
+		if(result.ok)
+			++num_ok;
+
+		std::cout << "\t" << std::left << std::setw(name_len) << progs[idx] << " "
+			<< std::setw(8) << (!result.ok ? "failed" : result.cached ? "cached" : "compiled")
+			<< std::right << std::setw(12) << std::fixed << std::setprecision(3)
+			<< result.time * 1000. << " ms" << std::endl;
+	}
+	std::cout.unsetf(std::ios_base::floatfield);
+	std::cout.precision(6);
+
+	auto [run_time, time_unit] = get_elapsed_time<
+		t_real, t_timepoint>(start_codegen);
+	std::cout << num_ok << " of " << progs.size() << " script(s) compiled using "
+		<< num_threads << " thread(s)." << std::endl;
+	std::cout << "Code generation time: "
+		<< run_time << " " << time_unit << "."
+		<< std::endl;
+
+	if(cache)
+	{
+		std::cout << "Compilation cache: " << cache->GetHits() << " hit(s), "
+			<< cache->GetMisses() << " miss(es)." << std::endl;
 	}
 
-	return 0;
+	if(!print_stats())
+		return -1;
+	return num_ok == progs.size() ? 0 : -1;
 }
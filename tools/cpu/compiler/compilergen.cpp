@@ -13,6 +13,7 @@
 #include "lalr1/options.h"
 
 #include "grammar.h"
+#include "parsetab.h"
 #include "lval.h"
 
 #include <iostream>
@@ -25,7 +26,7 @@ using namespace lalr1;
 
 static bool lr1_create_parser(
 	bool create_ascent_parser = true, bool create_tables = false,
-	bool verbose = false, bool gen_debug_code = true, bool gen_error_code = true,
+	bool create_bin_tables = false, bool verbose = false, bool gen_debug_code = true, bool gen_error_code = true,
 	bool write_graph = false)
 {
 	try
@@ -110,7 +111,7 @@ static bool lr1_create_parser(
 				<< parser_file << "\"." << std::endl;
 		}
 
-		if(create_tables)
+		if(create_tables || create_bin_tables)
 		{
 			bool tables_ok = false;
 			TableGen tabgen{collsLALR};
@@ -118,10 +119,43 @@ static bool lr1_create_parser(
 
 			if(tabgen.CreateParseTables())
 			{
-				const char* lalr_tables = "compiler.tab";
-				tables_ok = TableExport::SaveParseTables(tabgen, lalr_tables);
-				std::cout << "Created LALR(1) tables \""
-					<< lalr_tables << "\"." << std::endl;
+				tables_ok = true;
+
+				if(create_tables)
+				{
+					const char* lalr_tables = "compiler.tab";
+					tables_ok = TableExport::SaveParseTables(tabgen, lalr_tables);
+					std::cout << "Created LALR(1) tables \""
+						<< lalr_tables << "\"." << std::endl;
+				}
+
+				// binary tables which the compiler loads at startup
+				if(create_bin_tables)
+				{
+					const char* lalr_bin_tables = "compiler.ptab";
+
+					ParseTableWriter tabwriter{ParseTabConsts{
+						.err = ERROR_VAL,
+						.acc = ACCEPT_VAL,
+						.eps_id = EPS_IDENT,
+						.end_id = END_IDENT,
+						.start_idx = tabgen.GetStartingState(),
+						.acc_rule_idx = tabgen.GetAcceptingRule(),
+					}};
+
+					tabwriter.AddTable(tabgen.GetShiftTable());
+					tabwriter.AddTable(tabgen.GetReduceTable());
+					tabwriter.AddTable(tabgen.GetJumpTable());
+					tabwriter.AddMap(tabgen.GetTermIndexMap());
+					tabwriter.AddMap(tabgen.GetNontermIndexMap());
+					tabwriter.AddMap(tabgen.GetSemanticIndexMap());
+					tabwriter.AddVector(tabgen.GetNumRhsSymbolsPerRule());
+					tabwriter.AddVector(tabgen.GetRuleLhsIndices());
+					tabwriter.Write(lalr_bin_tables);
+
+					std::cout << "Created binary LALR(1) tables \""
+						<< lalr_bin_tables << "\"." << std::endl;
+				}
 			}
 
 			if(!tables_ok)
@@ -148,6 +182,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 	// --------------------------------------------------------------------
 	bool create_asc = false;
 	bool create_tables = false;
+	bool create_bin_tables = false;
 	bool verbose = false;
 	bool no_debug_code = false;
 	bool no_error_code = false;
@@ -161,6 +196,8 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 	arg_descr.add_options()
 		("asc,a", args::bool_switch(&create_asc), "create a recursive ascent parser [default]")
 		("table,t", args::bool_switch(&create_tables), "create LALR(1) tables")
+		("bintable,b", args::bool_switch(&create_bin_tables),
+			"create binary LALR(1) tables, which the compiler loads at startup")
 		("graph,g", args::bool_switch(&write_graph), "write a graph of the parser")
 		("verbose,v", args::bool_switch(&verbose), "enable verbose output for parser generation")
 		("nodebug,d", args::bool_switch(&no_debug_code), "disable generation of debug code for parser")
@@ -195,7 +232,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 	g_options.SetUseColour(colours);
 	g_options.SetUseAsciiChars(ascii);
 
-	if(!create_asc && !create_tables)
+	if(!create_asc && !create_tables && !create_bin_tables)
 	{
 		/*std::cerr << "Warning: Neither recursive ascent parser"
 			<< " nor LALR(1) table generation was selected,"
@@ -208,7 +245,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 	t_timepoint start_parsergen = t_clock::now();
 
 	if(lr1_create_parser(create_asc, create_tables,
-		verbose, !no_debug_code, !no_error_code,
+		create_bin_tables, verbose, !no_debug_code, !no_error_code,
 		write_graph))
 	{
 		auto [run_time, time_unit] = get_elapsed_time<
@@ -63,6 +63,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 	bracket_close = std::make_shared<Terminal>(')', ")");
 	block_begin = std::make_shared<Terminal>('{', "{");
 	block_end = std::make_shared<Terminal>('}', "}");
+	array_begin = std::make_shared<Terminal>('[', "[");
+	array_end = std::make_shared<Terminal>(']', "]");
 
 	comma = std::make_shared<Terminal>(',', ",");
 	colon = std::make_shared<Terminal>(':', ":");
@@ -161,9 +163,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_plus->GetId());
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_plus->GetId());
 		}));
 	}
 	++semanticindex;
@@ -181,9 +183,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_minus->GetId());
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_minus->GetId());
 		}));
 	}
 	++semanticindex;
@@ -201,9 +203,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_mult->GetId());
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_mult->GetId());
 		}));
 	}
 	++semanticindex;
@@ -221,9 +223,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_div->GetId());
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_div->GetId());
 		}));
 	}
 	++semanticindex;
@@ -241,9 +243,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_mod->GetId());
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_mod->GetId());
 		}));
 	}
 	++semanticindex;
@@ -261,9 +263,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_pow->GetId());
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(expr->GetId(), 0, arg1, arg2, op_pow->GetId());
 		}));
 	}
 	++semanticindex;
@@ -298,8 +300,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr rhsident = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr rhsexprs = std::dynamic_pointer_cast<ASTBase>(args[2]);
+			t_astbaseptr rhsident = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr rhsexprs = std::static_pointer_cast<ASTBase>(args[2]);
 
 			if(rhsident->GetType() != ASTType::TOKEN)
 				throw std::runtime_error("Expected a function name.");
@@ -308,7 +310,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 			funcname->SetIdent(true);
 			const std::string& name = funcname->GetLexerValue();
 
-			auto funccall = std::make_shared<ASTFuncCall>(expr->GetId(), 0, name, rhsexprs);
+			auto funccall = make_node<ASTFuncCall>(expr->GetId(), 0, name, rhsexprs);
 			funccall->SetLineRange(funcname->GetLineRange());
 			return funccall;
 		}));
@@ -328,7 +330,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr sym = std::dynamic_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr sym = std::static_pointer_cast<ASTBase>(args[0]);
 			sym->SetDataType(VMType::REAL);
 			sym->SetId(expr->GetId());
 			sym->SetTerminalOverride(false);  // expression, no terminal any more
@@ -350,7 +352,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr sym = std::dynamic_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr sym = std::static_pointer_cast<ASTBase>(args[0]);
 			sym->SetDataType(VMType::INT);
 			sym->SetId(expr->GetId());
 			sym->SetTerminalOverride(false);  // expression, no terminal any more
@@ -372,7 +374,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr sym = std::dynamic_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr sym = std::static_pointer_cast<ASTBase>(args[0]);
 			sym->SetDataType(VMType::STR);
 			sym->SetId(expr->GetId());
 			sym->SetTerminalOverride(false);  // expression, no terminal any more
@@ -416,8 +418,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr expr = std::dynamic_pointer_cast<ASTBase>(args[1]);
-			return std::make_shared<ASTUnary>(expr->GetId(), 0, expr, op_minus->GetId());
+			t_astbaseptr expr = std::static_pointer_cast<ASTBase>(args[1]);
+			return make_node<ASTUnary>(expr->GetId(), 0, expr, op_minus->GetId());
 		}));
 	}
 	++semanticindex;
@@ -435,8 +437,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr rhsexpr = std::dynamic_pointer_cast<ASTBase>(args[1]);
-			return std::make_shared<ASTUnary>(expr->GetId(), 0, rhsexpr, op_plus->GetId());
+			t_astbaseptr rhsexpr = std::static_pointer_cast<ASTBase>(args[1]);
+			return make_node<ASTUnary>(expr->GetId(), 0, rhsexpr, op_plus->GetId());
 		}));
 	}
 	++semanticindex;
@@ -456,8 +458,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 
 			auto _lhsident = std::dynamic_pointer_cast<ASTTypedIdent>(args[0]);
 			VMType datatype = _lhsident->GetDataType();
-			t_astbaseptr lhsident = std::dynamic_pointer_cast<ASTBase>(_lhsident->GetIdent());
-			t_astbaseptr rhsexpr = std::dynamic_pointer_cast<ASTBase>(args[2]);
+			t_astbaseptr lhsident = std::static_pointer_cast<ASTBase>(_lhsident->GetIdent());
+			t_astbaseptr rhsexpr = std::static_pointer_cast<ASTBase>(args[2]);
 
 			if(datatype != rhsexpr->GetDataType() && rhsexpr->GetDataType() != VMType::UNKNOWN)
 			{
@@ -481,7 +483,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 			symname->SetDataType(/*rhsexpr->GetDataType()*/ datatype);
 			//std::cout << "assigning " << symname->GetLexerValue() << std::endl;
 
-			return std::make_shared<ASTBinary>(
+			return make_node<ASTBinary>(
 				expr->GetId(), 0, rhsexpr, symname, op_assign->GetId());
 		}));
 	}
@@ -501,7 +503,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 			if(!full_match) return nullptr;
 
 			auto stmts_lst = std::dynamic_pointer_cast<ASTList>(args[1]);
-			t_astbaseptr rhsstmt = std::dynamic_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr rhsstmt = std::static_pointer_cast<ASTBase>(args[0]);
 			stmts_lst->AddChild(rhsstmt, true);
 			return stmts_lst;
 		}));
@@ -521,7 +523,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			return std::make_shared<ASTList>(stmts->GetId(), 0);
+			return make_node<ASTList>(stmts->GetId(), 0);
 		}));
 	}
 	++semanticindex;
@@ -559,9 +561,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr rhsexpr = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			t_astbaseptr rhsstmts = std::dynamic_pointer_cast<ASTBase>(args[5]);
-			return std::make_shared<ASTCondition>(stmt->GetId(), 0, rhsexpr, rhsstmts);
+			t_astbaseptr rhsexpr = std::static_pointer_cast<ASTBase>(args[2]);
+			t_astbaseptr rhsstmts = std::static_pointer_cast<ASTBase>(args[5]);
+			return make_node<ASTCondition>(stmt->GetId(), 0, rhsexpr, rhsstmts);
 		}));
 	}
 	++semanticindex;
@@ -581,10 +583,10 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr rhsexpr = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			t_astbaseptr rhsstmts = std::dynamic_pointer_cast<ASTBase>(args[5]);
-			t_astbaseptr rhselse_stmts = std::dynamic_pointer_cast<ASTBase>(args[9]);
-			return std::make_shared<ASTCondition>(stmt->GetId(), 0, rhsexpr, rhsstmts, rhselse_stmts);
+			t_astbaseptr rhsexpr = std::static_pointer_cast<ASTBase>(args[2]);
+			t_astbaseptr rhsstmts = std::static_pointer_cast<ASTBase>(args[5]);
+			t_astbaseptr rhselse_stmts = std::static_pointer_cast<ASTBase>(args[9]);
+			return make_node<ASTCondition>(stmt->GetId(), 0, rhsexpr, rhsstmts, rhselse_stmts);
 		}));
 	}
 	++semanticindex;
@@ -603,9 +605,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr rhsexpr = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			t_astbaseptr rhsstmts = std::dynamic_pointer_cast<ASTBase>(args[5]);
-			return std::make_shared<ASTLoop>(stmt->GetId(), 0, rhsexpr, rhsstmts);
+			t_astbaseptr rhsexpr = std::static_pointer_cast<ASTBase>(args[2]);
+			t_astbaseptr rhsstmts = std::static_pointer_cast<ASTBase>(args[5]);
+			return make_node<ASTLoop>(stmt->GetId(), 0, rhsexpr, rhsstmts);
 		}));
 	}
 	++semanticindex;
@@ -630,9 +632,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 				throw std::runtime_error("Expected a function name.");
 			const std::string& ident = funcname->GetLexerValue();
 
-			t_astbaseptr rhsidents = std::dynamic_pointer_cast<ASTBase>(args[3]);  // arguments
-			t_astbaseptr rhsstmts = std::dynamic_pointer_cast<ASTBase>(args[6]);   // block
-			t_astbaseptr func = std::make_shared<ASTFunc>(stmt->GetId(), 0, ident, rhsidents, rhsstmts);
+			t_astbaseptr rhsidents = std::static_pointer_cast<ASTBase>(args[3]);  // arguments
+			t_astbaseptr rhsstmts = std::static_pointer_cast<ASTBase>(args[6]);   // block
+			t_astbaseptr func = make_node<ASTFunc>(stmt->GetId(), 0, ident, rhsidents, rhsstmts);
 			func->SetDataType(funcident->GetDataType());  // return data type
 			func->SetLineRange(funcname->GetLineRange());
 
@@ -655,7 +657,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			auto jump = std::make_shared<ASTJump>(stmt->GetId(), 0, ASTJump::JumpType::BREAK);
+			auto jump = make_node<ASTJump>(stmt->GetId(), 0, ASTJump::JumpType::BREAK);
 			jump->SetLineRange(args[0]->GetLineRange());
 			return jump;
 		}));
@@ -675,8 +677,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr sym = std::dynamic_pointer_cast<ASTBase>(args[1]);
-			return std::make_shared<ASTJump>(stmt->GetId(), 0, ASTJump::JumpType::BREAK, sym);
+			t_astbaseptr sym = std::static_pointer_cast<ASTBase>(args[1]);
+			return make_node<ASTJump>(stmt->GetId(), 0, ASTJump::JumpType::BREAK, sym);
 		}));
 	}
 	++semanticindex;
@@ -694,7 +696,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			auto jump = std::make_shared<ASTJump>(stmt->GetId(), 0, ASTJump::JumpType::CONTINUE);
+			auto jump = make_node<ASTJump>(stmt->GetId(), 0, ASTJump::JumpType::CONTINUE);
 			jump->SetLineRange(args[0]->GetLineRange());
 			return jump;
 		}));
@@ -714,8 +716,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr sym = std::dynamic_pointer_cast<ASTBase>(args[1]);
-			return std::make_shared<ASTJump>(
+			t_astbaseptr sym = std::static_pointer_cast<ASTBase>(args[1]);
+			return make_node<ASTJump>(
 				stmt->GetId(), 0, ASTJump::JumpType::CONTINUE, sym);
 		}));
 	}
@@ -734,7 +736,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			auto jump = std::make_shared<ASTJump>(stmt->GetId(), 0, ASTJump::JumpType::RETURN);
+			auto jump = make_node<ASTJump>(stmt->GetId(), 0, ASTJump::JumpType::RETURN);
 			jump->SetLineRange(args[0]->GetLineRange());
 			return jump;
 		}));
@@ -754,8 +756,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr rhsexpr = std::dynamic_pointer_cast<ASTBase>(args[1]);
-			return std::make_shared<ASTJump>(stmt->GetId(), 0, ASTJump::JumpType::RETURN, rhsexpr);
+			t_astbaseptr rhsexpr = std::static_pointer_cast<ASTBase>(args[1]);
+			return make_node<ASTJump>(stmt->GetId(), 0, ASTJump::JumpType::RETURN, rhsexpr);
 		}));
 	}
 	++semanticindex;
@@ -773,9 +775,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				bool_expr->GetId(), 0, arg1, arg2, op_and->GetId());
 		}));
 	}
@@ -794,9 +796,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				bool_expr->GetId(), 0, arg1, arg2, op_or->GetId());
 		}));
 	}
@@ -815,8 +817,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg = std::dynamic_pointer_cast<ASTBase>(args[1]);
-			return std::make_shared<ASTUnary>(bool_expr->GetId(), 0, arg, op_not->GetId());
+			t_astbaseptr arg = std::static_pointer_cast<ASTBase>(args[1]);
+			return make_node<ASTUnary>(bool_expr->GetId(), 0, arg, op_not->GetId());
 		}));
 	}
 	++semanticindex;
@@ -851,9 +853,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				bool_expr->GetId(), 0, arg1, arg2, op_gt->GetId());
 		}));
 	}
@@ -872,9 +874,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				bool_expr->GetId(), 0, arg1, arg2, op_lt->GetId());
 		}));
 	}
@@ -893,9 +895,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				bool_expr->GetId(), 0, arg1, arg2, op_gequ->GetId());
 		}));
 	}
@@ -914,9 +916,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				bool_expr->GetId(), 0, arg1, arg2, op_lequ->GetId());
 		}));
 	}
@@ -935,9 +937,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				bool_expr->GetId(), 0, arg1, arg2, op_equ->GetId());
 		}));
 	}
@@ -956,9 +958,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				bool_expr->GetId(), 0, arg1, arg2, op_nequ->GetId());
 		}));
 	}
@@ -1003,7 +1005,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 			auto _rhsident = std::dynamic_pointer_cast<ASTTypedIdent>(args[0]);
 			auto rhsident = std::dynamic_pointer_cast<ASTToken<std::string>>(_rhsident->GetIdent());
 
-			auto idents_lst = std::make_shared<ASTList>(idents->GetId(), 0);
+			auto idents_lst = make_node<ASTList>(idents->GetId(), 0);
 			idents_lst->AddChild(rhsident, true);
 			return idents_lst;
 		}));
@@ -1023,7 +1025,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			return std::make_shared<ASTList>(idents->GetId(), 0);
+			return make_node<ASTList>(idents->GetId(), 0);
 		}));
 	}
 	++semanticindex;
@@ -1044,7 +1046,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 			auto rhsident = std::dynamic_pointer_cast<ASTToken<std::string>>(args[0]);
 			rhsident->SetIdent(true);
 
-			return std::make_shared<ASTTypedIdent>(typed_ident->GetId(), 0, rhsident);
+			return make_node<ASTTypedIdent>(typed_ident->GetId(), 0, rhsident);
 		}));
 	}
 	++semanticindex;
@@ -1066,7 +1068,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 			rhsident->SetIdent(true);
 			rhsident->SetDataType(VMType::INT);
 
-			auto ident_ty = std::make_shared<ASTTypedIdent>(typed_ident->GetId(), 0, rhsident);
+			auto ident_ty = make_node<ASTTypedIdent>(typed_ident->GetId(), 0, rhsident);
 			ident_ty->SetDataType(VMType::INT);
 			return ident_ty;
 		}));
@@ -1090,7 +1092,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 			rhsident->SetIdent(true);
 			rhsident->SetDataType(VMType::REAL);
 
-			auto ident_ty = std::make_shared<ASTTypedIdent>(typed_ident->GetId(), 0, rhsident);
+			auto ident_ty = make_node<ASTTypedIdent>(typed_ident->GetId(), 0, rhsident);
 			ident_ty->SetDataType(VMType::REAL);
 			return ident_ty;
 		}));
@@ -1110,7 +1112,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr rhsexpr = std::dynamic_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr rhsexpr = std::static_pointer_cast<ASTBase>(args[0]);
 			auto exprs_lst = std::dynamic_pointer_cast<ASTList>(args[2]);
 			exprs_lst->AddChild(rhsexpr, false);
 			return exprs_lst;
@@ -1131,8 +1133,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr rhsexpr = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			auto exprs_lst = std::make_shared<ASTList>(exprs->GetId(), 0);
+			t_astbaseptr rhsexpr = std::static_pointer_cast<ASTBase>(args[0]);
+			auto exprs_lst = make_node<ASTList>(exprs->GetId(), 0);
 			exprs_lst->AddChild(rhsexpr, false);
 			return exprs_lst;
 		}));
@@ -1152,7 +1154,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			return std::make_shared<ASTList>(exprs->GetId(), 0);
+			return make_node<ASTList>(exprs->GetId(), 0);
 		}));
 	}
 	++semanticindex;
@@ -1170,8 +1172,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg = std::dynamic_pointer_cast<ASTBase>(args[1]);
-			return std::make_shared<ASTUnary>(expr->GetId(), 0, arg, op_binnot->GetId());
+			t_astbaseptr arg = std::static_pointer_cast<ASTBase>(args[1]);
+			return make_node<ASTUnary>(expr->GetId(), 0, arg, op_binnot->GetId());
 		}));
 	}
 	++semanticindex;
@@ -1189,9 +1191,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				expr->GetId(), 0, arg1, arg2, op_binand->GetId());
 		}));
 	}
@@ -1210,9 +1212,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				expr->GetId(), 0, arg1, arg2, op_binor->GetId());
 		}));
 	}
@@ -1231,9 +1233,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				expr->GetId(), 0, arg1, arg2, op_binxor->GetId());
 		}));
 	}
@@ -1252,9 +1254,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				expr->GetId(), 0, arg1, arg2, op_shift_left->GetId());
 		}));
 	}
@@ -1273,9 +1275,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg1 = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr arg2 = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTBinary>(
+			t_astbaseptr arg1 = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr arg2 = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTBinary>(
 				expr->GetId(), 0, arg1, arg2, op_shift_right->GetId());
 		}));
 	}
@@ -1294,9 +1296,9 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr argaddr = std::dynamic_pointer_cast<ASTBase>(args[0]);
-			t_astbaseptr rhsexpr = std::dynamic_pointer_cast<ASTBase>(args[2]);
-			return std::make_shared<ASTDeref>(expr->GetId(), 0, argaddr, rhsexpr);
+			t_astbaseptr argaddr = std::static_pointer_cast<ASTBase>(args[0]);
+			t_astbaseptr rhsexpr = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTDeref>(expr->GetId(), 0, argaddr, rhsexpr);
 		}));
 	}
 	++semanticindex;
@@ -1314,8 +1316,8 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		{
 			if(!full_match) return nullptr;
 
-			t_astbaseptr arg = std::dynamic_pointer_cast<ASTBase>(args[1]);
-			return std::make_shared<ASTDeref>(expr->GetId(), 0, arg);
+			t_astbaseptr arg = std::static_pointer_cast<ASTBase>(args[1]);
+			return make_node<ASTDeref>(expr->GetId(), 0, arg);
 		}));
 	}
 	++semanticindex;
@@ -1332,7 +1334,7 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 		[this](bool full_match, const t_semanticargs& args, [[maybe_unused]] t_lalrastbaseptr retval) -> t_lalrastbaseptr
 		{
 			if(!full_match) return nullptr;
-			t_astbaseptr rhsident = std::dynamic_pointer_cast<ASTBase>(args[1]);
+			t_astbaseptr rhsident = std::static_pointer_cast<ASTBase>(args[1]);
 
 			if(rhsident->GetType() != ASTType::TOKEN)
 				throw std::runtime_error("Expected a variable or function name.");
@@ -1341,10 +1343,112 @@ void ScriptGrammar::CreateGrammar(bool add_rules, bool add_semantics)
 			identname->SetIdent(true);
 
 			const std::string& name = identname->GetLexerValue();
-			auto addrofnode = std::make_shared<ASTAddrOf>(expr->GetId(), 0, name);
+			auto addrofnode = make_node<ASTAddrOf>(expr->GetId(), 0, name);
 			addrofnode->SetLineRange(identname->GetLineRange());
 			return addrofnode;
 		}));
 	}
 	++semanticindex;
+
+
+	// rule: array element on rhs: expr -> ident [ expr ]
+	if(add_rules)
+	{
+		expr->AddRule({ ident, array_begin, expr, array_end }, semanticindex);
+	}
+	if(add_semantics)
+	{
+		rules.emplace(std::make_pair(semanticindex,
+		[this](bool full_match, const t_semanticargs& args, [[maybe_unused]] t_lalrastbaseptr retval) -> t_lalrastbaseptr
+		{
+			if(!full_match) return nullptr;
+
+			auto arrayname = std::dynamic_pointer_cast<ASTToken<std::string>>(args[0]);
+			if(!arrayname)
+				throw std::runtime_error("Expected an array name.");
+			arrayname->SetIdent(true);
+
+			t_astbaseptr index = std::static_pointer_cast<ASTBase>(args[2]);
+			return make_node<ASTArrayAccess>(expr->GetId(), 0, arrayname, index);
+		}));
+	}
+	++semanticindex;
+
+
+	// rule: array element on lhs: expr -> ident [ expr ] = expr
+	if(add_rules)
+	{
+		expr->AddRule({ ident, array_begin, expr, array_end, op_assign, expr }, semanticindex);
+	}
+	if(add_semantics)
+	{
+		rules.emplace(std::make_pair(semanticindex,
+		[this](bool full_match, const t_semanticargs& args, [[maybe_unused]] t_lalrastbaseptr retval) -> t_lalrastbaseptr
+		{
+			if(!full_match) return nullptr;
+
+			auto arrayname = std::dynamic_pointer_cast<ASTToken<std::string>>(args[0]);
+			if(!arrayname)
+				throw std::runtime_error("Expected an array name.");
+			arrayname->SetIdent(true);
+			arrayname->SetLValue(true);
+
+			t_astbaseptr index = std::static_pointer_cast<ASTBase>(args[2]);
+			t_astbaseptr rhsexpr = std::static_pointer_cast<ASTBase>(args[5]);
+			return make_node<ASTArrayAccess>(expr->GetId(), 0, arrayname, index, rhsexpr);
+		}));
+	}
+	++semanticindex;
+
+
+	// rule: array declaration: stmt -> ident : int [ int symbol ] ;
+	if(add_rules)
+	{
+		stmt->AddRule({ ident, colon, keyword_int, array_begin, sym_int, array_end, stmt_end }, semanticindex);
+	}
+	if(add_semantics)
+	{
+		rules.emplace(std::make_pair(semanticindex,
+		[this](bool full_match, const t_semanticargs& args, [[maybe_unused]] t_lalrastbaseptr retval) -> t_lalrastbaseptr
+		{
+			if(!full_match) return nullptr;
+
+			auto arrayname = std::dynamic_pointer_cast<ASTToken<std::string>>(args[0]);
+			auto arraysize = std::dynamic_pointer_cast<ASTToken<t_int>>(args[4]);
+			if(!arrayname || !arraysize)
+				throw std::runtime_error("Expected an array name and size.");
+			arrayname->SetIdent(true);
+			arrayname->SetLValue(true);
+			arrayname->SetDataType(VMType::INT);
+
+			return make_node<ASTArrayDecl>(stmt->GetId(), 0, arrayname, arraysize->GetLexerValue());
+		}));
+	}
+	++semanticindex;
+
+
+	// rule: array declaration: stmt -> ident : real [ int symbol ] ;
+	if(add_rules)
+	{
+		stmt->AddRule({ ident, colon, keyword_real, array_begin, sym_int, array_end, stmt_end }, semanticindex);
+	}
+	if(add_semantics)
+	{
+		rules.emplace(std::make_pair(semanticindex,
+		[this](bool full_match, const t_semanticargs& args, [[maybe_unused]] t_lalrastbaseptr retval) -> t_lalrastbaseptr
+		{
+			if(!full_match) return nullptr;
+
+			auto arrayname = std::dynamic_pointer_cast<ASTToken<std::string>>(args[0]);
+			auto arraysize = std::dynamic_pointer_cast<ASTToken<t_int>>(args[4]);
+			if(!arrayname || !arraysize)
+				throw std::runtime_error("Expected an array name and size.");
+			arrayname->SetIdent(true);
+			arrayname->SetLValue(true);
+			arrayname->SetDataType(VMType::REAL);
+
+			return make_node<ASTArrayDecl>(stmt->GetId(), 0, arrayname, arraysize->GetLexerValue());
+		}));
+	}
+	++semanticindex;
 }
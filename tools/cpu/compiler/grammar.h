@@ -11,6 +11,10 @@
 #include "lalr1/symbol.h"
 #include "lalr1/ast.h"
 
+#include "ast.h"
+
+#include <memory_resource>
+
 
 using lalr1::NonTerminalPtr;
 using lalr1::TerminalPtr;
@@ -55,6 +59,19 @@ public:
 	const NonTerminalPtr& GetStartNonTerminal() const { return start; }
 	const t_semanticrules& GetSemanticRules() const { return rules; }
 
+	// memory pool for the syntax tree nodes created by the semantic rules
+	// the node memory is set per thread, so that concurrent parsers can share the grammar
+	static void SetNodeMemory(std::pmr::memory_resource* mem) { node_mem = mem; }
+	static std::pmr::memory_resource* GetNodeMemory() { return node_mem; }
+
+
+protected:
+	template<class t_node, class ...t_args>
+	std::shared_ptr<t_node> make_node(t_args&&... args) const
+	{
+		return make_ast_node<t_node>(node_mem, std::forward<t_args>(args)...);
+	}
+
 
 private:
 	// non-terminals
@@ -77,6 +94,7 @@ private:
 
 	TerminalPtr bracket_open{}, bracket_close{};
 	TerminalPtr block_begin{}, block_end{};
+	TerminalPtr array_begin{}, array_end{};
 	TerminalPtr comma{}, colon{}, stmt_end{};
 	TerminalPtr sym_real{}, sym_int{}, sym_str{}, ident{};
 
@@ -87,6 +105,9 @@ private:
 
 	// semantic rules
 	t_semanticrules rules{};
+
+	// memory pool for the syntax tree nodes
+	static inline thread_local std::pmr::memory_resource* node_mem{nullptr};
 };
 
 
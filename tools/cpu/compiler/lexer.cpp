@@ -9,8 +9,13 @@
 
 #include <sstream>
 #include <memory>
-#include <regex>
-#include <bitset>
+#include <array>
+#include <unordered_map>
+#include <string_view>
+#include <iterator>
+#include <charconv>
+#include <limits>
+#include <cstdlib>
 #include <type_traits>
 #include <boost/algorithm/string.hpp>
 
@@ -24,200 +29,131 @@ Lexer::Lexer(std::istream* istr) : m_istr{istr}
 
 
 /**
- * find all matching tokens for input string
+ * character classes for the lexer automaton
  */
-std::vector<t_lexer_match>
-Lexer::GetMatchingTokens(const std::string& str, std::size_t line)
+enum class CharClass : std::uint8_t
 {
-	std::vector<t_lexer_match> matches;
+	OTHER,       // invalid input
+	SPACE,       // ' ', '\t'
+	NEWLINE,     // '\n'
+	DIGIT,       // 0-9
+	IDENT,       // _, A-Z, a-z
+	QUOTE,       // '"'
+	COMMENT,     // '#'
+	OP,          // operator and punctuation characters
+};
 
-	if(!m_ignore_int)
-	{	// int
-		static const std::regex regex_int{"(0[xb])?([0-9]+)"};
-		std::smatch smatch;
-		if(std::regex_match(str, smatch, regex_int))
-		{
-			t_int val{};
 
-			if(smatch.str(1) == "0x")
-			{
-				// hexadecimal integers
-				std::istringstream{smatch.str(0)} >> std::hex >> val;
-			}
-			else if(smatch.str(1) == "0b")
-			{
-				// binary integers
-				using t_bits = std::bitset<sizeof(t_int)*8>;
-				t_bits bits(smatch.str(2));
-
-				using t_ulong = std::invoke_result_t<decltype(&t_bits::to_ulong), t_bits*>;
-				if constexpr(sizeof(t_ulong) >= sizeof(t_int))
-					val = static_cast<t_int>(bits.to_ulong());
-				else
-					val = static_cast<t_int>(bits.to_ullong());
-			}
-			else
-			{
-				// decimal integers
-				std::istringstream{smatch.str(2)} >> std::dec >> val;
-			}
+static constexpr std::array<CharClass, 256> get_char_classes()
+{
+	std::array<CharClass, 256> classes{};
+	classes.fill(CharClass::OTHER);
+
+	classes[' '] = classes['\t'] = CharClass::SPACE;
+	classes['\n'] = CharClass::NEWLINE;
+	classes['"'] = CharClass::QUOTE;
+	classes['#'] = CharClass::COMMENT;
+
+	for(int c = '0'; c <= '9'; ++c)
+		classes[c] = CharClass::DIGIT;
+	for(int c = 'A'; c <= 'Z'; ++c)
+		classes[c] = CharClass::IDENT;
+	for(int c = 'a'; c <= 'z'; ++c)
+		classes[c] = CharClass::IDENT;
+	classes['_'] = CharClass::IDENT;
+
+	for(char c : std::string_view{"+-*/%^(){}[],:;=<>!|&"})
+		classes[static_cast<unsigned char>(c)] = CharClass::OP;
+
+	return classes;
+}
 
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::INT), val, line));
-		}
-		else if(str == "0x" || str == "0b")
-		{
-			// dummy matches to continue searching for longest int
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::INT), 0, line));
-		}
-	}
 
-	{	// real
-		static std::regex regex_real{"[0-9]+(\\.[0-9]*)?"};
-		std::smatch smatch;
-		if(std::regex_match(str, smatch, regex_real))
-		{
-			t_real val{};
-			std::istringstream{str} >> val;
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::REAL), val, line));
-		}
-	}
+static constexpr std::array<CharClass, 256> g_char_classes = get_char_classes();
 
-	{	// keywords and identifiers
-		if(str == "if")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::IF), str, line));
-		}
-		else if(str == "else")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::ELSE), str, line));
-		}
-		else if(str == "loop" || str == "while")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::LOOP), str, line));
-		}
-		else if(str == "func")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::FUNC), str, line));
-		}
-		else if(str == "return")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::RETURN), str, line));
-		}
-		else if(str == "break")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::BREAK), str, line));
-		}
-		else if(str == "continue")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::CONTINUE), str, line));
-		}
-		else if(str == "int")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::INT_DECL), str, line));
-		}
-		else if(str == "real")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::REAL_DECL), str, line));
-		}
-		else if(str == "addrof")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::ADDROF), str, line));
-		}
-		else if(str == "deref")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::DEREF), str, line));
-		}
-		else if(str == "<<=")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::DEREF_ASSIGN), str, line));
-		}
-		else
-		{
-			// identifier
-			static const std::regex regex_ident{"[_A-Za-z]+[_A-Za-z0-9]*"};
-			std::smatch smatch;
-			if(std::regex_match(str, smatch, regex_ident))
-				matches.emplace_back(std::make_tuple(
-					static_cast<t_symbol_id>(Token::IDENT), str, line));
-		}
-	}
 
-	{
-		// operators
-		if(str == "==")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::EQU), str, line));
-		}
-		else if(str == "!=" || str == "<>")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::NEQU), str, line));
-		}
-		if(str == "||" || str == "or")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::OR), str, line));
-		}
-		if(str == "&&" || str == "and")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::AND), str, line));
-		}
-		if(str == "xor")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::BIN_XOR), str, line));
-		}
-		else if(str == ">=")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::GEQU), str, line));
-		}
-		else if(str == "<=")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::LEQU), str, line));
-		}
-		else if(str == "<<")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::SHIFT_LEFT), str, line));
-		}
-		else if(str == ">>")
-		{
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(Token::SHIFT_RIGHT), str, line));
-		}
+static inline CharClass get_char_class(char c)
+{
+	return g_char_classes[static_cast<unsigned char>(c)];
+}
+
+
+static inline bool is_ident_char(char c)
+{
+	CharClass cls = get_char_class(c);
+	return cls == CharClass::IDENT || cls == CharClass::DIGIT;
+}
+
+
+/**
+ * keyword table
+ */
+static const std::unordered_map<std::string_view, Token> g_keywords
+{{
+	{ "if", Token::IF },
+	{ "else", Token::ELSE },
+	{ "loop", Token::LOOP },
+	{ "while", Token::LOOP },
+	{ "func", Token::FUNC },
+	{ "return", Token::RETURN },
+	{ "break", Token::BREAK },
+	{ "continue", Token::CONTINUE },
+	{ "int", Token::INT_DECL },
+	{ "real", Token::REAL_DECL },
+	{ "addrof", Token::ADDROF },
+	{ "deref", Token::DEREF },
+}};
+
+
+/**
+ * operators consisting of more than one character, longest ones first
+ */
+static const std::array<std::pair<std::string_view, Token>, 10> g_multichar_ops
+{{
+	{ "<<=", Token::DEREF_ASSIGN },
+	{ "==", Token::EQU },
+	{ "!=", Token::NEQU },
+	{ "<>", Token::NEQU },
+	{ "||", Token::OR },
+	{ "&&", Token::AND },
+	{ ">=", Token::GEQU },
+	{ "<=", Token::LEQU },
+	{ "<<", Token::SHIFT_LEFT },
+	{ ">>", Token::SHIFT_RIGHT },
+}};
+
+
+/**
+ * convert an integer, out-of-range values give the maximum like a stream conversion
+ */
+static t_int to_int(std::string_view digits, int base)
+{
+	t_int val{};
+	auto [ptr, err] = std::from_chars(digits.data(), digits.data() + digits.size(), val, base);
+	if(err == std::errc::result_out_of_range)
+		val = std::numeric_limits<t_int>::max();
+
+	return val;
+}
 
-		// tokens represented by themselves
-		else if(str == "+" || str == "-" || str == "*" || str == "/" ||
-			str == "%" || str == "^" || str == "(" || str == ")" ||
-			str == "{" || str == "}" || str == "[" || str == "]" ||
-			str == "," || str == ":" || str == ";" || str == "=" ||
-			str == ">" || str == "<" ||
-			str == "!" || str == "|" || str == "&")
-			matches.emplace_back(std::make_tuple(
-				static_cast<t_symbol_id>(str[0]), std::nullopt, line));
+
+/**
+ * convert a real, out-of-range values behave like a stream conversion
+ */
+static t_real to_real(std::string_view str)
+{
+	t_real val{};
+	auto [ptr, err] = std::from_chars(str.data(), str.data() + str.size(), val);
+	if(err == std::errc::result_out_of_range)
+	{
+		long double ldval = std::strtold(std::string{str}.c_str(), nullptr);
+		if(ldval > static_cast<long double>(std::numeric_limits<t_real>::max()))
+			val = std::numeric_limits<t_real>::max();
+		else
+			val = static_cast<t_real>(ldval);
 	}
 
-	//std::cerr << "Input \"" << str << "\" has " << matches.size() << " matches." << std::endl;
-	return matches;
+	return val;
 }
 
 
@@ -237,150 +173,234 @@ static void replace_escapes(std::string& str)
  */
 t_lexer_match Lexer::GetNextToken(std::size_t* _line)
 {
-	std::string input;
-	std::vector<t_lexer_match> longest_lexer_matching;
-	bool eof = false;
-	bool in_line_comment = false;
-	bool in_string = false;
-
 	std::size_t dummy_line = 1;
 	std::size_t *line = _line;
 	if(!line) line = &dummy_line;
 
-	// find longest matching token
-	while(!(eof = m_istr->eof()))
+	// scan the whole input buffer in one pass
+	if(!m_input_read)
 	{
-		int c = m_istr->get();
-		if(c == std::char_traits<char>::eof())
-		{
-			eof = true;
-			break;
-		}
-		//std::cout << "Input: " << c << " (0x" << std::hex << int(c) << ")." << std::endl;
+		m_input.assign(std::istreambuf_iterator<char>(*m_istr), std::istreambuf_iterator<char>());
+		m_pos = 0;
+		m_input_read = true;
+	}
 
-		if(in_line_comment && c != '\n')
-			continue;
+	const char *input = m_input.data();
+	const std::size_t len = m_input.size();
+	std::size_t& pos = m_pos;
+
+	while(pos < len)
+	{
+		const char c = input[pos];
 
-		// if outside any other match...
-		if(longest_lexer_matching.size() == 0)
+		switch(get_char_class(c))
 		{
-			if(c == '\"' && !in_line_comment)
+			// ignore white spaces
+			case CharClass::SPACE:
 			{
-				if(!in_string)
-				{
-					in_string = true;
-					continue;
-				}
-				else
+				++pos;
+				break;
+			}
+
+			// end on new line
+			case CharClass::NEWLINE:
+			{
+				++pos;
+				if(m_end_on_newline)
 				{
-					replace_escapes(input);
-					in_string = false;
 					return std::make_tuple(
-						static_cast<t_symbol_id>(Token::STR), input, *line);
+						static_cast<t_symbol_id>(Token::END), std::nullopt, *line);
 				}
+
+				++(*line);
+				break;
 			}
 
-			// ... ignore comments
-			if(c == '#' && !in_string)
+			// ignore comments
+			case CharClass::COMMENT:
 			{
-				in_line_comment = true;
-				continue;
+				while(pos < len && input[pos] != '\n')
+					++pos;
+				break;
 			}
 
-			// ... ignore white spaces
-			if((c==' ' || c=='\t') && !in_string)
-				continue;
+			case CharClass::QUOTE:
+			{
+				std::string str;
+				for(++pos; pos < len; ++pos)
+				{
+					const char strc = input[pos];
+					if(strc == '\"')
+					{
+						++pos;
+						replace_escapes(str);
+						return std::make_tuple(
+							static_cast<t_symbol_id>(Token::STR), str, *line);
+					}
+					else if(strc == '\n')
+					{
+						// new lines are not part of a string
+						if(m_end_on_newline)
+						{
+							++pos;
+							return std::make_tuple(
+								static_cast<t_symbol_id>(Token::END), std::nullopt, *line);
+						}
+						++(*line);
+					}
+					else
+					{
+						str += strc;
+					}
+				}
 
-			// ... end on new line
-			else if(c=='\n')
+				// unterminated string at the end of the input
+				break;
+			}
+
+			// keywords and identifiers
+			case CharClass::IDENT:
 			{
-				if(m_end_on_newline)
+				const std::size_t begin = pos;
+				while(pos < len && is_ident_char(input[pos]))
+					++pos;
+
+				std::string_view word{input + begin, pos - begin};
+				Token tok = Token::IDENT;
+				if(auto iter = g_keywords.find(word); iter != g_keywords.end())
+					tok = iter->second;
+
+				return std::make_tuple(
+					static_cast<t_symbol_id>(tok), std::string{word}, *line);
+			}
+
+			case CharClass::DIGIT:
+			{
+				const std::size_t begin = pos;
+				auto scan_digits = [input, len, &pos]()
 				{
+					while(pos < len && get_char_class(input[pos]) == CharClass::DIGIT)
+						++pos;
+				};
+
+				// hexadecimal and binary integers
+				if(!m_ignore_int && c == '0' && pos + 1 < len
+					&& (input[pos + 1] == 'x' || input[pos + 1] == 'b'))
+				{
+					const bool hex = (input[pos + 1] == 'x');
+					pos += 2;
+
+					const std::size_t digits_begin = pos;
+					scan_digits();
+					std::string_view digits{input + digits_begin, pos - digits_begin};
+
+					t_int val{};
+					if(hex)
+					{
+						val = to_int(digits, 16);
+					}
+					else
+					{
+						// only the leading bits which fit into an int are used
+						digits = digits.substr(0, sizeof(t_int)*8);
+						if(digits.find_first_not_of("01") != std::string_view::npos)
+						{
+							std::ostringstream ostrErr;
+							ostrErr << "Line " << *line << ": Invalid binary number in lexer: \""
+								<< std::string_view{input + begin, pos - begin} << "\".";
+							throw std::runtime_error(ostrErr.str());
+						}
+
+						t_uint bits = 0;
+						for(char bit : digits)
+							bits = (bits << 1) | t_uint(bit - '0');
+						val = static_cast<t_int>(bits);
+					}
+
 					return std::make_tuple(
-						static_cast<t_symbol_id>(Token::END), std::nullopt, *line);
+						static_cast<t_symbol_id>(Token::INT), val, *line);
 				}
-				else
+
+				scan_digits();
+
+				// reals
+				if(pos < len && input[pos] == '.')
 				{
-					in_line_comment = false;
-					++(*line);
-					continue;
+					++pos;
+					scan_digits();
+
+					return std::make_tuple(static_cast<t_symbol_id>(Token::REAL),
+						to_real({input + begin, pos - begin}), *line);
 				}
+
+				std::string_view digits{input + begin, pos - begin};
+				if(m_ignore_int)
+				{
+					return std::make_tuple(static_cast<t_symbol_id>(Token::REAL),
+						to_real(digits), *line);
+				}
+
+				// decimal integers
+				return std::make_tuple(static_cast<t_symbol_id>(Token::INT),
+					to_int(digits, 10), *line);
 			}
-		}
 
-		input += c;
-		if(in_string)
-			continue;
+			// operators
+			case CharClass::OP:
+			{
+				std::string_view rest{input + pos, len - pos};
+				for(const auto& [op, tok] : g_multichar_ops)
+				{
+					if(rest.starts_with(op))
+					{
+						pos += op.size();
+						return std::make_tuple(
+							static_cast<t_symbol_id>(tok), std::string{op}, *line);
+					}
+				}
 
-		auto matching = GetMatchingTokens(input, *line);
-		if(matching.size())
-		{
-			longest_lexer_matching = matching;
+				// tokens represented by themselves
+				++pos;
+				return std::make_tuple(
+					static_cast<t_symbol_id>(c), std::nullopt, *line);
+			}
 
-			if(m_istr->peek() == std::char_traits<char>::eof())
+			case CharClass::OTHER:
+			default:
 			{
-				eof = true;
-				break;
+				std::ostringstream ostrErr;
+				ostrErr << "Line " << *line << ": Invalid input in lexer: \""
+					<< c << "\"" << " (length: 1).";
+				throw std::runtime_error(ostrErr.str());
 			}
 		}
-		else
-		{
-			// no more matches
-			m_istr->putback(c);
-			break;
-		}
 	}
 
-	if(longest_lexer_matching.size() == 0 && eof)
-		return std::make_tuple((t_symbol_id)Token::END, std::nullopt, *line);
-
-	if(longest_lexer_matching.size() == 0)
-	{
-		std::ostringstream ostrErr;
-		ostrErr << "Line " << *line << ": Invalid input in lexer: \""
-			<< input << "\"" << " (length: " << input.length() << ").";
-		throw std::runtime_error(ostrErr.str());
-	}
-
-	/*if(longest_lexer_matching.size() > 1)
-	{
-		std::cerr << "Warning, line " << *line
-			<< ": Ambiguous match in lexer for token \""
-			<< input << "\"." << std::endl;
-	}*/
-
-	return longest_lexer_matching[0];
+	return std::make_tuple((t_symbol_id)Token::END, std::nullopt, *line);
 }
 
 
 /**
- * apply a sequence of functions
+ * create the parser's token node, optionally in a memory pool
  */
-template<template<std::size_t, class...> class t_func, class t_params, std::size_t ...seq>
-constexpr void apply_seq(const std::index_sequence<seq...>&, const t_params& params)
+static t_toknode make_token_node(const t_lexer_match& tok, t_index tableidx,
+	std::pmr::memory_resource* mem)
 {
-	( (std::apply(t_func<seq>{}, params)), ... );
-}
+	const t_symbol_id id = std::get<0>(tok);
+	const t_lval& lval = std::get<1>(tok);
+	const std::size_t line = std::get<2>(tok);
 
+	// token without attribute
+	if(!lval)
+		return make_ast_node<ASTToken<void*>>(mem, id, tableidx, line);
 
-/**
- * function for sequential applying
- */
-template<std::size_t IDX> struct _Lval_SeqFunc
-{
-	void operator()(
-		std::vector<t_toknode>* vec, t_symbol_id id, t_index tableidx,
-		const t_lval& lval, std::size_t line) const
+	// token with an attribute of the type held by the variant
+	return std::visit([id, tableidx, line, mem](const auto& val) -> t_toknode
 	{
-		using t_val = std::variant_alternative_t<IDX, typename t_lval::value_type>;
-
-		if(std::holds_alternative<t_val>(*lval))
-		{
-			vec->emplace_back(std::make_shared<ASTToken<t_val>>(
-				id, tableidx, std::get<IDX>(*lval), line));
-		}
-	};
-};
+		using t_val = std::decay_t<decltype(val)>;
+		return make_ast_node<ASTToken<t_val>>(mem, id, tableidx, val, line);
+	}, *lval);
+}
 
 
 /**
@@ -391,12 +411,10 @@ std::vector<t_toknode> Lexer::GetAllTokens()
 	std::vector<t_toknode> vec;
 	std::size_t line = 1;
 
-	while(1)
+	while(true)
 	{
-		auto tup = GetNextToken(&line);
-		t_symbol_id id = std::get<0>(tup);
-		const t_lval& lval = std::get<1>(tup);
-		std::size_t line = std::get<2>(tup);
+		auto tok = GetNextToken(&line);
+		t_symbol_id id = std::get<0>(tok);
 
 		// get index into parse tables
 		t_index tableidx = 0;
@@ -407,19 +425,7 @@ std::vector<t_toknode> Lexer::GetAllTokens()
 				tableidx = iter->second;
 		}
 
-		// does this token have an attribute?
-		if(lval)
-		{
-			// find the correct type in the variant
-			auto seq = std::make_index_sequence<
-				std::variant_size_v<typename t_lval::value_type>>();
-
-			apply_seq<_Lval_SeqFunc>(seq, std::make_tuple(&vec, id, tableidx, lval, line));
-		}
-		else
-		{
-			vec.emplace_back(std::make_shared<ASTToken<void*>>(id, tableidx, line));
-		}
+		vec.emplace_back(make_token_node(tok, tableidx, m_node_mem));
 
 		if(id == (t_symbol_id)Token::END)
 			break;
@@ -13,6 +13,7 @@
 #include <vector>
 #include <utility>
 #include <optional>
+#include <memory_resource>
 
 #include "ast.h"
 #include "lval.h"
@@ -85,6 +86,9 @@ class Lexer
 public:
 	Lexer(std::istream* = &std::cin);
 
+	Lexer(const Lexer&) = delete;
+	const Lexer& operator=(const Lexer&) = delete;
+
 	// get all tokens and attributes
 	std::vector<t_toknode> GetAllTokens();
 
@@ -92,15 +96,15 @@ public:
 	void SetIgnoreInt(bool b) { m_ignore_int = b; }
 	void SetTermIdxMap(const t_mapIdIdx* map) { m_mapTermIdx = map; }
 
+	// memory pool for the token nodes, which has to outlive them
+	void SetNodeMemory(std::pmr::memory_resource* mem) { m_node_mem = mem; }
+	std::pmr::memory_resource* GetNodeMemory() const { return m_node_mem; }
+
 
 protected:
 	// get next token and attribute
 	t_lexer_match GetNextToken(std::size_t* line = nullptr);
 
-	// find all matching tokens for input string
-	std::vector<t_lexer_match> GetMatchingTokens(
-		const std::string& str, std::size_t line);
-
 
 private:
 	bool m_end_on_newline{true};
@@ -108,6 +112,11 @@ private:
 
 	std::istream* m_istr{nullptr};
 	const t_mapIdIdx* m_mapTermIdx{nullptr};
+	std::pmr::memory_resource* m_node_mem{nullptr};
+
+	std::string m_input{};       // input buffer
+	std::size_t m_pos{0};        // current position in the input buffer
+	bool m_input_read{false};
 };
 
 
@@ -0,0 +1,104 @@
+/**
+ * linker combining compiled modules into a program
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "objfile.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+
+#include <boost/program_options.hpp>
+namespace args = boost::program_options;
+
+
+int main(int argc, char** argv)
+{
+	std::ios_base::sync_with_stdio(false);
+
+	// --------------------------------------------------------------------
+	// get program arguments
+	// --------------------------------------------------------------------
+	std::vector<std::string> modules;
+	std::string outfile = "script.bin";
+
+	args::options_description arg_descr("Script linker arguments");
+	arg_descr.add_options()
+	("output,o", args::value<decltype(outfile)>(&outfile), "output binary file")
+	("module", args::value<decltype(modules)>(&modules),
+		"input modules, they are run in the given order");
+
+	args::positional_options_description posarg_descr;
+	posarg_descr.add("module", -1);
+
+	auto argparser = args::command_line_parser{argc, argv};
+	argparser.style(args::command_line_style::default_style);
+	argparser.options(arg_descr);
+	argparser.positional(posarg_descr);
+
+	args::variables_map mapArgs;
+	auto parsedArgs = argparser.run();
+	args::store(parsedArgs, mapArgs);
+	args::notify(mapArgs);
+
+	if(modules.size() == 0)
+	{
+		std::cout << "Script linker"
+			<< " by Tobias Weber <tobias.weber@tum.de>, 2022-2026."
+			<< std::endl;
+
+		std::cerr << "Please specify the modules to link.\n" << std::endl;
+		std::cout << arg_descr << std::endl;
+		return 0;
+	}
+	// --------------------------------------------------------------------
+
+	try
+	{
+		std::vector<ObjFile> objs;
+		objs.reserve(modules.size());
+
+		for(const std::string& module : modules)
+		{
+			std::ifstream ifstrObj(module, std::ios_base::in | std::ios_base::binary);
+			if(!ifstrObj)
+			{
+				std::cerr << "Error: Cannot open module \"" << module << "\"." << std::endl;
+				return -1;
+			}
+
+			objs.emplace_back(read_obj(ifstrObj));
+		}
+
+		std::vector<t_byte> code = link_objs(objs, modules);
+
+		std::ofstream ofstrBin(outfile, std::ios_base::out
+			| std::ios_base::trunc | std::ios_base::binary);
+		if(!ofstrBin)
+		{
+			std::cerr << "Error: Cannot open output file \"" << outfile << "\"." << std::endl;
+			return -1;
+		}
+
+		ofstrBin.write(reinterpret_cast<const char*>(code.data()), code.size());
+		if(ofstrBin.fail())
+		{
+			std::cerr << "Error: Cannot write \"" << outfile << "\"." << std::endl;
+			return -1;
+		}
+
+		std::cout << "Linked " << modules.size() << " module(s) into program \""
+			<< outfile << "\"." << std::endl;
+	}
+	catch(const std::exception& err)
+	{
+		std::cerr << "Error: " << err.what() << std::endl;
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,351 @@
+/**
+ * relocatable object files and linker
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "objfile.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <stdexcept>
+
+
+/**
+ * object file format:
+ *   header: magic "0ACO" and a version byte,
+ *   sizes: global variables, memo tables (t_int each),
+ *   functions: count, then name, address, and number of arguments per function,
+ *   relocations: count, then type byte, position, name, offset, address flags,
+ *                and number of arguments per relocation,
+ *   code: size, then the bytes,
+ *   the integers are t_int in host byte order, the names are prefixed by their length
+ */
+static constexpr const char g_obj_magic[] = { '0', 'A', 'C', 'O' };
+static constexpr const t_byte g_obj_version = 1;
+
+
+template<class t_val>
+static void write_value(std::ostream& ostr, const t_val& val)
+{
+	ostr.write(reinterpret_cast<const char*>(&val), sizeof(t_val));
+}
+
+
+static void write_str(std::ostream& ostr, const std::string& str)
+{
+	write_value<t_int>(ostr, static_cast<t_int>(str.size()));
+	ostr.write(str.data(), str.size());
+}
+
+
+template<class t_val>
+static t_val read_value(std::istream& istr)
+{
+	t_val val{};
+	if(!istr.read(reinterpret_cast<char*>(&val), sizeof(t_val)))
+		throw std::runtime_error("Truncated object file.");
+	return val;
+}
+
+
+static t_int read_size(std::istream& istr)
+{
+	t_int size = read_value<t_int>(istr);
+	if(size < 0)
+		throw std::runtime_error("Invalid object file.");
+	return size;
+}
+
+
+static std::string read_str(std::istream& istr)
+{
+	std::string str(read_size(istr), '\0');
+	if(!istr.read(str.data(), str.size()))
+		throw std::runtime_error("Truncated object file.");
+	return str;
+}
+
+
+template<class t_val>
+static t_val get_code_value(const std::vector<t_byte>& code, std::size_t pos)
+{
+	if(pos + sizeof(t_val) > code.size())
+		throw std::runtime_error("Relocation is out of the code bounds.");
+
+	t_val val{};
+	std::memcpy(&val, code.data() + pos, sizeof(t_val));
+	return val;
+}
+
+
+template<class t_val>
+static void set_code_value(std::vector<t_byte>& code, std::size_t pos, const t_val& val)
+{
+	if(pos + sizeof(t_val) > code.size())
+		throw std::runtime_error("Relocation is out of the code bounds.");
+
+	std::memcpy(code.data() + pos, &val, sizeof(t_val));
+}
+
+
+/**
+ * add the relocations for the global variables and memo tables,
+ * which are accessed by offsets following the instructions
+ */
+void add_relative_relocs(ObjFile& obj, std::size_t code_end)
+{
+	for(std::size_t pos = 0; pos < code_end;)
+	{
+		OpCode op = static_cast<OpCode>(obj.code[pos]);
+		RelocType ty{};
+		bool reloc = true;
+
+		switch(op)
+		{
+			case OpCode::RDGBP:
+			case OpCode::WRGBP:
+			case OpCode::RDGBP_R:
+			case OpCode::WRGBP_R:
+			case OpCode::RDGBPIDX:
+			case OpCode::WRGBPIDX:
+			case OpCode::RDGBPIDX_R:
+			case OpCode::WRGBPIDX_R:
+				ty = RelocType::GLOBAL_OFFS;
+				break;
+
+			case OpCode::MEMOGET:
+			case OpCode::MEMOSET:
+				ty = RelocType::HEAP_OFFS;
+				break;
+
+			default:
+				reloc = false;
+				break;
+		}
+
+		if(reloc)
+		{
+			obj.relocs.emplace_back(ObjReloc
+			{
+				.ty = ty,
+				.pos = static_cast<t_int>(pos + 1),
+				.name = "",
+				.offs = 0,
+				.flags = ADDR_FLAG_NONE,
+				.num_args = -1,
+			});
+		}
+
+		pos += 1 + get_vm_opcode_data_size(op);
+	}
+}
+
+
+void write_obj(const ObjFile& obj, std::ostream& ostr)
+{
+	ostr.write(g_obj_magic, sizeof(g_obj_magic));
+	ostr.put(static_cast<char>(g_obj_version));
+
+	write_value<t_int>(ostr, obj.glob_size);
+	write_value<t_int>(ostr, obj.heap_size);
+
+	write_value<t_int>(ostr, static_cast<t_int>(obj.funcs.size()));
+	for(const ObjSymbol& func : obj.funcs)
+	{
+		write_str(ostr, func.name);
+		write_value<t_int>(ostr, func.addr);
+		write_value<t_int>(ostr, func.num_args);
+	}
+
+	write_value<t_int>(ostr, static_cast<t_int>(obj.relocs.size()));
+	for(const ObjReloc& reloc : obj.relocs)
+	{
+		write_value<t_byte>(ostr, static_cast<t_byte>(reloc.ty));
+		write_value<t_int>(ostr, reloc.pos);
+		write_str(ostr, reloc.name);
+		write_value<t_int>(ostr, reloc.offs);
+		write_value<t_int>(ostr, reloc.flags);
+		write_value<t_int>(ostr, reloc.num_args);
+	}
+
+	write_value<t_int>(ostr, static_cast<t_int>(obj.code.size()));
+	ostr.write(reinterpret_cast<const char*>(obj.code.data()), obj.code.size());
+}
+
+
+ObjFile read_obj(std::istream& istr)
+{
+	char magic[sizeof(g_obj_magic)]{};
+	if(!istr.read(magic, sizeof(magic))
+		|| !std::equal(std::begin(g_obj_magic), std::end(g_obj_magic), magic)
+		|| read_value<t_byte>(istr) != g_obj_version)
+		throw std::runtime_error("Invalid object file.");
+
+	ObjFile obj;
+	obj.glob_size = read_size(istr);
+	obj.heap_size = read_size(istr);
+
+	obj.funcs.resize(read_size(istr));
+	for(ObjSymbol& func : obj.funcs)
+	{
+		func.name = read_str(istr);
+		func.addr = read_value<t_int>(istr);
+		func.num_args = read_value<t_int>(istr);
+	}
+
+	obj.relocs.resize(read_size(istr));
+	for(ObjReloc& reloc : obj.relocs)
+	{
+		reloc.ty = static_cast<RelocType>(read_value<t_byte>(istr));
+		reloc.pos = read_value<t_int>(istr);
+		reloc.name = read_str(istr);
+		reloc.offs = read_value<t_int>(istr);
+		reloc.flags = read_value<t_int>(istr);
+		reloc.num_args = read_value<t_int>(istr);
+	}
+
+	obj.code.resize(read_size(istr));
+	if(!istr.read(reinterpret_cast<char*>(obj.code.data()), obj.code.size()))
+		throw std::runtime_error("Truncated object file.");
+
+	return obj;
+}
+
+
+/**
+ * combine the modules into one program,
+ * their code is run in the given order, followed by a final halt instruction
+ */
+std::vector<t_byte> link_objs(const std::vector<ObjFile>& objs,
+	const std::vector<std::string>& names)
+{
+	std::vector<t_byte> code;
+
+	// start addresses, global variable, and heap offsets of the modules
+	std::vector<t_int> code_bases, glob_bases, heap_bases;
+	t_int glob_size = 0, heap_size = 0;
+
+	// addresses and number of arguments of the functions
+	std::unordered_map<std::string, std::pair<t_int, t_int>> funcs;
+
+	for(std::size_t objidx = 0; objidx < objs.size(); ++objidx)
+	{
+		const ObjFile& obj = objs[objidx];
+		const t_int code_base = static_cast<t_int>(code.size());
+
+		for(const ObjSymbol& func : obj.funcs)
+		{
+			if(!funcs.emplace(func.name, std::make_pair(code_base + func.addr, func.num_args)).second)
+			{
+				throw std::runtime_error("Function \"" + func.name
+					+ "\" in " + names[objidx] + " is already defined in another module.");
+			}
+		}
+
+		code_bases.push_back(code_base);
+		glob_bases.push_back(glob_size);
+		heap_bases.push_back(heap_size);
+
+		code.insert(code.end(), obj.code.begin(), obj.code.end());
+		glob_size += obj.glob_size;
+		heap_size += obj.heap_size;
+	}
+
+	// the last module continues at the end of the program
+	code_bases.push_back(static_cast<t_int>(code.size()));
+	code.push_back(static_cast<t_byte>(OpCode::HALT));
+
+	for(std::size_t objidx = 0; objidx < objs.size(); ++objidx)
+	{
+		for(const ObjReloc& reloc : objs[objidx].relocs)
+		{
+			const t_int pos = code_bases[objidx] + reloc.pos;
+
+			switch(reloc.ty)
+			{
+				case RelocType::FUNC:
+				{
+					t_int addr = 0;
+					if(reloc.name == OBJ_NEXT_MODULE)
+					{
+						addr = code_bases[objidx + 1];
+					}
+					else
+					{
+						auto iter = funcs.find(reloc.name);
+						if(iter == funcs.end())
+						{
+							throw std::runtime_error("Function \"" + reloc.name
+								+ "\" called in " + names[objidx] + " is not defined.");
+						}
+
+						auto [func_addr, num_args] = iter->second;
+						if(reloc.num_args >= 0 && reloc.num_args != num_args)
+						{
+							throw std::runtime_error("Function \"" + reloc.name
+								+ "\" takes " + std::to_string(num_args) + " arguments, but "
+								+ std::to_string(reloc.num_args) + " were given in "
+								+ names[objidx] + ".");
+						}
+						addr = func_addr;
+					}
+
+					// relative to the end of the following one-byte instruction
+					addr += reloc.offs;
+					if(reloc.flags == ADDR_FLAG_IP)
+						addr -= pos + static_cast<t_int>(sizeof(t_int)) + 1;
+
+					set_code_value<t_int>(code, pos, encode_addr<t_int>(addr, reloc.flags));
+					break;
+				}
+
+				case RelocType::CODE_ADDR:
+				{
+					auto [addr, flags] = decode_addr<t_int>(get_code_value<t_int>(code, pos));
+					set_code_value<t_int>(code, pos,
+						encode_addr<t_int>(addr + code_bases[objidx], flags));
+					break;
+				}
+
+				case RelocType::GLOBAL_OFFS:
+				{
+					t_int offs = get_code_value<t_offs>(code, pos) - glob_bases[objidx];
+					if(offs < std::numeric_limits<t_offs>::min())
+					{
+						throw std::runtime_error("Global variables of " + names[objidx]
+							+ " are out of reach of the global base pointer.");
+					}
+
+					set_code_value<t_offs>(code, pos, static_cast<t_offs>(offs));
+					break;
+				}
+
+				case RelocType::GLOBAL_ADDR:
+				{
+					auto [addr, flags] = decode_addr<t_int>(get_code_value<t_int>(code, pos));
+					set_code_value<t_int>(code, pos,
+						encode_addr<t_int>(addr - glob_bases[objidx], flags));
+					break;
+				}
+
+				case RelocType::HEAP_OFFS:
+				{
+					t_int offs = get_code_value<t_int>(code, pos) + heap_bases[objidx];
+					set_code_value<t_int>(code, pos, offs);
+					break;
+				}
+
+				default:
+				{
+					throw std::runtime_error("Invalid relocation in " + names[objidx] + ".");
+				}
+			}
+		}
+	}
+
+	return code;
+}
@@ -0,0 +1,86 @@
+/**
+ * relocatable object files and linker
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#ifndef __LR1_OBJFILE_H__
+#define __LR1_OBJFILE_H__
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "vm/opcodes.h"
+
+
+// name of the symbol referring to the start of the next module,
+// '@' cannot occur in identifiers, so it does not clash with a function name
+constexpr const char* OBJ_NEXT_MODULE = "@next";
+
+
+/**
+ * kinds of address references which change when the module is moved
+ */
+enum class RelocType : t_byte
+{
+	FUNC        = 0x00,  // encoded address of a function, possibly in another module
+	CODE_ADDR   = 0x01,  // encoded absolute address in the module's code
+	GLOBAL_OFFS = 0x02,  // offset of a relative global variable access
+	GLOBAL_ADDR = 0x03,  // encoded address of a global variable
+	HEAP_OFFS   = 0x04,  // offset of a memo table to the heap pointer
+};
+
+
+/**
+ * function defined in a module
+ */
+struct ObjSymbol
+{
+	std::string name{};
+	t_int addr{};            // address relative to the module's start
+	t_int num_args{};
+};
+
+
+/**
+ * position in the code which has to be adjusted when linking
+ */
+struct ObjReloc
+{
+	RelocType ty{RelocType::FUNC};
+	t_int pos{};             // position of the address or offset in the module's code
+
+	// referenced function
+	std::string name{};
+	t_int offs{};            // offset to add to the function address
+	t_int flags{ADDR_FLAG_IP};
+	t_int num_args{-1};      // number of arguments of the call, -1: unknown
+};
+
+
+/**
+ * relocatable compiled module
+ */
+struct ObjFile
+{
+	std::vector<t_byte> code{};        // code and constants
+	t_int glob_size{};                 // size of the module's global variables
+	t_int heap_size{};                 // size of the module's memo tables
+
+	std::vector<ObjSymbol> funcs{};    // defined functions
+	std::vector<ObjReloc> relocs{};
+};
+
+
+extern void add_relative_relocs(ObjFile& obj, std::size_t code_end);
+
+extern void write_obj(const ObjFile& obj, std::ostream& ostr);
+extern ObjFile read_obj(std::istream& istr);
+
+extern std::vector<t_byte> link_objs(const std::vector<ObjFile>& objs,
+	const std::vector<std::string>& names);
+
+
+#endif
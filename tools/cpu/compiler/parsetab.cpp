@@ -0,0 +1,209 @@
+/**
+ * binary lalr(1) parse tables
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "parsetab.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+/**
+ * the file starts with a magic number and the version, followed by the constants,
+ * all sections are aligned to 64 bits, so that they can be used directly from the mapped file
+ */
+static constexpr const char g_tab_magic[] = { '0', 'A', 'C', 'T' };
+static constexpr std::uint32_t g_tab_version = 1;
+
+
+// --------------------------------------------------------------------
+// writing
+// --------------------------------------------------------------------
+ParseTableWriter::ParseTableWriter(const ParseTabConsts& consts)
+	: m_consts{consts}
+{
+	Append(g_tab_magic, sizeof(g_tab_magic));
+	Append(&g_tab_version, sizeof(g_tab_version));
+	Append(&m_consts, sizeof(m_consts));
+}
+
+
+void ParseTableWriter::Append(const void* data, std::size_t size)
+{
+	m_data.append(reinterpret_cast<const char*>(data), size);
+}
+
+
+std::uint32_t ParseTableWriter::EncodeCell(std::uint64_t val) const
+{
+	if(val == m_consts.err)
+		return PARSETAB_ERR;
+	if(val == m_consts.acc)
+		return PARSETAB_ACC;
+	if(val >= PARSETAB_ACC)
+		throw std::runtime_error("Parse table entry " + std::to_string(val)
+			+ " is too large for the binary table file.");
+
+	return static_cast<std::uint32_t>(val);
+}
+
+
+void ParseTableWriter::AddTable(std::size_t rows, std::size_t cols,
+	const std::vector<std::uint32_t>& cells)
+{
+	if(m_num_maps || m_num_vecs)
+		throw std::runtime_error("Parse tables have to precede the index maps and vectors.");
+
+	const std::uint64_t dims[] = { rows, cols };
+	Append(dims, sizeof(dims));
+	Append(cells.data(), cells.size() * sizeof(std::uint32_t));
+
+	// pad to 64 bits
+	if(cells.size() % 2)
+		Append(&PARSETAB_ERR, sizeof(PARSETAB_ERR));
+
+	++m_num_tables;
+}
+
+
+/**
+ * add an index map (two words per element) or an index vector (one word per element)
+ */
+void ParseTableWriter::AddWords(const std::vector<std::uint64_t>& words, std::size_t per_elem)
+{
+	if(per_elem == 2 && m_num_vecs)
+		throw std::runtime_error("Index maps have to precede the index vectors.");
+
+	const std::uint64_t size = words.size() / per_elem;
+	Append(&size, sizeof(size));
+	Append(words.data(), words.size() * sizeof(std::uint64_t));
+
+	if(per_elem == 2)
+		++m_num_maps;
+	else
+		++m_num_vecs;
+}
+
+
+void ParseTableWriter::Write(const std::string& file) const
+{
+	if(m_num_tables != PARSETAB_NUM_TABLES || m_num_maps != PARSETAB_NUM_MAPS
+		|| m_num_vecs != PARSETAB_NUM_VECS)
+		throw std::runtime_error("Incomplete parse tables.");
+
+	std::ofstream ofstr(file, std::ios_base::binary);
+	ofstr.write(m_data.data(), static_cast<std::streamsize>(m_data.size()));
+	if(!ofstr)
+		throw std::runtime_error("Cannot write parse table file \"" + file + "\".");
+}
+// --------------------------------------------------------------------
+
+
+
+// --------------------------------------------------------------------
+// reading
+// --------------------------------------------------------------------
+/**
+ * map the table file and find its sections
+ */
+ParseTableFile::ParseTableFile(const std::string& file)
+{
+	int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		throw std::runtime_error("Cannot open parse table file \"" + file + "\".");
+
+	struct ::stat st{};
+	if(::fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		::close(fd);
+		throw std::runtime_error("Invalid parse table file \"" + file + "\".");
+	}
+
+	// the whole file is read right away, so fault in all pages at once
+	int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+	flags |= MAP_POPULATE;
+#endif
+
+	m_size = static_cast<std::size_t>(st.st_size);
+	void *mem = ::mmap(nullptr, m_size, PROT_READ, flags, fd, 0);
+	::close(fd);
+	if(mem == MAP_FAILED)
+		throw std::runtime_error("Cannot map parse table file \"" + file + "\".");
+	m_data = reinterpret_cast<const unsigned char*>(mem);
+
+	try
+	{
+		const char* magic = reinterpret_cast<const char*>(Read(sizeof(g_tab_magic)));
+		if(!std::equal(std::begin(g_tab_magic), std::end(g_tab_magic), magic)
+			|| *reinterpret_cast<const std::uint32_t*>(Read(sizeof(g_tab_version))) != g_tab_version)
+			throw std::runtime_error("Invalid parse table file \"" + file + "\".");
+
+		m_consts = *reinterpret_cast<const ParseTabConsts*>(Read(sizeof(ParseTabConsts)));
+
+		for(Table& tab : m_tables)
+		{
+			const std::uint64_t* dims = reinterpret_cast<const std::uint64_t*>(
+				Read(2 * sizeof(std::uint64_t)));
+			tab.rows = dims[0];
+			tab.cols = dims[1];
+
+			// cells, padded to 64 bits
+			const std::size_t num_cells = tab.rows * tab.cols;
+			if((tab.cols && num_cells / tab.cols != tab.rows)
+				|| num_cells > m_size / sizeof(std::uint32_t))
+				throw std::runtime_error("Invalid parse table size.");
+			tab.cells = reinterpret_cast<const std::uint32_t*>(
+				Read((num_cells + num_cells % 2) * sizeof(std::uint32_t)));
+		}
+
+		auto read_words = [this](Words& words, std::size_t per_elem)
+		{
+			words.size = *reinterpret_cast<const std::uint64_t*>(Read(sizeof(std::uint64_t)));
+			if(words.size > m_size / sizeof(std::uint64_t))
+				throw std::runtime_error("Invalid index map size.");
+			words.words = reinterpret_cast<const std::uint64_t*>(
+				Read(words.size * per_elem * sizeof(std::uint64_t)));
+		};
+
+		for(Words& map : m_maps)
+			read_words(map, 2);
+		for(Words& vec : m_vecs)
+			read_words(vec, 1);
+	}
+	catch(const std::exception&)
+	{
+		::munmap(const_cast<unsigned char*>(m_data), m_size);
+		throw;
+	}
+}
+
+
+ParseTableFile::~ParseTableFile()
+{
+	::munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+
+/**
+ * get the next section of the file
+ */
+const void* ParseTableFile::Read(std::size_t size)
+{
+	if(size > m_size - m_pos)
+		throw std::runtime_error("Truncated parse table file.");
+
+	const void* data = m_data + m_pos;
+	m_pos += size;
+	return data;
+}
+// --------------------------------------------------------------------
@@ -0,0 +1,259 @@
+/**
+ * binary lalr(1) parse tables
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#ifndef __LR1_PARSETAB_H__
+#define __LR1_PARSETAB_H__
+
+#include <string>
+#include <vector>
+#include <array>
+#include <tuple>
+#include <cstdint>
+#include <cstddef>
+
+
+// cell values of the error and accept actions in the binary tables
+constexpr std::uint32_t PARSETAB_ERR = 0xffffffff;
+constexpr std::uint32_t PARSETAB_ACC = 0xfffffffe;
+
+
+/**
+ * the parse tables are written in a fixed order:
+ * shift, reduce, and jump tables, terminal, non-terminal, and semantic rule index maps,
+ * numbers of right-hand side symbols and left-hand side indices of the rules
+ */
+enum class ParseTab : std::size_t
+{
+	SHIFT = 0, REDUCE, JUMP,                      // tables
+	TERM_IDX = 0, NONTERM_IDX, SEMANTIC_IDX,      // index maps
+	NUM_RHS = 0, LHS_IDX,                         // index vectors
+};
+
+constexpr std::size_t PARSETAB_NUM_TABLES = 3;
+constexpr std::size_t PARSETAB_NUM_MAPS = 3;
+constexpr std::size_t PARSETAB_NUM_VECS = 2;
+
+
+/**
+ * constants of the parser
+ */
+struct ParseTabConsts
+{
+	std::uint64_t err{};        // values of the error and accept actions in the parser's tables
+	std::uint64_t acc{};
+	std::uint64_t eps_id{};
+	std::uint64_t end_id{};
+	std::uint64_t start_idx{};
+	std::uint64_t acc_rule_idx{};
+};
+
+
+/**
+ * serialises the parse tables into a compact binary file,
+ * the table cells are stored with 32 bits
+ */
+class ParseTableWriter
+{
+public:
+	ParseTableWriter(const ParseTabConsts& consts);
+
+	template<class t_table>
+	void AddTable(const t_table& tab)
+	{
+		std::vector<std::uint32_t> cells;
+		cells.reserve(tab.size1() * tab.size2());
+
+		for(std::size_t row = 0; row < tab.size1(); ++row)
+			for(std::size_t col = 0; col < tab.size2(); ++col)
+				cells.push_back(EncodeCell(tab(row, col)));
+
+		AddTable(tab.size1(), tab.size2(), cells);
+	}
+
+	template<class t_map>
+	void AddMap(const t_map& map)
+	{
+		std::vector<std::uint64_t> pairs;
+		pairs.reserve(map.size() * 2);
+
+		for(const auto& [id, idx] : map)
+		{
+			pairs.push_back(static_cast<std::uint64_t>(id));
+			pairs.push_back(static_cast<std::uint64_t>(idx));
+		}
+
+		AddWords(pairs, 2);
+	}
+
+	template<class t_vec>
+	void AddVector(const t_vec& vec)
+	{
+		AddWords(std::vector<std::uint64_t>(vec.begin(), vec.end()), 1);
+	}
+
+	void Write(const std::string& file) const;
+
+
+protected:
+	std::uint32_t EncodeCell(std::uint64_t val) const;
+
+	void AddTable(std::size_t rows, std::size_t cols,
+		const std::vector<std::uint32_t>& cells);
+	void AddWords(const std::vector<std::uint64_t>& words, std::size_t per_elem);
+
+	void Append(const void* data, std::size_t size);
+
+
+private:
+	ParseTabConsts m_consts{};
+	std::string m_data{};
+	std::size_t m_num_tables{}, m_num_maps{}, m_num_vecs{};
+};
+
+
+/**
+ * read-only view of a memory-mapped binary table file
+ */
+class ParseTableFile
+{
+public:
+	struct Table
+	{
+		std::size_t rows{}, cols{};
+		const std::uint32_t* cells{};
+	};
+
+	struct Words
+	{
+		std::size_t size{};             // number of elements
+		const std::uint64_t* words{};   // one word per vector element, two per map element
+	};
+
+
+public:
+	ParseTableFile(const std::string& file);
+	~ParseTableFile();
+
+	ParseTableFile(const ParseTableFile&) = delete;
+	const ParseTableFile& operator=(const ParseTableFile&) = delete;
+
+	const ParseTabConsts& GetConstants() const { return m_consts; }
+	const Table& GetTable(ParseTab tab) const { return m_tables[static_cast<std::size_t>(tab)]; }
+	const Words& GetMap(ParseTab map) const { return m_maps[static_cast<std::size_t>(map)]; }
+	const Words& GetVector(ParseTab vec) const { return m_vecs[static_cast<std::size_t>(vec)]; }
+
+
+protected:
+	const void* Read(std::size_t size);
+
+
+private:
+	const unsigned char* m_data{};
+	std::size_t m_size{};
+	std::size_t m_pos{};
+
+	ParseTabConsts m_consts{};
+	std::array<Table, PARSETAB_NUM_TABLES> m_tables{};
+	std::array<Words, PARSETAB_NUM_MAPS> m_maps{};
+	std::array<Words, PARSETAB_NUM_VECS> m_vecs{};
+};
+
+
+/**
+ * parse tables decoded from a binary table file into the parser's data types,
+ * they are accessed in the same way as the tables compiled into the parser
+ */
+template<class t_table, class t_vec, class t_map, class t_semanticmap>
+class ParseTables
+{
+public:
+	ParseTables(const std::string& file)
+	{
+		ParseTableFile tabfile{file};
+		m_consts = tabfile.GetConstants();
+
+		m_shift = DecodeTable(tabfile.GetTable(ParseTab::SHIFT));
+		m_reduce = DecodeTable(tabfile.GetTable(ParseTab::REDUCE));
+		m_jump = DecodeTable(tabfile.GetTable(ParseTab::JUMP));
+
+		m_term_idx = DecodeMap<t_map>(tabfile.GetMap(ParseTab::TERM_IDX));
+		m_nonterm_idx = DecodeMap<t_map>(tabfile.GetMap(ParseTab::NONTERM_IDX));
+		m_semantic_idx = DecodeMap<t_semanticmap>(tabfile.GetMap(ParseTab::SEMANTIC_IDX));
+
+		const ParseTableFile::Words& num_rhs = tabfile.GetVector(ParseTab::NUM_RHS);
+		const ParseTableFile::Words& lhs_idx = tabfile.GetVector(ParseTab::LHS_IDX);
+		m_num_rhs = t_vec(num_rhs.words, num_rhs.words + num_rhs.size);
+		m_lhs_idx = t_vec(lhs_idx.words, lhs_idx.words + lhs_idx.size);
+	}
+
+	~ParseTables() = default;
+
+	ParseTables(const ParseTables&) = delete;
+	const ParseTables& operator=(const ParseTables&) = delete;
+
+	auto GetTables() const
+	{
+		return std::make_tuple(&m_shift, &m_reduce, &m_jump, &m_num_rhs, &m_lhs_idx);
+	}
+
+	auto GetTableIndices() const
+	{
+		return std::make_tuple(&m_term_idx, &m_nonterm_idx, &m_semantic_idx);
+	}
+
+	auto GetConstants() const
+	{
+		return std::make_tuple(m_consts.err, m_consts.acc, m_consts.eps_id,
+			m_consts.end_id, m_consts.start_idx, m_consts.acc_rule_idx);
+	}
+
+
+protected:
+	t_table DecodeTable(const ParseTableFile::Table& tabdata) const
+	{
+		t_table tab(tabdata.rows, tabdata.cols, m_consts.err, m_consts.acc);
+
+		const std::uint32_t* cell = tabdata.cells;
+		for(std::size_t row = 0; row < tabdata.rows; ++row)
+		{
+			for(std::size_t col = 0; col < tabdata.cols; ++col, ++cell)
+			{
+				if(*cell == PARSETAB_ERR)
+					tab(row, col) = m_consts.err;
+				else if(*cell == PARSETAB_ACC)
+					tab(row, col) = m_consts.acc;
+				else
+					tab(row, col) = *cell;
+			}
+		}
+
+		return tab;
+	}
+
+	template<class t_anymap>
+	static t_anymap DecodeMap(const ParseTableFile::Words& mapdata)
+	{
+		t_anymap map;
+		map.reserve(mapdata.size);
+
+		for(std::size_t i = 0; i < mapdata.size; ++i)
+			map.emplace(mapdata.words[2*i], mapdata.words[2*i + 1]);
+
+		return map;
+	}
+
+
+private:
+	ParseTabConsts m_consts{};
+	t_table m_shift{}, m_reduce{}, m_jump{};
+	t_map m_term_idx{}, m_nonterm_idx{};
+	t_semanticmap m_semantic_idx{};
+	t_vec m_num_rhs{}, m_lhs_idx{};
+};
+
+
+#endif
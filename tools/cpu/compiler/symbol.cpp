@@ -8,23 +8,57 @@
 #include "symbol.h"
 
 
+SymTab::SymTab()
+{
+	// the name of the global scope
+	GetId("");
+}
+
+
+/**
+ * intern an identifier
+ */
+SymTab::t_id SymTab::GetId(std::string_view name)
+{
+	if(auto iter = m_ids.find(name); iter != m_ids.end())
+		return iter->second;
+
+	t_id id = static_cast<t_id>(m_names.size());
+	const std::string& str = m_names.emplace_back(name);
+	m_ids.emplace(str, id);
+	return id;
+}
+
+
 /**
  * get symbol from the table
  */
-const SymInfo* SymTab::GetSymbol(const std::string& name) const
+const SymInfo* SymTab::GetSymbol(t_id name, t_id scope) const
 {
-	if(auto iter = m_syms.find(name); iter != m_syms.end())
+	if(auto iter = m_syms.find(GetKey(name, scope)); iter != m_syms.end())
 		return &iter->second;
 
 	return nullptr;
 }
 
 
+/**
+ * get symbol from the table without interning its name
+ */
+const SymInfo* SymTab::GetSymbol(std::string_view name, t_id scope) const
+{
+	if(auto iter = m_ids.find(name); iter != m_ids.end())
+		return GetSymbol(iter->second, scope);
+
+	return nullptr;
+}
+
+
 /**
  * add a symbol to the table
  */
-const SymInfo* SymTab::AddSymbol(const std::string& name, t_int addr,
-	t_int loc, VMType ty, bool is_func, t_int num_args)
+const SymInfo* SymTab::AddSymbol(std::string_view name, t_id scope, t_int addr,
+	t_int loc, VMType ty, bool is_func, t_int num_args, t_int num_elems)
 {
 	SymInfo info
 	{
@@ -33,18 +67,10 @@ const SymInfo* SymTab::AddSymbol(const std::string& name, t_int addr,
 		.ty = ty,
 		.is_func = is_func,
 		.num_args = num_args,
+		.num_elems = num_elems,
 	};
 
-	return &m_syms.insert_or_assign(name, info).first->second;
-}
-
-
-/**
- * get the symbol table
- */
-const std::unordered_map<std::string, SymInfo>& SymTab::GetSymbols() const
-{
-	return m_syms;
+	return &m_syms.insert_or_assign(GetKey(GetId(name), scope), info).first->second;
 }
 
 
@@ -67,8 +93,21 @@ std::ostream& operator<<(std::ostream& ostr, const SymTab& symtab)
 		<< std::setw(len_base) << std::left << "Base"
 		<< "\n";
 
-	for(const auto& [name, info] : symtab.GetSymbols())
+	for(const auto& [key, info] : symtab.m_syms)
 	{
+		// function scope and identifier
+		const std::string& scope = symtab.GetName(static_cast<SymTab::t_id>(key >> 32));
+		const std::string& ident = symtab.GetName(static_cast<SymTab::t_id>(key & 0xffffffff));
+
+		std::string name;
+		name.reserve(scope.size() + 1 + ident.size());
+		if(scope != "")
+		{
+			name += scope;
+			name += "/";
+		}
+		name += ident;
+
 		std::string ty = "<unknown>";
 		if(info.is_func)
 		{
@@ -78,6 +117,12 @@ std::ostream& operator<<(std::ostream& ostr, const SymTab& symtab)
 		else
 		{
 			ty = get_vm_type_name(info.ty);
+			if(info.num_elems)
+			{
+				ty += "[";
+				ty += std::to_string(info.num_elems);
+				ty += "]";
+			}
 		}
 
 		std::string basereg = get_vm_base_reg(info.loc);
@@ -9,8 +9,11 @@
 #define __LR1_SYMTAB_H__
 
 #include <unordered_map>
+#include <deque>
+#include <string_view>
 #include <variant>
 #include <memory>
+#include <cstdint>
 #include <ostream>
 #include <sstream>
 #include <iomanip>
@@ -31,32 +34,64 @@ struct SymInfo
 	bool is_func{false};           // function or variable
 
 	t_int num_args{0};             // number of arguments
+	t_int num_elems{0};            // number of array elements, 0 for scalars
 };
 
 
 /**
- * symbol table mapping an identifier to an address
+ * symbol table mapping an identifier to an address,
+ * the identifiers are interned and looked up by their ids in the
+ * global scope (variables and functions) or in a function's scope
  */
 class SymTab
 {
 public:
-	SymTab() = default;
+	// id of an interned identifier
+	using t_id = std::uint32_t;
+
+	// the global scope has the empty name, function scopes have the ids of the function names
+	static constexpr t_id GLOBAL_SCOPE = 0;
+
+
+public:
+	SymTab();
 	~SymTab() = default;
 
-	const SymInfo* GetSymbol(const std::string& name) const;
+	SymTab(const SymTab&) = delete;
+	const SymTab& operator=(const SymTab&) = delete;
+
+	// get the id of an identifier, adding it if it is not yet known
+	t_id GetId(std::string_view name);
+	const std::string& GetName(t_id id) const { return m_names[id]; }
 
-	const SymInfo* AddSymbol(const std::string& name,
+	const SymInfo* GetSymbol(t_id name, t_id scope = GLOBAL_SCOPE) const;
+	const SymInfo* GetSymbol(std::string_view name, t_id scope = GLOBAL_SCOPE) const;
+
+	const SymInfo* AddSymbol(std::string_view name, t_id scope,
 		t_int addr, t_int loc = ADDR_FLAG_BP,
 		VMType ty = VMType::UNKNOWN, bool is_func = false,
-		t_int num_args = 0);
+		t_int num_args = 0, t_int num_elems = 0);
 
-	const std::unordered_map<std::string, SymInfo>& GetSymbols() const;
+	std::size_t NumSymbols() const { return m_syms.size(); }
 
 	friend std::ostream& operator<<(std::ostream& ostr, const SymTab& symtab);
 
 
+protected:
+	// key of an identifier in a scope
+	static std::uint64_t GetKey(t_id name, t_id scope)
+	{
+		return (static_cast<std::uint64_t>(scope) << 32) | name;
+	}
+
+
 private:
-	std::unordered_map<std::string, SymInfo> m_syms{};
+	// interned identifiers, the deque keeps the viewed strings in place
+	std::deque<std::string> m_names{};
+	std::unordered_map<std::string_view, t_id> m_ids{};
+
+	// symbols of all scopes
+	std::unordered_map<std::uint64_t, SymInfo> m_syms{};
 };
 
 
@@ -0,0 +1,128 @@
+/**
+ * immutable code image shared between vm instances
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "codeimage.h"
+#include "opcodes.h"
+
+#include <stdexcept>
+#include <atomic>
+#include <string>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+/**
+ * create an anonymous shared memory object
+ */
+static int create_shm()
+{
+#ifdef __linux__
+	return ::memfd_create("script-vm-code", MFD_CLOEXEC);
+#else
+	static std::atomic<std::size_t> shm_ctr{0};
+
+	std::string name = "/script-vm-code-" + std::to_string(::getpid())
+		+ "-" + std::to_string(shm_ctr++);
+	int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if(fd >= 0)
+		::shm_unlink(name.c_str());
+	return fd;
+#endif
+}
+
+
+CodeImage::CodeImage(const t_byte* code, std::size_t size, t_int addr)
+	: m_addr{addr}, m_size{size}
+{
+	const std::size_t page_size = GetPageSize();
+	if(m_addr < 0 || std::size_t(m_addr) % page_size != 0)
+		throw std::runtime_error("Shared code has to be loaded at a page boundary.");
+
+	m_mapped_size = (m_size + page_size - 1) / page_size * page_size;
+	if(m_mapped_size == 0)
+		m_mapped_size = page_size;
+
+	m_fd = create_shm();
+	if(m_fd < 0)
+		throw std::runtime_error("Cannot create shared code memory.");
+
+	if(::ftruncate(m_fd, static_cast<off_t>(m_mapped_size)) != 0)
+	{
+		::close(m_fd);
+		throw std::runtime_error("Cannot resize shared code memory.");
+	}
+
+	// fill the image with the code, the padding is filled with halt instructions
+	void *mem = ::mmap(nullptr, m_mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	if(mem == MAP_FAILED)
+	{
+		::close(m_fd);
+		throw std::runtime_error("Cannot map shared code memory.");
+	}
+
+	std::memset(mem, static_cast<t_byte>(OpCode::HALT), m_mapped_size);
+	std::memcpy(mem, code, m_size);
+	::munmap(mem, m_mapped_size);
+}
+
+
+CodeImage::~CodeImage()
+{
+	if(m_fd >= 0)
+		::close(m_fd);
+}
+
+
+std::shared_ptr<const CodeImage> CodeImage::Create(
+	const t_byte* code, std::size_t size, t_int addr)
+{
+	return std::make_shared<const CodeImage>(code, size, addr);
+}
+
+
+std::size_t CodeImage::GetPageSize()
+{
+	static const std::size_t page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+	return page_size;
+}
+
+
+/**
+ * allocate page-mapped memory, which is initially zero
+ */
+t_byte* CodeImage::AllocateMemory(std::size_t size)
+{
+	void *mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if(mem == MAP_FAILED)
+		throw std::runtime_error("Cannot allocate vm memory.");
+	return reinterpret_cast<t_byte*>(mem);
+}
+
+
+void CodeImage::FreeMemory(t_byte* mem, std::size_t size)
+{
+	::munmap(mem, size);
+}
+
+
+/**
+ * map the code read-only at the given location,
+ * replacing the pages which were previously mapped there
+ */
+void CodeImage::Map(t_byte* mem) const
+{
+	void *mapped = ::mmap(mem, m_mapped_size, PROT_READ,
+		MAP_SHARED | MAP_FIXED, m_fd, 0);
+
+	if(mapped == MAP_FAILED)
+		throw std::runtime_error("Cannot map shared code into vm memory.");
+}
@@ -0,0 +1,58 @@
+/**
+ * immutable code image shared between vm instances
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#ifndef __LALR1_0ACVM_CODEIMAGE_H__
+#define __LALR1_0ACVM_CODEIMAGE_H__
+
+
+#include <memory>
+#include <cstddef>
+
+#include "types.h"
+
+
+/**
+ * program code held in a shared memory object,
+ * which vm instances map read-only into their address space,
+ * so that all instances use the same physical pages
+ */
+class CodeImage
+{
+public:
+	CodeImage(const t_byte* code, std::size_t size, t_int addr = 0);
+	~CodeImage();
+
+	CodeImage(const CodeImage&) = delete;
+	const CodeImage& operator=(const CodeImage&) = delete;
+
+	static std::shared_ptr<const CodeImage> Create(
+		const t_byte* code, std::size_t size, t_int addr = 0);
+
+	// memory page size
+	static std::size_t GetPageSize();
+
+	// page-mapped memory into which code images can be mapped
+	static t_byte* AllocateMemory(std::size_t size);
+	static void FreeMemory(t_byte* mem, std::size_t size);
+
+	// map the code read-only at the given location
+	void Map(t_byte* mem) const;
+
+	t_int GetAddress() const { return m_addr; }
+	std::size_t GetSize() const { return m_size; }
+	std::size_t GetMappedSize() const { return m_mapped_size; }
+
+
+private:
+	int m_fd{-1};                // shared memory object
+	t_int m_addr{};              // load address of the code
+	std::size_t m_size{};        // code size
+	std::size_t m_mapped_size{}; // code size rounded up to full pages
+};
+
+
+#endif
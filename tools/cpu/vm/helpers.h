@@ -22,15 +22,22 @@ t_val pow(t_val val1, t_val val2)
 	}
 	else if constexpr(std::is_integral_v<t_val>)
 	{
-		if(val2 == 0)
-			return 1;
-		else if(val2 < 0)
+		if(val2 < 0)
 			return 0;
 
-		t_val result = val1;
-		for(t_val i=1; i<val2; ++i)
-			result *= val1;
-		return result;
+		// exponentiation by squaring, wrapping around on overflow
+		using t_uval = std::make_unsigned_t<t_val>;
+		t_uval result = 1;
+		t_uval base = static_cast<t_uval>(val1);
+
+		for(; val2; val2 >>= 1)
+		{
+			if(val2 & 1)
+				result *= base;
+			base *= base;
+		}
+
+		return static_cast<t_val>(result);
 	}
 }
 
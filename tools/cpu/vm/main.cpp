@@ -12,6 +12,9 @@
 #include <optional>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
 
 #if __has_include(<filesystem>)
 	#include <filesystem>
@@ -41,10 +44,207 @@ struct VMOptions
 	bool zero_mem { false };
 	bool enable_memimages { false };
 	bool enable_checks { true };
+
+	std::string memvideo_file { "" };
+	std::size_t memvideo_interval { 1000 };
+
+	std::vector<t_int> breakpoints { };
+	std::string debug_script { "" };
+	bool debug_interactive { false };
 };
 
 
 
+/**
+ * prints the registers and the instruction at the current position
+ */
+static void print_vm_state(const VM& vm)
+{
+	OpCode op = static_cast<OpCode>(vm.GetMem(vm.GetIP()));
+
+	std::cout << "ip = " << vm.GetIP()
+		<< ", sp = " << vm.GetSP()
+		<< ", bp = " << vm.GetBP()
+		<< ", gbp = " << vm.GetGBP()
+		<< ", instruction: " << get_vm_opcode_name(op)
+		<< "." << std::endl;
+}
+
+
+
+/**
+ * command interface for breakpoints and single-stepping
+ * @return false if the vm reports a failure
+ */
+static bool run_debugger(VM& vm, std::istream& istr, bool interactive, t_int sp_initial)
+{
+	// start by reading commands, so that breakpoints can be set before the program runs
+	bool stopped = true;
+
+	while(true)
+	{
+		if(!stopped)
+		{
+			if(!vm.Run())
+				return false;
+			if(!vm.IsBreakpointHit())
+				return true;
+
+			std::cout << "Breakpoint hit: ";
+			print_vm_state(vm);
+		}
+		stopped = false;
+
+		// read commands until the program is continued
+		bool cont = false;
+		while(!cont)
+		{
+			if(interactive)
+				std::cout << "vm> " << std::flush;
+
+			std::string line;
+			if(!std::getline(istr, line))
+			{
+				// no more commands: run the remaining program
+				vm.ClearBreakpoints();
+				break;
+			}
+
+			std::istringstream istrline(line);
+			std::string cmd;
+			if(!(istrline >> cmd) || cmd[0] == '#')
+				continue;
+
+			std::vector<t_int> cmdargs;
+			bool args_ok = true;
+			for(std::string arg; istrline >> arg;)
+			{
+				try
+				{
+					cmdargs.push_back(static_cast<t_int>(std::stol(arg, nullptr, 0)));
+				}
+				catch(const std::logic_error&)
+				{
+					std::cerr << "Invalid argument \"" << arg << "\"." << std::endl;
+					args_ok = false;
+					break;
+				}
+			}
+			if(!args_ok)
+				continue;
+
+			if(cmd == "c" || cmd == "continue")
+			{
+				cont = true;
+			}
+			else if(cmd == "s" || cmd == "step")
+			{
+				t_int num_steps = cmdargs.size() ? cmdargs[0] : 1;
+				for(t_int step = 0; step < num_steps; ++step)
+				{
+					if(!vm.Step())
+						return false;
+					if(vm.IsHalted())
+						return true;
+				}
+
+				print_vm_state(vm);
+			}
+			else if(cmd == "b" || cmd == "break")
+			{
+				for(t_int addr : cmdargs)
+				{
+					try
+					{
+						if(!vm.SetBreakpoint(addr))
+							std::cerr << "Breakpoint at address " << addr << " already exists." << std::endl;
+					}
+					catch(const std::runtime_error& err)
+					{
+						std::cerr << "Cannot set breakpoint at address " << addr
+							<< ": " << err.what() << std::endl;
+					}
+				}
+			}
+			else if(cmd == "d" || cmd == "delete")
+			{
+				for(t_int addr : cmdargs)
+				{
+					if(!vm.RemoveBreakpoint(addr))
+						std::cerr << "No breakpoint at address " << addr << "." << std::endl;
+				}
+			}
+			else if(cmd == "l" || cmd == "list")
+			{
+				for(t_int addr : vm.GetBreakpoints())
+					std::cout << "Breakpoint at address " << addr << "." << std::endl;
+			}
+			else if(cmd == "r" || cmd == "regs")
+			{
+				print_vm_state(vm);
+			}
+			else if(cmd == "p" || cmd == "stack")
+			{
+				t_int num_vals = cmdargs.size() ? cmdargs[0] : 4;
+				for(t_int idx = 0; idx < num_vals; ++idx)
+				{
+					t_int offs = idx * t_int(sizeof(t_int));
+					if(vm.GetSP() + offs >= sp_initial)
+						break;
+
+					std::cout << "Stack[" << idx << "] = "
+						<< vm.TopRaw<t_int>(offs) << std::endl;
+				}
+			}
+			else if(cmd == "m" || cmd == "mem")
+			{
+				if(!cmdargs.size())
+				{
+					std::cerr << "Missing memory address." << std::endl;
+					continue;
+				}
+
+				t_int addr = cmdargs[0];
+				t_int len = cmdargs.size() > 1 ? cmdargs[1] : 16;
+
+				// read the whole range first, so that nothing is printed for invalid addresses
+				std::vector<t_byte> bytes;
+				try
+				{
+					for(t_int idx = 0; idx < len; ++idx)
+						bytes.push_back(vm.GetMem(addr + idx));
+				}
+				catch(const std::runtime_error& err)
+				{
+					std::cerr << "Cannot read memory at address " << addr
+						<< ": " << err.what() << std::endl;
+					continue;
+				}
+
+				std::cout << addr << ":" << std::hex;
+				for(t_byte byte : bytes)
+				{
+					std::cout << " " << std::setw(2) << std::setfill('0')
+						<< static_cast<t_int>(byte);
+				}
+				std::cout << std::dec << std::setfill(' ') << std::endl;
+			}
+			else if(cmd == "q" || cmd == "quit")
+			{
+				return true;
+			}
+			else
+			{
+				std::cerr << "Unknown command \"" << cmd << "\". Available commands:\n"
+					<< "\tc(ontinue), s(tep) [n], b(reak) addr, d(elete) addr, l(ist),\n"
+					<< "\tr(egs), p | stack [n], m(em) addr [n], q(uit)." << std::endl;
+			}
+		}
+	}
+}
+
+
+
 static bool run_vm(const fs::path& prog, const VMOptions& opts)
 {
 	std::size_t filesize = fs::file_size(prog);
@@ -66,10 +266,39 @@ static bool run_vm(const fs::path& prog, const VMOptions& opts)
 	vm.SetChecks(opts.enable_checks);
 	vm.SetZeroPoppedVals(opts.zero_mem);
 	vm.SetDrawMemImages(opts.enable_memimages);
+	if(opts.memvideo_file != "")
+		vm.SetMemVideo(opts.memvideo_file, opts.memvideo_interval);
 	vm.SetMem(opts.load_addr, bytes.data(), filesize, true);
 	vm.SetIP(opts.entry_point);
-	if(!vm.Run())
+
+	for(t_int addr : opts.breakpoints)
+		vm.SetBreakpoint(addr);
+
+	bool ok = true;
+	if(opts.debug_script != "")
+	{
+		std::ifstream ifstr_script(opts.debug_script);
+		if(!ifstr_script)
+		{
+			std::cerr << "Cannot open debugger script \""
+				<< opts.debug_script << "\"." << std::endl;
+			return false;
+		}
+
+		ok = run_debugger(vm, ifstr_script, false, sp_initial);
+	}
+	else if(opts.debug_interactive || opts.breakpoints.size())
+	{
+		ok = run_debugger(vm, std::cin, true, sp_initial);
+	}
+	else
+	{
+		ok = vm.Run();
+	}
+
+	if(!ok)
 		std::cerr << "VM reports failure." << std::endl;
+	vm.CloseMemVideo();
 
 	if(opts.enable_debug)
 	{
@@ -83,6 +312,14 @@ static bool run_vm(const fs::path& prog, const VMOptions& opts)
 		}
 	}
 
+	if(std::size_t memo_calls = vm.GetMemoHits() + vm.GetMemoMisses(); memo_calls)
+	{
+		std::cout << "Memo tables: " << vm.GetMemoHits() << " hits, "
+			<< vm.GetMemoMisses() << " misses, hit rate "
+			<< t_real(vm.GetMemoHits()) / t_real(memo_calls) * t_real(100)
+			<< " %." << std::endl;
+	}
+
 	// print remaining stack
 	std::size_t stack_idx = 0;
 	while(vm.GetSP() < sp_initial)
@@ -121,6 +358,11 @@ int main(int argc, char** argv)
 			.zero_mem = false,
 			.enable_memimages = false,
 			.enable_checks = true,
+			.memvideo_file = "",
+			.memvideo_interval = 1000,
+			.breakpoints = {},
+			.debug_script = "",
+			.debug_interactive = false,
 		};
 
 		typename decltype(vmopts.frame_size)::value_type frame_size = -1;
@@ -130,6 +372,7 @@ int main(int argc, char** argv)
 		// description strings
 		std::ostringstream ostr_mem_size, ostr_load_addr, ostr_entry_point;
 		std::ostringstream ostr_checks, ostr_debug, ostr_zero, ostr_time;
+		std::ostringstream ostr_video_interval;
 		ostr_mem_size << "set memory size (default: " << vmopts.mem_size << ")";
 		ostr_load_addr << "base address to load program (default: " << vmopts.load_addr << ")";
 		ostr_entry_point << "program entry point address (default: " << vmopts.entry_point << ")";
@@ -137,6 +380,7 @@ int main(int argc, char** argv)
 		ostr_debug << "enable debug output (default: " << std::boolalpha << vmopts.enable_debug << ")";
 		ostr_zero << "zero memory after use (default: " << std::boolalpha << vmopts.zero_mem << ")";
 		ostr_time << "time code execution (default: " << std::boolalpha << enable_timer << ")";
+		ostr_video_interval << "instructions per memory video frame (default: " << vmopts.memvideo_interval << ")";
 #ifdef USE_BOOST_GIL
 		std::ostringstream ostr_images;
 		ostr_images << "write memory images (default: " << std::boolalpha << vmopts.enable_memimages << ")";
@@ -150,6 +394,16 @@ int main(int argc, char** argv)
 #ifdef USE_BOOST_GIL
 			("memimages,i", args::bool_switch(&vmopts.enable_memimages), ostr_images.str().c_str())
 #endif
+			("memvideo,v", args::value<decltype(vmopts.memvideo_file)>(&vmopts.memvideo_file),
+				"write a memory video to a y4m file or, if prefixed by '|', to an encoder pipe")
+			("memvideointerval", args::value<decltype(vmopts.memvideo_interval)>(&vmopts.memvideo_interval),
+				ostr_video_interval.str().c_str())
+			("breakpoint,b", args::value<decltype(vmopts.breakpoints)>(&vmopts.breakpoints),
+				"set a breakpoint at the given instruction address and start the debugger")
+			("debugger,g", args::bool_switch(&vmopts.debug_interactive),
+				"start the interactive debugger")
+			("debugscript,s", args::value<decltype(vmopts.debug_script)>(&vmopts.debug_script),
+				"run the debugger commands from the given file")
 			("checks,c", args::value<bool>(&vmopts.enable_checks), ostr_checks.str().c_str())
 			("mem,m", args::value<decltype(vmopts.mem_size)>(&vmopts.mem_size), ostr_mem_size.str().c_str())
 			("frame,f", args::value<decltype(frame_size)>(&frame_size), "set stack frame size")
@@ -221,6 +475,13 @@ int main(int argc, char** argv)
 				<< "\"ffmpeg -i mem_%d.png mem.mp4\""
 				<< "." << std::endl;
 		}
+
+		if(vmopts.memvideo_file != "" && vmopts.memvideo_file[0] != '|')
+		{
+			std::cout << "Convert memory video using: "
+				<< "\"ffmpeg -i " << vmopts.memvideo_file << " mem.mp4\""
+				<< "." << std::endl;
+		}
 	}
 	catch(const std::exception& err)
 	{
@@ -0,0 +1,121 @@
+/**
+ * streaming memory visualisation video
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "memvideo.h"
+
+#include <stdexcept>
+
+
+MemVideo::MemVideo(const std::string& file, std::size_t width, std::size_t height,
+	std::size_t fps, std::size_t max_queued)
+	: m_width{width}, m_height{height}, m_max_queued{max_queued}
+{
+	if(file.size() && file[0] == '|')
+	{
+		// pipe into an external encoder
+		m_file = ::popen(file.c_str() + 1, "w");
+		m_is_pipe = true;
+	}
+	else
+	{
+		m_file = std::fopen(file.c_str(), "wb");
+	}
+
+	if(!m_file)
+		throw std::runtime_error("Cannot open memory video stream \"" + file + "\".");
+
+	// y4m stream header, see: https://wiki.multimedia.cx/index.php/YUV4MPEG2
+	std::fprintf(m_file, "YUV4MPEG2 W%zu H%zu F%zu:1 Ip A1:1 C444\n",
+		m_width, m_height, fps);
+
+	m_thread = std::thread(&MemVideo::WriterFunc, this);
+}
+
+
+MemVideo::~MemVideo()
+{
+	Close();
+}
+
+
+/**
+ * queue a frame consisting of the y, u, and v planes
+ */
+void MemVideo::PushFrame(const t_frame& frame)
+{
+	std::unique_lock<std::mutex> lock{m_mtx};
+
+	// only block the vm if the writer falls too far behind
+	m_cond_pop.wait(lock, [this]() -> bool
+	{
+		return m_queue.size() < m_max_queued || m_stop;
+	});
+
+	if(m_stop)
+		return;
+
+	m_queue.push_back(frame);
+	lock.unlock();
+	m_cond_push.notify_one();
+}
+
+
+/**
+ * function for writer thread
+ */
+void MemVideo::WriterFunc()
+{
+	while(true)
+	{
+		t_frame frame;
+
+		{
+			std::unique_lock<std::mutex> lock{m_mtx};
+			m_cond_push.wait(lock, [this]() -> bool
+			{
+				return m_queue.size() || m_stop;
+			});
+
+			if(!m_queue.size())
+				break;  // stopped and nothing left to write
+
+			frame = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+		m_cond_pop.notify_one();
+
+		std::fputs("FRAME\n", m_file);
+		std::fwrite(frame.data(), sizeof(std::uint8_t), frame.size(), m_file);
+		++m_frames_written;
+	}
+}
+
+
+/**
+ * write all remaining frames and close the stream
+ */
+void MemVideo::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock{m_mtx};
+		m_stop = true;
+	}
+	m_cond_push.notify_all();
+	m_cond_pop.notify_all();
+
+	if(m_thread.joinable())
+		m_thread.join();
+
+	if(m_file)
+	{
+		if(m_is_pipe)
+			::pclose(m_file);
+		else
+			std::fclose(m_file);
+		m_file = nullptr;
+	}
+}
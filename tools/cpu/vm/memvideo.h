@@ -0,0 +1,78 @@
+/**
+ * streaming memory visualisation video
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#ifndef __LALR1_0ACVM_MEMVIDEO_H__
+#define __LALR1_0ACVM_MEMVIDEO_H__
+
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+
+
+/**
+ * writes raw yuv 4:4:4 frames into a y4m stream
+ * on a background thread
+ *
+ * if the file name starts with '|', the remaining string
+ * is run as an encoder command reading the y4m stream from its stdin,
+ * e.g. "|ffmpeg -y -i - mem.mp4"
+ */
+class MemVideo
+{
+public:
+	using t_frame = std::vector<std::uint8_t>;
+
+
+public:
+	MemVideo(const std::string& file, std::size_t width, std::size_t height,
+		std::size_t fps = 25, std::size_t max_queued = 16);
+	~MemVideo();
+
+	MemVideo(const MemVideo&) = delete;
+	const MemVideo& operator=(const MemVideo&) = delete;
+
+	bool IsOpen() const { return m_file != nullptr; }
+
+	std::size_t GetWidth() const { return m_width; }
+	std::size_t GetHeight() const { return m_height; }
+	std::size_t GetNumFramesWritten() const { return m_frames_written; }
+
+	// queue a frame consisting of the y, u, and v planes
+	void PushFrame(const t_frame& frame);
+
+	// write all remaining frames and close the stream
+	void Close();
+
+
+protected:
+	void WriterFunc();
+
+
+private:
+	std::FILE *m_file{nullptr};
+	bool m_is_pipe{false};
+
+	std::size_t m_width{}, m_height{};
+	std::size_t m_max_queued{16};      // maximum number of frames waiting to be written
+	std::size_t m_frames_written{};
+
+	std::deque<t_frame> m_queue{};     // frames waiting to be written
+	std::mutex m_mtx{};
+	std::condition_variable m_cond_push{}, m_cond_pop{};
+	bool m_stop{false};
+
+	std::thread m_thread{};
+};
+
+
+#endif
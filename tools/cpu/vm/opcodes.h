@@ -11,11 +11,19 @@
 #include "types.h"
 
 
+// signed immediate offset of the memory operations relative to the base pointers
+using t_offs = std::int16_t;
+
+// size of an entry in a memo table: key, cached result, and valid flag
+constexpr t_int MEMO_ENTRY_SIZE = 3 * sizeof(t_int);
+
+
 enum class OpCode : t_byte
 {
 	HALT     = 0x00,  // stop program
 	NOP      = 0x01,  // no operation
 	INVALID  = 0x02,  // invalid opcode
+	BREAK    = 0x03,  // breakpoint, reserved for the debugger
 
 	// conversions
 	FTOI     = 0x0a,  // cast real to int
@@ -25,9 +33,11 @@ enum class OpCode : t_byte
 	PUSH     = 0x10,  // push direct integer data
 	WRMEM    = 0x11,  // write integer data to memory
 	RDMEM    = 0x12,  // read integer data from memory
+	DUP      = 0x13,  // duplicate the integer on top of the stack
 	PUSH_R   = 0x1a,  // push direct real data
 	WRMEM_R  = 0x1b,  // write real data to memory
 	RDMEM_R  = 0x1c,  // read read data from memory
+	DUP_R    = 0x1d,  // duplicate the real on top of the stack
 
 	// arithmetic integer operations
 	USUB     = 0x20,  // unary -
@@ -82,9 +92,40 @@ enum class OpCode : t_byte
 	// jumps and function calls
 	JMP      = 0x60,  // unconditional jump to direct address
 	JMPCND   = 0x61,  // conditional jump to direct address
+	JMP_S    = 0x62,  // unconditional jump by a signed byte offset
+	JMPCND_S = 0x63,  // conditional jump by a signed byte offset
+	JMPNCND  = 0x64,  // jump to direct address if the condition is false
+	JMPNCND_S = 0x65, // jump by a signed byte offset if the condition is false
 	CALL     = 0x6a,  // call function
 	RET      = 0x6b,  // return from function
 	ICALL    = 0x6c,  // call software interrupt
+
+	// memory operations relative to the base pointers, followed by an offset
+	RDBP     = 0x70,  // read integer data relative to the local base pointer
+	WRBP     = 0x71,  // write integer data relative to the local base pointer
+	RDGBP    = 0x72,  // read integer data relative to the global base pointer
+	WRGBP    = 0x73,  // write integer data relative to the global base pointer
+	RDBP_R   = 0x7a,  // read real data relative to the local base pointer
+	WRBP_R   = 0x7b,  // write real data relative to the local base pointer
+	RDGBP_R  = 0x7c,  // read real data relative to the global base pointer
+	WRGBP_R  = 0x7d,  // write real data relative to the global base pointer
+
+	// array operations, followed by the offset of the array to a base pointer,
+	// the element index is popped from the stack
+	RDBPIDX  = 0x80,  // read an integer array element relative to the local base pointer
+	WRBPIDX  = 0x81,  // write an integer array element relative to the local base pointer
+	RDGBPIDX = 0x82,  // read an integer array element relative to the global base pointer
+	WRGBPIDX = 0x83,  // write an integer array element relative to the global base pointer
+	CHKIDX   = 0x84,  // check the index on the stack against the following number of elements
+	RDBPIDX_R  = 0x8a,  // read a real array element relative to the local base pointer
+	WRBPIDX_R  = 0x8b,  // write a real array element relative to the local base pointer
+	RDGBPIDX_R = 0x8c,  // read a real array element relative to the global base pointer
+	WRGBPIDX_R = 0x8d,  // write a real array element relative to the global base pointer
+
+	// memoisation, followed by the offset of the memo table to the heap pointer
+	// and its number of entries, the key is popped from the stack
+	MEMOGET  = 0x90,  // push the cached result and true if it is known, else false
+	MEMOSET  = 0x91,  // cache the function result on top of the stack
 };
 
 
@@ -105,6 +146,42 @@ static OpCode convert_vm_opcode_int_to_real(OpCode op)
 }
 
 
+/**
+ * get the size of the immediate data following an opcode
+ */
+constexpr std::size_t get_vm_opcode_data_size(OpCode op)
+{
+	switch(op)
+	{
+		case OpCode::PUSH:      return sizeof(t_int);
+		case OpCode::PUSH_R:    return sizeof(t_real);
+		case OpCode::JMP_S:     return sizeof(t_byte);
+		case OpCode::JMPCND_S:  return sizeof(t_byte);
+		case OpCode::JMPNCND_S: return sizeof(t_byte);
+		case OpCode::RDBP:      return sizeof(t_offs);
+		case OpCode::WRBP:      return sizeof(t_offs);
+		case OpCode::RDGBP:     return sizeof(t_offs);
+		case OpCode::WRGBP:     return sizeof(t_offs);
+		case OpCode::RDBP_R:    return sizeof(t_offs);
+		case OpCode::WRBP_R:    return sizeof(t_offs);
+		case OpCode::RDGBP_R:   return sizeof(t_offs);
+		case OpCode::WRGBP_R:   return sizeof(t_offs);
+		case OpCode::RDBPIDX:   return sizeof(t_offs);
+		case OpCode::WRBPIDX:   return sizeof(t_offs);
+		case OpCode::RDGBPIDX:  return sizeof(t_offs);
+		case OpCode::WRGBPIDX:  return sizeof(t_offs);
+		case OpCode::CHKIDX:    return sizeof(t_int);
+		case OpCode::RDBPIDX_R: return sizeof(t_offs);
+		case OpCode::WRBPIDX_R: return sizeof(t_offs);
+		case OpCode::RDGBPIDX_R: return sizeof(t_offs);
+		case OpCode::WRGBPIDX_R: return sizeof(t_offs);
+		case OpCode::MEMOGET:   return 2*sizeof(t_int);
+		case OpCode::MEMOSET:   return 2*sizeof(t_int);
+		default:                return 0;
+	}
+}
+
+
 /**
  * get a string representation of an opcode
  */
@@ -116,6 +193,7 @@ constexpr t_str get_vm_opcode_name(OpCode op)
 		case OpCode::HALT:      return "halt";
 		case OpCode::NOP:       return "nop";
 		case OpCode::INVALID:   return "invalid";
+		case OpCode::BREAK:     return "break";
 
 		case OpCode::FTOI:      return "ftoi";
 		case OpCode::ITOF:      return "itof";
@@ -123,9 +201,11 @@ constexpr t_str get_vm_opcode_name(OpCode op)
 		case OpCode::PUSH:      return "push";
 		case OpCode::WRMEM:     return "wrmem";
 		case OpCode::RDMEM:     return "rdmem";
+		case OpCode::DUP:       return "dup";
 		case OpCode::PUSH_R:    return "push_r";
 		case OpCode::WRMEM_R:   return "wrmem_r";
 		case OpCode::RDMEM_R:   return "rdmem_r";
+		case OpCode::DUP_R:     return "dup_r";
 
 		case OpCode::USUB:      return "usub";
 		case OpCode::ADD:       return "add";
@@ -173,10 +253,36 @@ constexpr t_str get_vm_opcode_name(OpCode op)
 
 		case OpCode::JMP:       return "jmp";
 		case OpCode::JMPCND:    return "jmpcnd";
+		case OpCode::JMP_S:     return "jmp_s";
+		case OpCode::JMPCND_S:  return "jmpcnd_s";
+		case OpCode::JMPNCND:   return "jmpncnd";
+		case OpCode::JMPNCND_S: return "jmpncnd_s";
 		case OpCode::CALL:      return "call";
 		case OpCode::RET:       return "ret";
 		case OpCode::ICALL:     return "icall";
 
+		case OpCode::RDBP:      return "rdbp";
+		case OpCode::WRBP:      return "wrbp";
+		case OpCode::RDGBP:     return "rdgbp";
+		case OpCode::WRGBP:     return "wrgbp";
+		case OpCode::RDBP_R:    return "rdbp_r";
+		case OpCode::WRBP_R:    return "wrbp_r";
+		case OpCode::RDGBP_R:   return "rdgbp_r";
+		case OpCode::WRGBP_R:   return "wrgbp_r";
+
+		case OpCode::RDBPIDX:   return "rdbpidx";
+		case OpCode::WRBPIDX:   return "wrbpidx";
+		case OpCode::RDGBPIDX:  return "rdgbpidx";
+		case OpCode::WRGBPIDX:  return "wrgbpidx";
+		case OpCode::CHKIDX:    return "chkidx";
+		case OpCode::RDBPIDX_R: return "rdbpidx_r";
+		case OpCode::WRBPIDX_R: return "wrbpidx_r";
+		case OpCode::RDGBPIDX_R: return "rdgbpidx_r";
+		case OpCode::WRGBPIDX_R: return "wrgbpidx_r";
+
+		case OpCode::MEMOGET:   return "memoget";
+		case OpCode::MEMOSET:   return "memoset";
+
 		default:                return "<unknown>";
 	}
 }
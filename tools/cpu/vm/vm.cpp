@@ -21,6 +21,7 @@ VM::VM(t_int memsize, std::optional<t_int> framesize, std::optional<t_int> heaps
 VM::~VM()
 {
 	StopTimer();
+	StopRecording();
 }
 
 
@@ -60,6 +61,10 @@ void VM::TimerFunc()
  */
 void VM::RequestInterrupt(t_int num)
 {
+	// interrupts are injected from the log when replaying
+	if(m_replaying)
+		return;
+
 	m_irqs[num] = true;
 }
 
@@ -76,7 +81,12 @@ void VM::SetISR(t_int num, t_int addr)
 }
 
 
-bool VM::Run()
+/**
+ * runs the program until it halts or hits a breakpoint,
+ * or, in single-step mode, for one instruction
+ */
+template<bool single_step>
+bool VM::Execute()
 {
 	bool running = true;
 
@@ -85,10 +95,15 @@ bool VM::Run()
 		CheckPointerBounds();
 		if(m_drawmemimages)
 			DrawMemoryImage();
+		if(m_memvideo && m_num_ops_run % m_memvideo_interval == 0)
+			DrawMemoryVideoFrame();
 
 		OpCode op{OpCode::INVALID};
 		bool irq_active = false;
 
+		if(m_replaying)
+			ReplayInterrupts();
+
 		// tests for interrupt requests
 		for(t_int irq=0; irq<m_num_interrupts; ++irq)
 		{
@@ -100,6 +115,8 @@ bool VM::Run()
 				continue;
 
 			irq_active = true;
+			if(m_recording)
+				RecordEvent(ReplayEventType::INTERRUPT, irq);
 
 			// call interrupt service routine
 			PushAddress(*m_isrs[irq], ADDR_FLAG_MEM);
@@ -144,6 +161,7 @@ bool VM::Run()
 		{
 			case OpCode::HALT:
 			{
+				m_halted = true;
 				running = false;
 				break;
 			}
@@ -153,6 +171,19 @@ bool VM::Run()
 				break;
 			}
 
+			case OpCode::BREAK:
+			{
+				// stop in front of the patched instruction,
+				// breaks which are part of the program are skipped
+				if(m_breakpoints.contains(m_ip - 1))
+					--m_ip;
+				--m_num_ops_run;
+
+				m_break_hit = true;
+				running = false;
+				break;
+			}
+
 			case OpCode::FTOI: // converts t_real value to t_int
 			{
 				t_real data = PopRaw<t_real>();
@@ -193,6 +224,22 @@ bool VM::Run()
 				break;
 			}
 
+			case OpCode::DUP:
+			{
+				t_int val = PopRaw<t_int>();
+				PushRaw<t_int>(val);
+				PushRaw<t_int>(val);
+				break;
+			}
+
+			case OpCode::DUP_R:
+			{
+				t_real val = PopRaw<t_real>();
+				PushRaw<t_real>(val);
+				PushRaw<t_real>(val);
+				break;
+			}
+
 			case OpCode::WRMEM:
 			{
 				// variable address
@@ -237,6 +284,157 @@ bool VM::Run()
 				break;
 			}
 
+			// variables relative to the base pointers
+			case OpCode::RDBP:
+			{
+				OpReadRelative<t_int>(m_bp);
+				break;
+			}
+
+			case OpCode::WRBP:
+			{
+				OpWriteRelative<t_int>(m_bp);
+				break;
+			}
+
+			case OpCode::RDGBP:
+			{
+				OpReadRelative<t_int>(m_gbp);
+				break;
+			}
+
+			case OpCode::WRGBP:
+			{
+				OpWriteRelative<t_int>(m_gbp);
+				break;
+			}
+
+			case OpCode::RDBP_R:
+			{
+				OpReadRelative<t_real>(m_bp);
+				break;
+			}
+
+			case OpCode::WRBP_R:
+			{
+				OpWriteRelative<t_real>(m_bp);
+				break;
+			}
+
+			case OpCode::RDGBP_R:
+			{
+				OpReadRelative<t_real>(m_gbp);
+				break;
+			}
+
+			case OpCode::WRGBP_R:
+			{
+				OpWriteRelative<t_real>(m_gbp);
+				break;
+			}
+
+			// array elements relative to the base pointers
+			case OpCode::RDBPIDX:
+			{
+				OpReadIndexed<t_int>(m_bp);
+				break;
+			}
+
+			case OpCode::WRBPIDX:
+			{
+				OpWriteIndexed<t_int>(m_bp);
+				break;
+			}
+
+			case OpCode::RDGBPIDX:
+			{
+				OpReadIndexed<t_int>(m_gbp);
+				break;
+			}
+
+			case OpCode::WRGBPIDX:
+			{
+				OpWriteIndexed<t_int>(m_gbp);
+				break;
+			}
+
+			case OpCode::RDBPIDX_R:
+			{
+				OpReadIndexed<t_real>(m_bp);
+				break;
+			}
+
+			case OpCode::WRBPIDX_R:
+			{
+				OpWriteIndexed<t_real>(m_bp);
+				break;
+			}
+
+			case OpCode::RDGBPIDX_R:
+			{
+				OpReadIndexed<t_real>(m_gbp);
+				break;
+			}
+
+			case OpCode::WRGBPIDX_R:
+			{
+				OpWriteIndexed<t_real>(m_gbp);
+				break;
+			}
+
+			case OpCode::CHKIDX:
+			{
+				// number of array elements
+				t_int num_elems = ReadMemRaw<t_int>(m_ip);
+				m_ip += sizeof(t_int);
+
+				t_int idx = TopRaw<t_int>();
+				if(idx < 0 || idx >= num_elems)
+				{
+					std::ostringstream msg;
+					msg << "Array index " << idx << " is out of bounds [0, "
+						<< num_elems << ").";
+					throw std::runtime_error(msg.str());
+				}
+				break;
+			}
+
+			// memoised function results in the heap
+			case OpCode::MEMOGET:
+			{
+				t_int key{};
+				t_int addr = PopMemoEntry(key);
+
+				if(ReadMemRaw<t_int>(addr + 2*sizeof(t_int))
+					&& ReadMemRaw<t_int>(addr) == key)
+				{
+					++m_memo_hits;
+					PushRaw<t_int>(ReadMemRaw<t_int>(addr + sizeof(t_int)));
+					PushRaw<t_bool>(1);
+				}
+				else
+				{
+					++m_memo_misses;
+					PushRaw<t_bool>(0);
+				}
+				break;
+			}
+
+			case OpCode::MEMOSET:
+			{
+				t_int key{};
+				t_int addr = PopMemoEntry(key);
+
+				// only cache returned values, like in RET
+				if(m_sp + m_framesize < m_bp)
+				{
+					WriteMemRaw<t_int>(addr, key);
+					WriteMemRaw<t_int>(addr + sizeof(t_int), TopRaw<t_int>());
+					WriteMemRaw<t_int>(addr + 2*sizeof(t_int), 1);
+				}
+				break;
+			}
+
 			// ----------------------------------------------------
 			// integer operations
 			// ----------------------------------------------------
@@ -499,6 +697,48 @@ bool VM::Run()
 				break;
 			}
 
+			case OpCode::JMPNCND: // jump to direct address if the condition is false
+			{
+				t_int addr = PopAddress();
+				t_bool cond = PopRaw<t_bool>();
+
+				if(!cond)
+					m_ip = addr;
+				break;
+			}
+
+			case OpCode::JMP_S: // jump by a byte offset relative to the next instruction
+			{
+				t_int offs = static_cast<std::int8_t>(ReadMemRaw<t_byte>(m_ip));
+				m_ip += 1 + offs;
+				break;
+			}
+
+			case OpCode::JMPCND_S: // conditional jump by a byte offset
+			{
+				t_int offs = static_cast<std::int8_t>(ReadMemRaw<t_byte>(m_ip));
+				m_ip += 1;
+
+				// get boolean condition result from stack
+				t_bool cond = PopRaw<t_bool>();
+
+				if(cond)
+					m_ip += offs;
+				break;
+			}
+
+			case OpCode::JMPNCND_S: // jump by a byte offset if the condition is false
+			{
+				t_int offs = static_cast<std::int8_t>(ReadMemRaw<t_byte>(m_ip));
+				m_ip += 1;
+
+				t_bool cond = PopRaw<t_bool>();
+
+				if(!cond)
+					m_ip += offs;
+				break;
+			}
+
 			/**
 			 * stack frame for functions:
 			 *
@@ -572,7 +812,10 @@ bool VM::Run()
 
 				// zero the stack frame
 				if(m_zeropoppedvals)
+				{
 					std::memset(m_mem.get()+m_sp, 0, (m_bp-m_sp)*sizeof(t_byte));
+					MarkDirty(m_sp, m_bp-m_sp);
+				}
 
 				// remove the function's stack frame
 				m_sp = m_bp;
@@ -613,12 +856,170 @@ bool VM::Run()
 		// wrap around
 		if(m_ip > m_memsize)
 			m_ip %= m_memsize;
+
+		if constexpr(single_step)
+			running = false;
 	}
 
 	return true;
 }
 
 
+/**
+ * runs the program until it halts or hits a breakpoint
+ */
+bool VM::Run()
+{
+	bool resume = m_suspended;
+	m_halted = m_break_hit = m_suspended = false;
+
+	// continue from a breakpoint
+	if(resume && m_breakpoints.size() && m_breakpoints.contains(m_ip))
+	{
+		if(!StepOverBreakpoint())
+			return false;
+	}
+
+	bool ok = true;
+	if(!m_halted)
+		ok = Execute<false>();
+	m_suspended = m_break_hit;
+
+	// show the final memory state
+	if(m_memvideo)
+		DrawMemoryVideoFrame();
+
+	return ok;
+}
+
+
+/**
+ * runs a single instruction
+ */
+bool VM::Step()
+{
+	m_halted = m_break_hit = false;
+	m_suspended = true;
+
+	if(m_breakpoints.size() && m_breakpoints.contains(m_ip))
+		return StepOverBreakpoint();
+
+	return Execute<true>();
+}
+
+
+/**
+ * runs the original instruction at the current breakpoint address
+ */
+bool VM::StepOverBreakpoint()
+{
+	const t_int addr = m_ip;
+
+	// temporarily restore the original instruction
+	m_mem[addr] = m_breakpoints[addr];
+
+	bool ok = false;
+	try
+	{
+		ok = Execute<true>();
+	}
+	catch(...)
+	{
+		m_mem[addr] = static_cast<t_byte>(OpCode::BREAK);
+		throw;
+	}
+
+	m_mem[addr] = static_cast<t_byte>(OpCode::BREAK);
+	return ok;
+}
+
+
+/**
+ * sets a breakpoint by patching a break instruction into the code
+ */
+bool VM::SetBreakpoint(t_int addr)
+{
+	CheckMemoryBounds(addr, sizeof(t_byte));
+	CheckCodeWrite(addr);
+	if(m_breakpoints.contains(addr))
+		return false;
+
+	m_breakpoints.emplace(std::make_pair(addr, m_mem[addr]));
+	m_mem[addr] = static_cast<t_byte>(OpCode::BREAK);
+	return true;
+}
+
+
+/**
+ * removes a breakpoint and restores the original instruction
+ */
+bool VM::RemoveBreakpoint(t_int addr)
+{
+	auto iter = m_breakpoints.find(addr);
+	if(iter == m_breakpoints.end())
+		return false;
+
+	m_mem[addr] = iter->second;
+	m_breakpoints.erase(iter);
+	return true;
+}
+
+
+/**
+ * memory at breakpoints has been overwritten:
+ * save the new bytes as the original instructions and restore the break instructions
+ */
+void VM::UpdateBreakpoints(t_int addr, std::size_t size)
+{
+	for(t_int bp_addr = addr; bp_addr < addr + t_int(size); ++bp_addr)
+	{
+		auto iter = m_breakpoints.find(bp_addr);
+		if(iter == m_breakpoints.end())
+			continue;
+
+		iter->second = m_mem[bp_addr];
+		m_mem[bp_addr] = static_cast<t_byte>(OpCode::BREAK);
+	}
+}
+
+
+void VM::ClearBreakpoints()
+{
+	for(const auto& [addr, op] : m_breakpoints)
+		m_mem[addr] = op;
+	m_breakpoints.clear();
+}
+
+
+/**
+ * get the addresses of all breakpoints
+ */
+std::vector<t_int> VM::GetBreakpoints() const
+{
+	std::vector<t_int> addrs;
+	addrs.reserve(m_breakpoints.size());
+
+	for(const auto& [addr, op] : m_breakpoints)
+		addrs.push_back(addr);
+
+	std::sort(addrs.begin(), addrs.end());
+	return addrs;
+}
+
+
+/**
+ * get a memory byte, showing the original instructions at breakpoints
+ */
+t_byte VM::GetMem(t_int addr) const
+{
+	CheckMemoryBounds(addr, sizeof(t_byte));
+
+	if(auto iter = m_breakpoints.find(addr); iter != m_breakpoints.end())
+		return iter->second;
+	return m_mem[addr];
+}
+
+
 /**
  * pop an address from the stack
  * an address consists of the index of an register
@@ -672,11 +1073,29 @@ void VM::Reset()
 	m_gbp = m_bp;
 	m_hp = m_memsize - m_heapsize;
 
-	std::memset(m_mem.get(), static_cast<t_byte>(OpCode::HALT), m_memsize*sizeof(t_byte));
-	m_code_range[0] = m_code_range[1] = -1;
+	if(m_shared_code)
+	{
+		// only reset the private memory, the shared code stays mapped
+		std::memset(m_mem.get(), static_cast<t_byte>(OpCode::HALT),
+			m_shared_code_range[0]*sizeof(t_byte));
+		std::memset(m_mem.get() + m_shared_code_range[1], static_cast<t_byte>(OpCode::HALT),
+			(m_memsize - m_shared_code_range[1])*sizeof(t_byte));
+
+		m_code_range[0] = m_shared_code->GetAddress();
+		m_code_range[1] = m_code_range[0] + t_int(m_shared_code->GetSize());
+	}
+	else
+	{
+		std::memset(m_mem.get(), static_cast<t_byte>(OpCode::HALT), m_memsize*sizeof(t_byte));
+		m_code_range[0] = m_code_range[1] = -1;
+	}
+	MarkDirty(0, m_memsize);
+	m_breakpoints.clear();
+	m_halted = m_break_hit = m_suspended = false;
 
 	m_num_ops_run = 0;
 	m_ops_run.clear();
+	m_memo_hits = m_memo_misses = 0;
 }
 
 
@@ -700,11 +1119,49 @@ void VM::UpdateCodeRange(t_int begin, t_int end)
 }
 
 
+/**
+ * uses a code image shared with other vm instances,
+ * the vm memory is reset and the code pages are mapped read-only into it
+ */
+void VM::SetSharedCode(const std::shared_ptr<const CodeImage>& code)
+{
+	const std::size_t page_size = CodeImage::GetPageSize();
+	const std::size_t mapped_memsize = (m_memsize + page_size - 1) / page_size * page_size;
+
+	const t_int code_begin = code->GetAddress();
+	const t_int code_end = code_begin + t_int(code->GetMappedSize());
+	if(code_end > m_memsize - m_framesize - m_heapsize)
+		throw std::runtime_error("Memory is too small for the shared code.");
+
+	m_mem = std::unique_ptr<t_byte[], MemDeleter>{
+		CodeImage::AllocateMemory(mapped_memsize), MemDeleter{mapped_memsize}};
+
+	m_shared_code = code;
+	m_shared_code_range[0] = code_begin;
+	m_shared_code_range[1] = code_end;
+
+	Reset();
+	m_shared_code->Map(m_mem.get() + code_begin);
+}
+
+
 void VM::SetMem(t_int addr, t_byte data)
 {
 	CheckMemoryBounds(addr, sizeof(t_byte));
+	CheckCodeWrite(addr % m_memsize);
+
+	// keep the break instruction if the breakpoint's code is overwritten
+	if(m_breakpoints.size())
+	{
+		if(auto iter = m_breakpoints.find(addr % m_memsize); iter != m_breakpoints.end())
+		{
+			iter->second = data;
+			return;
+		}
+	}
 
 	m_mem[addr % m_memsize] = data;
+	MarkDirty(addr % m_memsize);
 }
 
 
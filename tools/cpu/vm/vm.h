@@ -12,6 +12,8 @@
 #include <type_traits>
 #include <memory>
 #include <array>
+#include <vector>
+#include <algorithm>
 #include <unordered_map>
 #include <optional>
 #include <iostream>
@@ -21,11 +23,16 @@
 #include <chrono>
 #include <atomic>
 #include <string>
+#include <fstream>
 #include <cstring>
 #include <cmath>
+#include <limits>
+#include <stdexcept>
 
 #include "opcodes.h"
 #include "helpers.h"
+#include "memvideo.h"
+#include "codeimage.h"
 
 
 class VM
@@ -34,6 +41,20 @@ public:
 	static constexpr const t_int m_num_interrupts = 16;
 	static constexpr const t_int m_timer_interrupt = 0;
 
+	// events in the record and replay log
+	enum class ReplayEventType : t_byte
+	{
+		INTERRUPT = 0x00,  // interrupt taken
+		INPUT     = 0x01,  // external input value
+	};
+
+	struct ReplayEvent
+	{
+		std::size_t op_count{};    // instruction count at which the event occurred
+		ReplayEventType type{ReplayEventType::INTERRUPT};
+		t_int value{};             // interrupt number or input value
+	};
+
 
 public:
 	VM(t_int memsize = 0x1000, std::optional<t_int> framesize = std::nullopt,
@@ -42,19 +63,36 @@ public:
 
 	void SetDebug(bool b) { m_debug = b; }
 	void SetDrawMemImages(bool b) { m_drawmemimages = b; }
+	void SetMemVideo(const std::string& file, std::size_t interval = 1000, std::size_t fps = 25);
+	void CloseMemVideo();
 	void SetChecks(bool b) { m_checks = b; }
 	void SetZeroPoppedVals(bool b) { m_zeropoppedvals = b; }
 
 	void Reset();
 	bool Run();
+	bool Step();
+
+	bool IsHalted() const { return m_halted; }
+	bool IsBreakpointHit() const { return m_break_hit; }
+
+	bool SetBreakpoint(t_int addr);
+	bool RemoveBreakpoint(t_int addr);
+	void ClearBreakpoints();
+	std::vector<t_int> GetBreakpoints() const;
 
 	std::size_t GetNumOpsRun() const { return m_num_ops_run; }
 	std::unordered_map<OpCode, std::size_t> GetOpsRun() const { return m_ops_run; }
+	std::size_t GetMemoHits() const { return m_memo_hits; }
+	std::size_t GetMemoMisses() const { return m_memo_misses; }
 
 
 	void SetMem(t_int addr, t_byte data);
 	void SetMem(t_int addr, const t_byte* data, std::size_t size, bool is_code = false);
 	void SetMem(t_int addr, const std::string& data, bool is_code = false);
+	t_byte GetMem(t_int addr) const;
+
+	void SetSharedCode(const std::shared_ptr<const CodeImage>& code);
+	const std::shared_ptr<const CodeImage>& GetSharedCode() const { return m_shared_code; }
 
 	t_int GetSP() const { return m_sp; }
 	t_int GetBP() const { return m_bp; }
@@ -73,12 +111,28 @@ public:
 	void RequestInterrupt(t_int num);
 
 
+	/**
+	 * deterministic record and replay of interrupts and inputs
+	 */
+	void StartRecording(const std::string& file);
+	void StopRecording();
+	void StartReplay(const std::string& file);
+	void StopReplay();
+	t_int RecordInput(t_int value);
+
+
 	/**
 	 * visualises vm memory utilisation
 	 */
 	void DrawMemoryImage();
 
 
+	/**
+	 * renders the changed memory regions into the next video frame
+	 */
+	void DrawMemoryVideoFrame();
+
+
 	/**
 	 * get the value on top of the stack
 	 */
@@ -104,7 +158,10 @@ public:
 		t_val val = *valptr;
 
 		if(m_zeropoppedvals)
+		{
 			*valptr = 0;
+			MarkDirty(m_sp, valsize);
+		}
 
 		m_sp += valsize;	// stack grows to lower addresses
 		return val;
@@ -150,7 +207,13 @@ protected:
 	void WriteMemRaw(t_int addr, const t_val& val)
 	{
 		CheckMemoryBounds(addr, sizeof(t_val));
+		if(m_checks)
+			CheckCodeWrite(addr, sizeof(t_val));
 		*reinterpret_cast<t_val*>(&m_mem[addr]) = val;
+		MarkDirty(addr, sizeof(t_val));
+
+		if(m_breakpoints.size())
+			UpdateBreakpoints(addr, sizeof(t_val));
 	}
 
 
@@ -163,7 +226,10 @@ protected:
 		CheckMemoryBounds(m_sp, valsize);
 
 		m_sp -= valsize;	// stack grows to lower addresses
+		if(m_checks)
+			CheckCodeWrite(m_sp, valsize);
 		*reinterpret_cast<t_val*>(m_mem.get() + m_sp) = val;
+		MarkDirty(m_sp, valsize);
 
 		if(m_debug)
 		{
@@ -182,6 +248,15 @@ protected:
 	{
 		t_val result{};
 
+		// integer divisions which would trap in the host
+		if constexpr((op == '/' || op == '%') && std::is_integral_v<t_val>)
+		{
+			if(val2 == 0)
+				throw std::runtime_error("Integer division by zero.");
+			if(val1 == std::numeric_limits<t_val>::min() && val2 == -1)
+				throw std::runtime_error("Integer division overflow.");
+		}
+
 		if constexpr(op == '+')
 			result = val1 + val2;
 		else if constexpr(op == '-')
@@ -331,6 +406,87 @@ protected:
 	}
 
 
+	/**
+	 * read a variable at an immediate offset to a base register and push it
+	 */
+	template<class t_val>
+	void OpReadRelative(t_int base)
+	{
+		t_int addr = base + ReadMemRaw<t_offs>(m_ip);
+		m_ip += sizeof(t_offs);
+
+		t_val val = ReadMemRaw<t_val>(addr);
+		PushRaw<t_val>(val);
+	}
+
+
+	/**
+	 * pop a value and write it to a variable at an immediate offset to a base register
+	 */
+	template<class t_val>
+	void OpWriteRelative(t_int base)
+	{
+		t_int addr = base + ReadMemRaw<t_offs>(m_ip);
+		m_ip += sizeof(t_offs);
+
+		t_val val = PopRaw<t_val>();
+		WriteMemRaw<t_val>(addr, val);
+	}
+
+
+	/**
+	 * pop an index and push the array element at an immediate offset to a base register
+	 */
+	template<class t_val>
+	void OpReadIndexed(t_int base)
+	{
+		t_int addr = base + ReadMemRaw<t_offs>(m_ip);
+		m_ip += sizeof(t_offs);
+
+		t_int idx = PopRaw<t_int>();
+		t_val val = ReadMemRaw<t_val>(addr + idx*static_cast<t_int>(sizeof(t_val)));
+		PushRaw<t_val>(val);
+	}
+
+
+	/**
+	 * pop an index and a value and write it to the array element
+	 * at an immediate offset to a base register
+	 */
+	template<class t_val>
+	void OpWriteIndexed(t_int base)
+	{
+		t_int addr = base + ReadMemRaw<t_offs>(m_ip);
+		m_ip += sizeof(t_offs);
+
+		t_int idx = PopRaw<t_int>();
+		t_val val = PopRaw<t_val>();
+		WriteMemRaw<t_val>(addr + idx*static_cast<t_int>(sizeof(t_val)), val);
+	}
+
+
+	/**
+	 * pop a key and get the address of its entry in the memo table given after the instruction
+	 */
+	t_int PopMemoEntry(t_int& key)
+	{
+		t_int offs = ReadMemRaw<t_int>(m_ip);
+		m_ip += sizeof(t_int);
+		t_int num_entries = ReadMemRaw<t_int>(m_ip);
+		m_ip += sizeof(t_int);
+
+		if(num_entries <= 0)
+			throw std::runtime_error("Invalid memo table size.");
+
+		key = PopRaw<t_int>();
+		t_int idx = key % num_entries;
+		if(idx < 0)
+			idx += num_entries;
+
+		return m_hp + offs + idx*MEMO_ENTRY_SIZE;
+	}
+
+
 	/**
 	 * sets the address of an interrupt service routine
 	 */
@@ -341,23 +497,84 @@ protected:
 
 
 private:
+	template<bool single_step> bool Execute();
+	bool StepOverBreakpoint();
+	void UpdateBreakpoints(t_int addr, std::size_t size);
+
 	void CheckMemoryBounds(t_int addr, std::size_t size = 1) const;
 	void CheckPointerBounds() const;
+	void RecordEvent(ReplayEventType ty, t_int value);
+	void ReplayInterrupts();
 	void UpdateCodeRange(t_int begin, t_int end);
 
+	/**
+	 * rejects writes into the shared code,
+	 * the program's own writes are only checked if checks are enabled,
+	 * otherwise the read-only mapping of the shared code traps them
+	 */
+	void CheckCodeWrite(t_int addr, std::size_t size = 1) const
+	{
+		if(m_shared_code && addr < m_shared_code_range[1]
+			&& addr + t_int(size) > m_shared_code_range[0])
+			throw std::runtime_error("Tried to write into shared code.");
+	}
+
+	/**
+	 * marks a memory region as changed for the video output
+	 */
+	void MarkDirty(t_int addr, std::size_t size = 1)
+	{
+		if(!m_memvideo)
+			return;
+
+		for(std::size_t i=0; i<size; ++i)
+			m_memvideo_dirty[addr + i] = 1;
+
+		m_memvideo_dirty_range[0] = std::min(m_memvideo_dirty_range[0], addr);
+		m_memvideo_dirty_range[1] = std::max(m_memvideo_dirty_range[1], addr + t_int(size));
+	}
+
 	void TimerFunc();
 
 
+private:
+	/**
+	 * frees the vm memory, which is page-mapped when using shared code
+	 */
+	struct MemDeleter
+	{
+		std::size_t mapped_size;   // size of the mapping, 0 if allocated by new
+
+		void operator()(t_byte* mem) const
+		{
+			if(mapped_size)
+				CodeImage::FreeMemory(mem, mapped_size);
+			else
+				delete[] mem;
+		}
+	};
+
+
 private:
 	bool m_debug{false};               // write debug messages
 	bool m_checks{true};               // do memory boundary checks
 	bool m_drawmemimages{false};       // write memory dump images
 	bool m_zeropoppedvals{false};      // zero memory of popped values
+	bool m_halted{false};              // program has run a halt instruction
+	bool m_break_hit{false};           // stopped at a breakpoint
+	bool m_suspended{false};           // stopped at a breakpoint or after a single step
 	t_real m_eps{std::numeric_limits<t_real>::epsilon()};
 
-	std::unique_ptr<t_byte[]> m_mem{}; // ram
+	std::unique_ptr<t_byte[], MemDeleter> m_mem{}; // ram
 	t_int m_code_range[2]{-1, -1};     // address range where the code resides
 
+	// read-only code shared with other vm instances
+	std::shared_ptr<const CodeImage> m_shared_code{};
+	t_int m_shared_code_range[2]{-1, -1};
+
+	// breakpoint addresses and the original instructions replaced by break opcodes
+	std::unordered_map<t_int, t_byte> m_breakpoints{};
+
 	// registers
 	t_int m_ip{};                      // instruction pointer
 	t_int m_sp{};                      // stack pointer
@@ -379,9 +596,30 @@ private:
 	bool m_timer_running{false};
 	std::chrono::milliseconds m_timer_ticks{250};
 
+	// interrupt and input recording
+	bool m_recording{false};
+	std::ofstream m_record_ostr{};
+	std::size_t m_record_last_count{};       // instruction count of the last event
+
+	// interrupt and input replay
+	bool m_replaying{false};
+	std::vector<ReplayEvent> m_replay_events{};
+	std::size_t m_replay_idx{};              // next event to replay
+
+	// memory video
+	std::unique_ptr<MemVideo> m_memvideo{};
+	std::size_t m_memvideo_interval{1000};   // number of instructions between frames
+	std::size_t m_memvideo_scale{4};         // pixel size of one memory bit
+	MemVideo::t_frame m_memvideo_frame{};    // current frame as y, u, and v planes
+	std::vector<t_byte> m_memvideo_dirty{};  // changed memory bytes since last frame
+	t_int m_memvideo_dirty_range[2]{0, 0};   // range of changed bytes
+	t_int m_memvideo_regs[3]{-1, -1, -1};    // ip, sp, and bp in the last frame
+
 	// runtime statistics
 	std::size_t m_num_ops_run{};
 	std::unordered_map<OpCode, std::size_t> m_ops_run{};
+	std::size_t m_memo_hits{};               // results found in the memo tables
+	std::size_t m_memo_misses{};             // results not found in the memo tables
 };
 
 
@@ -92,3 +92,122 @@ void VM::DrawMemoryImage()
 }
 
 #endif
+
+
+
+/**
+ * starts writing a memory video to a y4m file or encoder pipe
+ */
+void VM::SetMemVideo(const std::string& file, std::size_t interval, std::size_t fps)
+{
+	CloseMemVideo();
+
+	std::size_t length = static_cast<std::size_t>(
+		std::ceil(std::sqrt(static_cast<t_real>(m_memsize * 8))));
+	length *= m_memvideo_scale;
+
+	m_memvideo_interval = std::max<std::size_t>(interval, 1);
+	m_memvideo = std::make_unique<MemVideo>(file, length, length, fps);
+	m_memvideo_frame.resize(length * length * 3);
+	m_memvideo_dirty.resize(m_memsize);
+	m_memvideo_regs[0] = m_memvideo_regs[1] = m_memvideo_regs[2] = -1;
+
+	// the first frame needs to be rendered completely
+	std::fill(m_memvideo_frame.begin(), m_memvideo_frame.end(), 0);
+	MarkDirty(0, m_memsize);
+}
+
+
+/**
+ * writes the remaining video frames and closes the stream
+ */
+void VM::CloseMemVideo()
+{
+	if(!m_memvideo)
+		return;
+
+	m_memvideo->Close();
+	m_memvideo.reset();
+	m_memvideo_frame.clear();
+	m_memvideo_dirty.clear();
+}
+
+
+/**
+ * renders the changed memory regions into the next video frame
+ */
+void VM::DrawMemoryVideoFrame()
+{
+	// yuv values for the eight possible rgb combinations
+	static const t_byte yuv_cols[8][3] =
+	{
+		{ 0x00, 0x80, 0x80 },  // black
+		{ 0x1d, 0xff, 0x6b },  // blue
+		{ 0x96, 0x2c, 0x15 },  // green
+		{ 0xb3, 0xab, 0x00 },  // green + blue
+		{ 0x4c, 0x55, 0xff },  // red
+		{ 0x69, 0xd4, 0xea },  // red + blue
+		{ 0xe2, 0x00, 0x94 },  // red + green
+		{ 0xff, 0x80, 0x80 },  // white
+	};
+
+	// the register markers also need to be redrawn if they moved
+	auto mark_reg = [this](t_int old_reg, t_int new_reg)
+	{
+		if(old_reg < 0)
+			return;
+
+		t_int begin = std::clamp<t_int>(std::min(old_reg, new_reg), 0, m_memsize - 1);
+		t_int end = std::clamp<t_int>(std::max(old_reg, new_reg), 0, m_memsize - 1);
+		MarkDirty(begin, end - begin + 1);
+	};
+
+	mark_reg(m_memvideo_regs[0], m_ip);
+	mark_reg(m_memvideo_regs[1], m_sp);
+	mark_reg(m_memvideo_regs[2], m_bp);
+	m_memvideo_regs[0] = m_ip;
+	m_memvideo_regs[1] = m_sp;
+	m_memvideo_regs[2] = m_bp;
+
+	const std::size_t scale = m_memvideo_scale;
+	const std::size_t width = m_memvideo->GetWidth();
+	const std::size_t cols = width / scale;
+	const std::size_t plane_size = width * m_memvideo->GetHeight();
+
+	t_int begin = std::max<t_int>(m_memvideo_dirty_range[0], 0);
+	t_int end = std::min<t_int>(m_memvideo_dirty_range[1], m_memsize);
+
+	// only redraw the pixels of changed memory bytes
+	for(t_int mem_byte = begin; mem_byte < end; ++mem_byte)
+	{
+		if(!m_memvideo_dirty[mem_byte])
+			continue;
+		m_memvideo_dirty[mem_byte] = 0;
+
+		bool is_ip = (mem_byte == m_ip);
+		bool is_frame = (mem_byte >= m_sp && mem_byte <= m_bp);
+
+		for(std::size_t mem_bit = 0; mem_bit < 8; ++mem_bit)
+		{
+			bool thebit = (m_mem[mem_byte] & (1 << (8-mem_bit-1))) != 0;
+			const t_byte *col = yuv_cols[(thebit << 2) | (is_ip << 1) | is_frame];
+
+			std::size_t mem_pos = static_cast<std::size_t>(mem_byte)*8 + mem_bit;
+			std::size_t x0 = (mem_pos % cols) * scale;
+			std::size_t y0 = (mem_pos / cols) * scale;
+
+			for(std::size_t y = y0; y < y0 + scale; ++y)
+			{
+				std::size_t row = y*width + x0;
+				for(std::size_t plane = 0; plane < 3; ++plane)
+					std::memset(m_memvideo_frame.data() + plane*plane_size + row, col[plane], scale);
+			}
+		}
+	}
+
+	// nothing dirty any more
+	m_memvideo_dirty_range[0] = m_memsize;
+	m_memvideo_dirty_range[1] = 0;
+
+	m_memvideo->PushFrame(m_memvideo_frame);
+}
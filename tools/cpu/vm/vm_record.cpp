@@ -0,0 +1,197 @@
+/**
+ * deterministic recording and replay of interrupts and external inputs
+ * @author Tobias Weber (orcid: 0000-0002-7230-1932)
+ * @date 18-oct-2026
+ * @license see 'LICENSE' file
+ */
+
+#include "vm.h"
+
+#include <fstream>
+#include <iterator>
+
+
+/**
+ * log file format:
+ *   header: magic "0ACR" and a version byte,
+ *   events: instruction count difference to the previous event (as leb128 varint),
+ *           event type byte,
+ *           interrupt number byte or input value (t_int, little endian)
+ */
+static constexpr const char g_replay_magic[] = { '0', 'A', 'C', 'R' };
+static constexpr const t_byte g_replay_version = 1;
+
+
+/**
+ * starts logging the interrupts and inputs to a file
+ */
+void VM::StartRecording(const std::string& file)
+{
+	StopRecording();
+
+	m_record_ostr.open(file, std::ios_base::binary);
+	if(!m_record_ostr)
+		throw std::runtime_error("Cannot open record log \"" + file + "\".");
+
+	m_record_ostr.write(g_replay_magic, sizeof(g_replay_magic));
+	m_record_ostr.put(static_cast<char>(g_replay_version));
+
+	m_record_last_count = m_num_ops_run;
+	m_recording = true;
+}
+
+
+void VM::StopRecording()
+{
+	m_recording = false;
+	if(m_record_ostr.is_open())
+		m_record_ostr.close();
+}
+
+
+/**
+ * loads a log file and injects its events at the recorded instruction counts,
+ * asynchronous interrupt requests are ignored while replaying
+ */
+void VM::StartReplay(const std::string& file)
+{
+	std::ifstream ifstr(file, std::ios_base::binary);
+	if(!ifstr)
+		throw std::runtime_error("Cannot open replay log \"" + file + "\".");
+
+	std::vector<t_byte> data{std::istreambuf_iterator<char>(ifstr),
+		std::istreambuf_iterator<char>()};
+
+	if(data.size() < sizeof(g_replay_magic) + 1 ||
+		!std::equal(std::begin(g_replay_magic), std::end(g_replay_magic), data.begin()) ||
+		data[sizeof(g_replay_magic)] != g_replay_version)
+		throw std::runtime_error("Invalid replay log \"" + file + "\".");
+
+	m_replay_events.clear();
+	m_replay_idx = 0;
+
+	std::size_t pos = sizeof(g_replay_magic) + 1;
+	std::size_t count = m_num_ops_run;
+
+	auto read_byte = [&data, &pos, &file]() -> t_byte
+	{
+		if(pos >= data.size())
+			throw std::runtime_error("Truncated replay log \"" + file + "\".");
+		return data[pos++];
+	};
+
+	while(pos < data.size())
+	{
+		// instruction count difference
+		std::size_t delta = 0;
+		for(std::size_t shift = 0; ; shift += 7)
+		{
+			t_byte b = read_byte();
+			delta |= std::size_t(b & 0x7f) << shift;
+			if(!(b & 0x80))
+				break;
+		}
+		count += delta;
+
+		ReplayEvent evt{ .op_count = count, .type = static_cast<ReplayEventType>(read_byte()), .value = 0 };
+		if(evt.type == ReplayEventType::INTERRUPT)
+		{
+			evt.value = read_byte();
+			if(evt.value >= m_num_interrupts)
+				throw std::runtime_error("Invalid interrupt number in replay log \"" + file + "\".");
+		}
+		else
+		{
+			t_uint val = 0;
+			for(std::size_t i = 0; i < sizeof(t_int); ++i)
+				val |= t_uint(read_byte()) << (i*8);
+			evt.value = static_cast<t_int>(val);
+		}
+
+		m_replay_events.push_back(evt);
+	}
+
+	m_replaying = true;
+}
+
+
+void VM::StopReplay()
+{
+	m_replaying = false;
+	m_replay_events.clear();
+	m_replay_idx = 0;
+}
+
+
+/**
+ * writes an event at the current instruction count to the log
+ */
+void VM::RecordEvent(ReplayEventType ty, t_int value)
+{
+	std::size_t delta = m_num_ops_run - m_record_last_count;
+	m_record_last_count = m_num_ops_run;
+
+	do
+	{
+		t_byte b = delta & 0x7f;
+		delta >>= 7;
+		if(delta)
+			b |= 0x80;
+		m_record_ostr.put(static_cast<char>(b));
+	}
+	while(delta);
+
+	m_record_ostr.put(static_cast<char>(ty));
+
+	if(ty == ReplayEventType::INTERRUPT)
+	{
+		m_record_ostr.put(static_cast<char>(value));
+	}
+	else
+	{
+		t_uint val = static_cast<t_uint>(value);
+		for(std::size_t i = 0; i < sizeof(t_int); ++i)
+			m_record_ostr.put(static_cast<char>((val >> (i*8)) & 0xff));
+	}
+}
+
+
+/**
+ * requests the interrupts recorded for the current instruction count
+ */
+void VM::ReplayInterrupts()
+{
+	while(m_replay_idx < m_replay_events.size())
+	{
+		const ReplayEvent& evt = m_replay_events[m_replay_idx];
+		if(evt.op_count != m_num_ops_run || evt.type != ReplayEventType::INTERRUPT)
+			break;
+
+		m_irqs[evt.value] = true;
+		++m_replay_idx;
+	}
+}
+
+
+/**
+ * logs an external input value or, when replaying, returns the recorded one,
+ * to be used for all results obtained from the host
+ */
+t_int VM::RecordInput(t_int value)
+{
+	if(m_recording)
+	{
+		RecordEvent(ReplayEventType::INPUT, value);
+	}
+	else if(m_replaying)
+	{
+		if(m_replay_idx >= m_replay_events.size() ||
+			m_replay_events[m_replay_idx].type != ReplayEventType::INPUT ||
+			m_replay_events[m_replay_idx].op_count != m_num_ops_run)
+			throw std::runtime_error("Program execution diverges from the replay log.");
+
+		value = m_replay_events[m_replay_idx++].value;
+	}
+
+	return value;
+}
@@ -10,6 +10,7 @@
 
 /**
  * call software interrupt functions
+ * (results obtained from the host have to pass through RecordInput)
  */
 void VM::CallSoftInt()
 {